@@ -2,10 +2,99 @@
 #define CONSTANT_H
 
 #include <cstdint>
+#include <cstddef>
 
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
 
-const int MAX_FRAMES_IN_FLIGHT = 2; // 2 because we dont want the CPU to get too far ahead of the GPU.
+// Number of frame slots (command buffers, uniform buffers, semaphores...). How many are actually used depends on the
+// frame pacing mode (see FramePacer): all of them in throughput mode, a single one in latency mode
+const int MAX_FRAMES_IN_FLIGHT = 3;
+
+// Frame pacing policy at startup, P switches at runtime
+const bool START_IN_LATENCY_MODE = false;
+const double LATENCY_MODE_TARGET_FPS = 60.0; // Frame limiter of the latency mode, 0 to only rely on FIFO
+const bool LOG_FRAME_LATENCY = false; // Print the input-to-submit latency of every frame, a summary is printed with the profiler report otherwise
+
+// Size of the global bindless tables (see BindlessTextureSet). Clamped at runtime to the device update-after-bind limits.
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;
+const uint32_t MAX_BINDLESS_SAMPLERS = 16;
+
+// Re-submit pre-recorded command buffers while the scene, the swap chain and the pipeline don't change (see CommandBufferCache)
+// This disables the push constant path: per-draw data then goes through the per-object uniform buffer instead of push
+// constants, which would be baked in the command buffer. Off by default, frames are recorded every frame with push constants
+const bool REUSE_COMMAND_BUFFERS = false;
+
+// Only produce a frame when something invalidated the image (scene, camera, animation, resize), sleep in glfwWaitEventsTimeout otherwise
+// Rendering is suspended entirely while the window is minimized or hidden
+const bool RENDER_ON_DEMAND = true;
+const double IDLE_WAIT_TIMEOUT = 0.25; // Seconds, the loop still wakes up regularly to report and check the invalidation sources
+const double PROFILER_REPORT_INTERVAL = 5.0; // Seconds between two CPU/GPU usage reports (see Profiler), 0 to disable
+
+// Per-frame linear arena for transient CPU data (see LinearAllocator)
+const size_t FRAME_ARENA_SIZE = 256 * 1024;
+// Debug builds: throw if drawFrame allocates on the heap once the frame loop reached its steady state
+// (after STEADY_STATE_WARMUP_FRAMES frames without swap chain recreation)
+const bool CHECK_FRAME_ALLOCATIONS = true;
+const uint32_t STEADY_STATE_WARMUP_FRAMES = 16;
+
+// Route the host allocations of the driver through HostAllocator to track them by object type and scope
+const bool TRACK_HOST_ALLOCATIONS = true;
+// Serve command scope allocations (temporary to a single Vulkan call) from a thread-local pool instead of malloc
+const bool POOL_COMMAND_SCOPE_ALLOCATIONS = true;
+
+// Draw the scene depth-only first, then shade with an EQUAL depth test so each pixel runs the fragment shader once
+// Toggled at runtime with Z, the Profiler reports the fragment shader invocations per frame to compare
+const bool START_WITH_DEPTH_PREPASS = true;
+
+// Cull the objects hidden behind others on the GPU against a Hi-Z pyramid of the depth buffer (see OcclusionCuller)
+// Toggled at runtime with O, the Profiler reports the input assembly primitives per frame to compare
+const bool START_WITH_OCCLUSION_CULLING = true;
+
+// Test the bounds of every object against the view frustum on the CPU (see ObjectStore), only the visible ones are recorded
+const bool CPU_FRUSTUM_CULLING = true;
+// Walk a BVH of the object bounds (see BVH) instead of testing every object, subtrees outside the frustum are skipped
+const bool BVH_FRUSTUM_CULLING = true;
+// Worker threads of the ThreadPool used by the data-parallel loops of the mesh import, 0 for one per hardware thread but the main one
+const uint32_t WORKER_THREAD_COUNT = 0;
+
+// Camera projection, shared by the vertex shaders (frame UBO) and the occlusion culling
+const float CAMERA_FOV_DEGREES = 45.0f;
+const float CAMERA_NEAR_PLANE = 0.1f;
+const float CAMERA_FAR_PLANE = 10.0f;
+
+// Validation messages are queued by the debug callback and printed by a background thread (see ValidationMessageSink)
+const uint32_t VALIDATION_SINK_CAPACITY = 256; // Messages waiting to be printed, a power of two. Messages are dropped (and counted) when full
+const uint32_t VALIDATION_MESSAGES_PER_ID = 3; // Occurrences of the same message printed, the next ones are only counted
+const uint32_t VALIDATION_LINES_PER_SECOND = 20; // Global rate limit of the printed messages
+const uint32_t MAX_VALIDATION_MESSAGE_IDS = 256; // Distinct message ids counted for the summary
+
+// Mesh drawn by every object, an OBJ, glTF or GLB file (see MeshImporter). The textured quad is drawn when the file is missing
+const char* const MODEL_PATH = "models/model.obj";
+// Save the processed mesh to MESH_CACHE_DIRECTORY and map it on the next launches instead of importing it again (see MeshCache).
+// The cache file is rebuilt when the model, the mesh settings below or the vertex layouts change
+const bool USE_MESH_CACHE = true;
+const char* const MESH_CACHE_DIRECTORY = "cache";
+// Reorder the imported mesh for the vertex cache, overdraw and vertex fetches (see MeshOptimizer), the ACMR/ATVR are printed
+const bool OPTIMIZE_MESHES = true;
+// Simplify the imported mesh into a chain of LODs (see MeshSimplifier), each object is drawn with the coarsest LOD whose
+// error on screen stays under the threshold (see LodSelector). Toggled at runtime with L, the submitted triangles are printed
+const bool GENERATE_LODS = true;
+const bool START_WITH_LODS = true;
+const float LOD_ERROR_THRESHOLD_PIXELS = 1.0f;
+const float LOD_HYSTERESIS = 0.25f; // Fraction of the threshold the error must cross to switch, so that LODs don't flicker
+// Split LOD 0 of large meshes into meshlets (see MeshletBuilder), a compute pass culls the meshlets of the objects drawn at
+// LOD 0 against the frustum, their normal cones and the Hi-Z pyramid (see ClusterCuller). Needs the occlusion culling.
+// Toggled at runtime with M. With indirect draws, the input assembly primitives of the Profiler show the culled triangles.
+// Mesh shaders bypass the input assembly: their primitives are only counted by a VK_QUERY_TYPE_MESH_PRIMITIVES_GENERATED_EXT
+// query (meshShaderQueries), which the Profiler doesn't issue, so compare the GPU times instead
+const bool START_WITH_CLUSTER_CULLING = true;
+// Draw the surviving meshlets with task and mesh shaders when VK_EXT_mesh_shader is supported, instead of indirect draws
+const bool USE_MESH_SHADERS = true;
+
+// Capacity of the per-object buffers (one model matrix per object and per frame in flight)
+const uint32_t MAX_OBJECTS = 1024;
+// Size of the material table (set 1), must match MAX_MATERIALS in shader.frag
+const uint32_t MAX_MATERIALS = 256;
 
 #endif // CONSTANT_H
\ No newline at end of file
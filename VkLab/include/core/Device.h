@@ -3,6 +3,7 @@
 
 #include "core/RendererContext.h"
 #include "core/VulkanInstance.h"
+#include "core/DispatchTable.h"
 
 #include <vulkan/vulkan.h>
 #include <iostream>
@@ -12,7 +13,21 @@
 
 // List all needed device extensions
 const std::vector<const char*> deviceExtensions = {
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME // Bindless textures (requires Vulkan 1.1 or VK_KHR_maintenance3)
+};
+
+// Optional extensions of the mesh shader path (see ClusterCuller), only enabled together when the device supports all of them
+// Mesh shaders need SPIR-V 1.4, which Vulkan 1.1 only accepts through these two extensions
+const std::vector<const char*> meshShaderExtensions = {
+    VK_EXT_MESH_SHADER_EXTENSION_NAME,
+    VK_KHR_SPIRV_1_4_EXTENSION_NAME,
+    VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME
+};
+
+// Optional extension of the cluster culling without mesh shaders: the GPU writes the number of meshlet draws (core in Vulkan 1.2)
+const std::vector<const char*> drawIndirectCountExtensions = {
+    VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
 };
 
 // Struct used to store QueueFamily indices
@@ -46,6 +61,16 @@ public:
 	VkQueue getGraphicsQueue();
 	VkQueue getPresentQueue();
 	VkQueue getTransferQueue();
+	const DeviceDispatch& getDispatch(); // Direct entry points for the hot paths
+
+	// Queried once when the physical device is picked, they never change afterwards
+	const QueueFamilyIndices& getQueueFamilyIndices();
+	const VkPhysicalDeviceProperties& getProperties();
+	const VkPhysicalDeviceMemoryProperties& getMemoryProperties();
+	const VkPhysicalDeviceFeatures& getEnabledFeatures(); // Core features enabled at device creation
+	bool hasMeshShaders(); // Task and mesh shaders enabled (USE_MESH_SHADERS and supported)
+	bool hasDrawIndirectCount(); // VK_KHR_draw_indirect_count enabled (supported)
+	const std::vector<VkQueueFamilyProperties>& getQueueFamilyProperties();
 
 private:
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
@@ -55,12 +80,24 @@ private:
 	VkQueue graphicsQueue = VK_NULL_HANDLE;
 	VkQueue presentQueue = VK_NULL_HANDLE;
 	VkQueue transferQueue = VK_NULL_HANDLE;
+
+	DeviceDispatch dispatch;
+
+	QueueFamilyIndices queueFamilyIndices;
+	VkPhysicalDeviceProperties properties{};
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	VkPhysicalDeviceFeatures enabledFeatures{};
+	bool meshShadersEnabled = false;
+	bool drawIndirectCountEnabled = false;
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties;
 };
 
 // Device selection functions
 bool isDeviceSuitable(VkPhysicalDevice physicalDevice);
 QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice);
-bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<const char*>& extensions = deviceExtensions);
+bool checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice);
+bool checkMeshShaderSupport(VkPhysicalDevice physicalDevice);
 SwapChainSupportDetails querySwapChainSupport(const VkPhysicalDevice device, const VkSurfaceKHR psurface);
 
 #endif // DEVICE_H
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef DISPATCH_TABLE_H
+#define DISPATCH_TABLE_H
+
+#include <vulkan/vulkan.h>
+#include <stdexcept>
+
+// Calling the vk* functions exported by the loader goes through a trampoline that looks up the dispatch table of the
+// device (or instance) in the handle before jumping to the driver. Entry points queried with vkGetDeviceProcAddr point
+// directly to the driver (or the first enabled layer), so the hot paths call the functions below instead.
+// Extension entry points, which the loader may not export at all, are loaded the same way.
+
+// Device functions used every frame (command recording, compute, submission, presentation) and by the buffer uploads.
+// The per-frame buffers are persistently mapped (see BufferManager), so mapping is not part of the frame
+#define VKLAB_DEVICE_FUNCTIONS(X) \
+	X(vkBeginCommandBuffer) \
+	X(vkEndCommandBuffer) \
+	X(vkResetCommandBuffer) \
+	X(vkCmdBeginRenderPass) \
+	X(vkCmdEndRenderPass) \
+	X(vkCmdBindPipeline) \
+	X(vkCmdBindVertexBuffers) \
+	X(vkCmdBindIndexBuffer) \
+	X(vkCmdBindDescriptorSets) \
+	X(vkCmdSetViewport) \
+	X(vkCmdSetScissor) \
+	X(vkCmdPushConstants) \
+	X(vkCmdDrawIndexed) \
+	X(vkCmdDrawIndexedIndirect) \
+	X(vkCmdDispatch) \
+	X(vkCmdPipelineBarrier) \
+	X(vkCmdCopyBuffer) \
+	X(vkCmdFillBuffer) \
+	X(vkCmdCopyBufferToImage) \
+	X(vkCmdResetQueryPool) \
+	X(vkCmdWriteTimestamp) \
+	X(vkCmdBeginQuery) \
+	X(vkCmdEndQuery) \
+	X(vkGetQueryPoolResults) \
+	X(vkWaitForFences) \
+	X(vkResetFences) \
+	X(vkQueueSubmit) \
+	X(vkResetDescriptorPool) \
+	X(vkAcquireNextImageKHR) \
+	X(vkQueuePresentKHR)
+
+// Device functions of the optional mesh shader path (see Device::hasMeshShaders)
+#define VKLAB_MESH_SHADER_FUNCTIONS(X) \
+	X(vkCmdDrawMeshTasksEXT)
+
+// Device functions of VK_KHR_draw_indirect_count (see Device::hasDrawIndirectCount)
+#define VKLAB_DRAW_INDIRECT_COUNT_FUNCTIONS(X) \
+	X(vkCmdDrawIndexedIndirectCountKHR)
+
+// Instance extension functions
+#define VKLAB_INSTANCE_EXTENSION_FUNCTIONS(X) \
+	X(vkCreateDebugUtilsMessengerEXT) \
+	X(vkDestroyDebugUtilsMessengerEXT)
+
+#define VKLAB_DECLARE_FUNCTION(name) PFN_##name name = nullptr;
+
+// The functions of the optional extensions stay null when they are not enabled
+struct DeviceDispatch {
+	VKLAB_DEVICE_FUNCTIONS(VKLAB_DECLARE_FUNCTION)
+	VKLAB_MESH_SHADER_FUNCTIONS(VKLAB_DECLARE_FUNCTION)
+	VKLAB_DRAW_INDIRECT_COUNT_FUNCTIONS(VKLAB_DECLARE_FUNCTION)
+
+	void load(VkDevice device, bool meshShaders, bool drawIndirectCount); // After the logical device creation
+};
+
+// Functions of extensions that are not enabled stay null
+struct InstanceDispatch {
+	VKLAB_INSTANCE_EXTENSION_FUNCTIONS(VKLAB_DECLARE_FUNCTION)
+
+	void load(VkInstance instance);
+};
+
+#undef VKLAB_DECLARE_FUNCTION
+
+#endif // DISPATCH_TABLE_H
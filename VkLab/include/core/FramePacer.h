@@ -0,0 +1,57 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "core/Constant.h"
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <vector>
+#include <iostream>
+
+// THROUGHPUT: MAILBOX/IMMEDIATE present mode and every frame slot in use, the CPU can queue up to MAX_FRAMES_IN_FLIGHT frames
+// LATENCY: FIFO and a single frame in flight, the frame limiter starts each frame as late as possible and input is sampled
+// right before the uniform buffers are written, so what is displayed is as recent as possible
+enum class PacingMode {
+	THROUGHPUT,
+	LATENCY
+};
+
+// Frame pacing policy of the main loop, and input-to-submit latency measurement
+class FramePacer
+{
+public:
+	void initialize(PacingMode pacingMode);
+	PacingMode getMode();
+	void setMode(PacingMode pacingMode);
+	uint32_t getFramesInFlight();
+	std::vector<VkPresentModeKHR> getPresentModePreference(); // Most wanted first, FIFO is always supported
+
+	void waitForNextFrame(); // Frame limiter of the latency mode, returns immediately in throughput mode
+	void markInputSampled();
+	void markSubmitted();
+	void update(); // Prints the latency report every PROFILER_REPORT_INTERVAL seconds
+	void report();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void preciseSleepUntil(Clock::time_point deadline);
+
+	PacingMode mode = PacingMode::THROUGHPUT;
+	Clock::time_point nextFrameStart;
+
+	// Running estimate of how long a 1 ms sleep really takes (mean + standard deviation, Welford's algorithm)
+	double sleepEstimate = 5e-3; // Seconds, pessimistic until measured
+	double sleepMean = 5e-3;
+	double sleepM2 = 0.0;
+	uint64_t sleepCount = 1;
+
+	// Input-to-submit latency
+	Clock::time_point inputSampleTime;
+	Clock::time_point intervalStart;
+	double latencySum = 0.0; // Seconds
+	double latencyMax = 0.0;
+	uint32_t latencyCount = 0;
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,67 @@
+#ifndef HOST_ALLOCATOR_H
+#define HOST_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// VkAllocationCallbacks used for every vkCreate*/vkAllocate* call, to see the host memory used by the driver.
+// Vulkan doesn't tell the allocation callbacks which object an allocation is for, so every object type gets its own
+// VkAllocationCallbacks whose pUserData points to the statistics of that type. The statistics are also split by scope.
+// Short-lived VK_SYSTEM_ALLOCATION_SCOPE_COMMAND allocations (freed before the command returns) can be served
+// by a thread-local bump pool instead of malloc (see POOL_COMMAND_SCOPE_ALLOCATIONS).
+class HostAllocator
+{
+public:
+	static constexpr uint32_t SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+	struct ScopeStats {
+		uint64_t allocations = 0; // Including reallocations
+		uint64_t frees = 0;
+		uint64_t liveBytes = 0;
+		uint64_t peakBytes = 0;
+		uint64_t internalBytes = 0; // Reported through the internal allocation notifications (executable memory...)
+		uint64_t pooled = 0; // Allocations served by the thread-local command pool
+	};
+
+	const VkAllocationCallbacks* getCallbacks(VkObjectType objectType);
+	std::array<ScopeStats, SCOPE_COUNT> getTotals(); // Sum over every object type
+	void printStats(); // Per object type and scope
+
+private:
+	static constexpr uint32_t MAX_OBJECT_TYPES = 48;
+
+	struct AtomicScopeStats {
+		std::atomic<uint64_t> allocations{ 0 };
+		std::atomic<uint64_t> frees{ 0 };
+		std::atomic<uint64_t> liveBytes{ 0 };
+		std::atomic<uint64_t> peakBytes{ 0 };
+		std::atomic<uint64_t> internalBytes{ 0 };
+		std::atomic<uint64_t> pooled{ 0 };
+	};
+
+	// One per object type, its address is the pUserData of its callbacks
+	struct TypeSlot {
+		VkObjectType objectType = VK_OBJECT_TYPE_UNKNOWN;
+		VkAllocationCallbacks callbacks{};
+		std::array<AtomicScopeStats, SCOPE_COUNT> scopes;
+	};
+
+	static void* VKAPI_CALL allocation(void* puserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+	static void* VKAPI_CALL reallocation(void* puserData, void* poriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
+	static void VKAPI_CALL deallocation(void* puserData, void* pmemory);
+	static void VKAPI_CALL internalAllocation(void* puserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+	static void VKAPI_CALL internalFree(void* puserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
+
+	std::mutex slotMutex; // Objects may be created from several threads
+	std::array<TypeSlot, MAX_OBJECT_TYPES> slots;
+	uint32_t slotCount = 0;
+};
+
+// Callbacks to pass to vkCreate*/vkDestroy*/vkAllocateMemory/vkFreeMemory for an object of the given type,
+// nullptr (driver allocator) when TRACK_HOST_ALLOCATIONS is disabled. Destroy with the same type as the creation.
+const VkAllocationCallbacks* getAllocationCallbacks(VkObjectType objectType);
+
+#endif // HOST_ALLOCATOR_H
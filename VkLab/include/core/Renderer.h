@@ -5,41 +5,81 @@
 #include "core/Constant.h"
 #include "core/VulkanInstance.h"
 #include "core/Device.h"
+#include "core/FramePacer.h"
 #include "graphics/Swapchain.h"
 #include "graphics/ImageViews.h"
+#include "graphics/DepthBuffer.h"
 #include "graphics/Pipeline.h"
 #include "graphics/RenderPass.h"
 #include "graphics/FrameBuffers.h"
 #include "graphics/CommandPools.h"
 #include "graphics/CommandBuffers.h"
+#include "graphics/CommandBufferCache.h"
+#include "graphics/ComputePipeline.h"
+#include "graphics/HiZPyramid.h"
+#include "graphics/OcclusionCuller.h"
+#include "graphics/ClusterCuller.h"
 #include "graphics/TextureImage.h"
 #include "graphics/BufferManager.h"
 #include "graphics/DescriptorSet.h"
-#include "graphics/DescriptorPool.h"
+#include "graphics/DescriptorAllocator.h"
+#include "graphics/DescriptorLayoutCache.h"
+#include "graphics/BindlessTextureSet.h"
+#include "scene/Scene.h"
+#include "scene/MeshImporter.h"
+#include "scene/MeshOptimizer.h"
+#include "scene/MeshSimplifier.h"
+#include "scene/MeshletBuilder.h"
+#include "scene/MeshCache.h"
+#include "scene/LodSelector.h"
+#include "scene/ObjectStore.h"
+#include "scene/BVH.h"
+#include "utils/Profiler.h"
+#include "utils/LinearAllocator.h"
+#include "utils/AllocationCounter.h"
+#include "utils/ThreadPool.h"
+#include "utils/StartupTimeline.h"
+#include "utils/ValidationMessageSink.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include <iostream>
 #include <vector>
+#include <array>
+#include <filesystem>
+#include <future>
+#include <limits>
 #include <optional>
 #include <set>
+#include <span>
 
 class Renderer {
 public:
     void run();
 
+    void requestRedraw();
+    void handleKey(int key, int action);
+
     bool framebufferResized = false; // Handle resize explicitly
 
 private:
     void initWindow();
     void initVulkan();
     void mainLoop();
+    bool isSuspended();
+    bool needsRedraw();
+    void applyPacingMode();
+    void checkFrameAllocations(uint64_t allocationsBefore);
     void cleanup();
 
     // Vulkan-specific methods
     void createSurface();
     void drawFrame();
+    void cullObjects();
+    void buildDrawList();
+    void recordFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    ClusterCuller* getClusterCuller(); // nullptr when the meshlets are not culled this frame
     void createSyncObjects();
 
     void cleanupSwapChain();
@@ -48,6 +88,8 @@ private:
     // Vulkan resources
     GLFWwindow* window;
 
+    HostAllocator r_hostallocator; // Outlives every Vulkan object
+    ValidationMessageSink r_validationsink; // Outlives the instance, whose messengers report to it
     VulkanInstance r_instance;
 
     DebugMessenger r_debugMessenger;
@@ -56,23 +98,60 @@ private:
 
     SwapChain r_swapchain;
     ImageViews r_imageviews;
+    DepthBuffer r_depthbuffer; // Recreated with the swap chain
     Pipeline r_pipeline;
     RenderPass r_renderpass;
-    DescriptorPool r_descriptorpool;
+    DescriptorLayoutCache r_layoutcache;
+    DescriptorAllocator r_descriptorallocator; // Sets living as long as the renderer
+    std::array<LinearAllocator, MAX_FRAMES_IN_FLIGHT> r_framearenas; // Transient CPU data, reset every frame
     DescriptorSet r_descriptorset;
+    BindlessTextureSet r_bindlesstextures;
     FrameBuffers r_framebuffer;
     CommandPools r_commandpools;
     TextureImage r_textureimage;
     BufferManager r_buffermanager;
-    CommandBuffers r_commandbuffers;
+    CommandBuffers r_commandbuffers; // Only used without REUSE_COMMAND_BUFFERS
+    Scene r_scene;
+    ObjectStore r_objectstore; // World bounds of the scene objects, for the CPU frustum culling
+    BVH r_bvh; // Over r_objectstore, rebuilt when objects are added or the refits degraded it
+    LodSelector r_lodselector; // LOD of each visible object, enabled with START_WITH_LODS and toggled with L
+    ThreadPool r_threadpool;
+    DrawList r_drawlist;
+    CommandRecorder r_commandrecorder;
+    CommandBufferCache r_commandbuffercache; // Only used with REUSE_COMMAND_BUFFERS
+    HiZPyramid r_hizpyramid; // Its image is recreated with the swap chain
+    OcclusionCuller r_occlusionculler;
+    ClusterCuller r_clusterculler; // Meshlets of the objects at LOD 0, enabled with START_WITH_CLUSTER_CULLING and toggled with M
+    Profiler r_profiler;
+    FramePacer r_framepacer;
+    StartupTimeline r_startuptimeline;
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
 
+    // Objects that passed the frustum culling of the current frame, in scene order (tree order with the BVH)
+    std::vector<uint32_t> visibleObjects; // MAX_OBJECTS entries, the first visibleObjectCount are valid
+    uint32_t visibleObjectCount = 0;
+    uint64_t visibleSetHash = 0; // Decides whether recorded command buffers still draw the right objects
+    uint64_t culledSceneVersion = UINT64_MAX; // Scene version of the bounds in r_objectstore and of r_bvh
+
     uint32_t currentFrame = 0;
+    bool pacingModeChangeRequested = false;
+    bool depthPrepassEnabled = START_WITH_DEPTH_PREPASS; // Toggled with Z
+    bool occlusionCullingEnabled = START_WITH_OCCLUSION_CULLING; // Toggled with O
+    uint32_t steadyFrameCount = 0; // Frames drawn since the last swap chain recreation
+    uint64_t swapchainGeneration = 0; // Incremented when the swap chain is recreated
+
+    // Invalidation state of the on-demand loop: what the last presented frame was made of
+    bool redrawRequested = true;
+    uint64_t drawnSceneVersion = ~0ull;
+    uint64_t drawnViewVersion = ~0ull;
 };
 
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+static void windowRefreshCallback(GLFWwindow* window);
+static void windowIconifyCallback(GLFWwindow* window, int iconified);
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 #endif // RENDERER_H
\ No newline at end of file
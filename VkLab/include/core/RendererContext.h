@@ -2,10 +2,12 @@
 #define RENDERER_CONTEXT_H
 
 #include "core/Device.h"
+#include "core/HostAllocator.h"
 
 #include <vulkan/vulkan.h>
 
 class Device;
+class ValidationMessageSink;
 
 class RendererContext {
 public:
@@ -25,6 +27,8 @@ public:
     // Shared Vulkan resources
     VkSurfaceKHR surface = VK_NULL_HANDLE; // Vulkan rendering surface
     Device* pdevice = nullptr; // Physical device and logical device used by the application
+    HostAllocator* phostallocator = nullptr; // Allocation callbacks of every Vulkan object, null to use the driver allocator
+    ValidationMessageSink* pvalidationsink = nullptr; // Queue of the debug callback messages, null to print them from the callback
 
 private:
     // Private constructor
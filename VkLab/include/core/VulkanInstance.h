@@ -7,6 +7,7 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
+#include "core/DispatchTable.h"
 #include "utils/DebugMessenger.h"
 
 #include <GLFW/glfw3.h>
@@ -21,12 +22,14 @@ public:
     void initialize();
     void cleanup();
     VkInstance getInstance() const; // read only once created
+    const InstanceDispatch& getDispatch() const; // Extension entry points
 
 private:
     bool checkValidationLayerSupport();
     std::vector<const char*> getRequiredExtensions();
 
     VkInstance instance;
+    InstanceDispatch dispatch;
     std::vector<const char*> requiredExtensions;
 };
 
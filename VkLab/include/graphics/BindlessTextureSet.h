@@ -0,0 +1,50 @@
+#ifndef BINDLESS_TEXTURE_SET_H
+#define BINDLESS_TEXTURE_SET_H
+
+#include "core/Constant.h"
+#include "core/Device.h"
+#include "graphics/DescriptorLayoutCache.h"
+
+#include <vulkan/vulkan.h>
+#include <stdexcept>
+
+// Binding indices of the bindless set, they must match the declarations in shader.frag
+const uint32_t BINDLESS_TEXTURE_BINDING = 0;
+const uint32_t BINDLESS_SAMPLER_BINDING = 1;
+
+// Index of the default linear/repeat sampler, always registered first
+const uint32_t DEFAULT_SAMPLER_INDEX = 0;
+
+// A single global descriptor set holding every texture of the application (VK_EXT_descriptor_indexing)
+// Instead of allocating and binding one descriptor set per material, each texture is written once in a large
+// partially bound array and gets a stable index that the shaders use to fetch it.
+// The set is then bound once per frame, whatever the number of materials.
+class BindlessTextureSet
+{
+public:
+	void initialize(DescriptorLayoutCache* playoutCache);
+	void cleanup();
+	uint32_t registerTexture(VkImageView imageView); // Returns the stable index of the texture in the table
+	uint32_t registerSampler(VkSampler sampler);
+	VkDescriptorSetLayout* getDescriptorSetLayoutPtr();
+	VkDescriptorSet* getDescriptorSetPtr();
+	uint32_t getTextureCapacity();
+
+private:
+	void createDescriptorSetLayout(DescriptorLayoutCache* playoutCache);
+	void createDescriptorPool();
+	void allocateDescriptorSet();
+	void createDefaultSampler();
+
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE; // Owned by the DescriptorLayoutCache
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkSampler defaultSampler = VK_NULL_HANDLE;
+
+	uint32_t textureCapacity = MAX_BINDLESS_TEXTURES;
+	uint32_t samplerCapacity = MAX_BINDLESS_SAMPLERS;
+	uint32_t textureCount = 0;
+	uint32_t samplerCount = 0;
+};
+
+#endif // BINDLESS_TEXTURE_SET_H
\ No newline at end of file
@@ -5,6 +5,11 @@
 #include "core/Constant.h"
 #include "graphics/SwapChain.h"
 #include "graphics/DescriptorSet.h"
+#include "graphics/FrameUploadTracker.h"
+#include "graphics/VertexLayout.h"
+#include "scene/Mesh.h"
+#include "scene/MeshCache.h"
+#include "scene/Scene.h"
 #include "utils/Buffer.h"
 
 #include <vulkan/vulkan.h>
@@ -12,76 +17,84 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <array>
 #include <chrono>
-
-struct Vertex
-{
-	glm::vec2 pos;
-	glm::vec3 color;
-
-    // Describes at which rate to load data from memory throughout the vertices
-    // It specifies the number of bytes between data entries and whether to move to the next data entry after each vertex or after each instance
-    static VkVertexInputBindingDescription getBindingDescription() { // static because it's global the Vertex structure
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex); // Number of bytes from one entry to the next
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // Move to the next data entry after each vertex
-
-        return bindingDescription;
-    }
-
-    // Describes how to extract a vertex attribute from a chunk of vertex data originating from a binding description
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
-        // Positions
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0; // References the location directive of the input in the vertex shader
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT; // vec2: VK_FORMAT_R32G32_SFLOAT
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-        // Colors
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        return attributeDescriptions;
-    }
-};
-
-const std::vector<Vertex> vertices = {
-    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-    {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}
-};
-
-const std::vector<uint16_t> indices = {
-    0, 1, 2, 2, 3, 0
-};
+#include <span>
 
 class BufferManager
 {
 public:
-    void initialize(CommandPools* pcommandPools);
+    void initialize(CommandPools* pcommandPools, Scene* pscene, const MeshGeometry& geometry); // The geometry can be released afterwards
     void cleanup();
-    void updateUniformBuffer(SwapChain swapchain, uint32_t currentImage);
+    void updateUniformBuffer(SwapChain* pswapchain, uint32_t currentImage, const glm::mat4& view);
+    static glm::mat4 getProjection(VkExtent2D extent); // Vulkan clip space (Y pointing down)
+    void updateObjectBuffer(uint32_t currentImage, const EntityStore& entities); // Only the entities that changed recently
     VkBuffer getVertexBuffer();
+    VkBuffer getPositionBuffer(); // Positions of the vertex buffer alone, for the depth pre-pass
     VkBuffer getIndexBuffer();
-    std::vector<VkBuffer> getUniformBuffers();
+    VkIndexType getIndexType();
+    uint32_t getIndexCount(); // Of the full detail mesh, LOD 0
+    std::span<const MeshLod> getLods(); // Ranges of the index buffer, from the full detail mesh to the coarsest
+    glm::vec3 getMeshBoundsMin(); // Object space bounds of the mesh
+    glm::vec3 getMeshBoundsMax();
+    const glm::mat4& getPositionDequantization(); // Object space from the 16-bit positions, applied on the right of the model matrices
+    std::span<const Meshlet> getMeshlets(); // Of LOD 0, empty when the mesh is too small to be split (see MeshletBuilder)
+    VkBuffer getMeshletBuffer(); // Meshlet array, VK_NULL_HANDLE without meshlets
+    VkBuffer getMeshletVertexBuffer(); // Vertex indices of each meshlet
+    VkBuffer getMeshletTriangleBuffer(); // Packed local triangles of each meshlet
+    const std::vector<VkBuffer>& getUniformBuffers();
+    const std::vector<VkBuffer>& getObjectBuffers();
+    VkDeviceSize getObjectStride();
+    VkBuffer getMaterialBuffer();
 
 private: // Note: Try to create a single buffer for both of these with offsets for memory optimisation
-    void createVertexBuffer(CommandPools* pcommandPools);
-    void createIndexBuffer(CommandPools* pcommandPools);
+    void createVertexBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry);
+    void createIndexBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry);
+    void createPositionBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry);
+    void createMeshletBuffers(CommandPools* pcommandPools, const MeshGeometry& geometry);
+    void createDeviceLocalBuffer(CommandPools* pcommandPools, const void* pdata, VkDeviceSize bufferSize, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
     void createUniformBuffer();
+    void createObjectBuffer();
+    void createMaterialBuffer(const std::vector<Material>& materials);
 
     VkBuffer vertexBuffer;
     VkDeviceMemory vertexBufferMemory;
 
     VkBuffer indexBuffer;
     VkDeviceMemory indexBufferMemory;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+    uint32_t indexCount = 0;
+    std::vector<MeshLod> lods;
+
+    glm::vec3 meshBoundsMin = glm::vec3(0.0f);
+    glm::vec3 meshBoundsMax = glm::vec3(0.0f);
+    VertexQuantization quantization;
+    glm::mat4 positionDequantization = glm::mat4(1.0f);
+
+    VkBuffer positionBuffer;
+    VkDeviceMemory positionBufferMemory;
+
+    // Read by the cluster culling and the mesh shaders, only created when the mesh has meshlets
+    std::vector<Meshlet> meshlets;
+    VkBuffer meshletBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory meshletBufferMemory = VK_NULL_HANDLE;
+    VkBuffer meshletVertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory meshletVertexBufferMemory = VK_NULL_HANDLE;
+    VkBuffer meshletTriangleBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory meshletTriangleBufferMemory = VK_NULL_HANDLE;
 
     std::vector<VkBuffer> uniformBuffers;
     std::vector<VkDeviceMemory> uniformBuffersMemory;
     std::vector<void*> uniformBuffersMapped;
+
+    // Per-object data, one buffer per frame in flight holding MAX_OBJECTS entries
+    std::vector<VkBuffer> objectBuffers;
+    std::vector<VkDeviceMemory> objectBuffersMemory;
+    std::vector<void*> objectBuffersMapped;
+    VkDeviceSize objectStride = 0; // sizeof(ObjectUniformBufferObject) aligned for dynamic offsets
+    FrameUploadTracker objectUploads; // Slots of the per-frame copies that are out of date
+
+    // Material table, written once since materials don't change
+    VkBuffer materialBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory materialBufferMemory = VK_NULL_HANDLE;
 };
 
 #endif // VERTEX_H
\ No newline at end of file
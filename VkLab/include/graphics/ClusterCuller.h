@@ -0,0 +1,134 @@
+#ifndef CLUSTER_CULLER_H
+#define CLUSTER_CULLER_H
+
+#include "core/Constant.h"
+#include "core/Device.h"
+#include "graphics/BufferManager.h"
+#include "graphics/CommandPools.h"
+#include "graphics/ComputePipeline.h"
+#include "graphics/DescriptorAllocator.h"
+#include "graphics/DescriptorLayoutCache.h"
+#include "graphics/DescriptorSet.h"
+#include "graphics/HiZPyramid.h"
+#include "graphics/OcclusionCuller.h"
+#include "scene/LodSelector.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <span>
+#include <vector>
+
+// Header of the per-frame input of cluster_cull.comp and of the mesh shaders (std430), followed by one ClusterObject per slot
+struct ClusterFrameData {
+	CullCamera camera;
+	glm::mat4 viewProjection; // Only read by the mesh shaders
+	glm::mat4 positionDequantization; // Object space from the 16-bit positions (see BufferManager)
+	uint32_t meshletCount;
+	uint32_t drawCommands; // 0 with mesh shaders, which only read the visibility
+	uint32_t padding[2]; // std430 rounds the block up to the alignment of the mat4
+};
+
+// An object drawn meshlet by meshlet
+struct ClusterObject {
+	glm::mat4 model;
+	float scale; // Largest axis scale, for the meshlet spheres
+	uint32_t active; // 0 for a free slot, it draws nothing
+	uint32_t coneCulling; // The normal cones only survive uniform scales without mirroring
+	uint32_t materialIndex; // Only read by the mesh shaders, the indirect draws keep the per-draw data of the DrawList
+};
+
+// Culls the meshlets (see MeshletBuilder) of the objects drawn at LOD 0, so that a huge mesh which is only partly visible
+// doesn't pay the vertex cost of its hidden parts. It runs right after the object culling (see OcclusionCuller) against the
+// same Hi-Z pyramid, in the same two phases: cluster_cull.comp tests every meshlet of every slot against the frustum, its
+// normal cone (all the triangles face away) and the pyramid, and keeps the visibility of each meshlet of each slot.
+// - Without mesh shaders, the visible meshlets of a slot are appended to its indirect commands, and an object of a slot
+//   is drawn with a single multi-draw whose count is read by the GPU, so the culled meshlets cost nothing (needs
+//   multiDrawIndirect and VK_KHR_draw_indirect_count).
+// - With VK_EXT_mesh_shader, the task shader reads the visibility and only launches the visible meshlets, the mesh
+//   shader fetches and transforms their vertices (meshlet.task, meshlet.mesh). No command is written.
+// Only the objects at LOD 0 get a slot, up to MAX_CLUSTER_OBJECTS: they are the closest ones, the coarser LODs are small
+// enough on screen to be culled as a whole. The other objects keep their single draw of the OcclusionCuller.
+// The slots are assigned on the CPU every frame, a change invalidates the recorded command buffers (see getVersion).
+class ClusterCuller
+{
+public:
+	static constexpr uint32_t MAX_CLUSTER_OBJECTS = 64;
+	static constexpr uint32_t NO_SLOT = UINT32_MAX;
+	static constexpr uint32_t DRAW_COMMAND_STRIDE = sizeof(VkDrawIndexedIndirectCommand); // The commands of slot s start at s * meshletCount * stride
+	static constexpr uint32_t TASK_GROUP_SIZE = 32; // Meshlets per task workgroup, TASK_GROUP_SIZE in meshlet_bindings.glsl
+
+	void initialize(CommandPools* pcommandPools, DescriptorLayoutCache* playoutCache, DescriptorSet* pdescriptorSet, HiZPyramid* ppyramid, BufferManager* pbufferManager);
+	void cleanup();
+	void bindPyramid(HiZPyramid* ppyramid); // The pyramid was recreated with the swap chain
+
+	bool isSupported(); // The mesh has meshlets and the device can draw them
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+	bool usesMeshShaders() const;
+
+	// Assigns the slots to the visible objects at LOD 0 and writes the camera and the slots in the mapped input of the frame
+	// Called every frame, after the LOD selection. Disabled, every slot is freed
+	void update(uint32_t currentFrame, const EntityStore& entities, std::span<const uint32_t> visibleObjects, const LodSelector& lodSelector, const glm::mat4& view, const glm::mat4& proj);
+
+	void cmdBeginFrame(VkCommandBuffer commandBuffer); // Before the early phase, outside the render pass
+	void cmdCull(VkCommandBuffer commandBuffer, uint32_t currentFrame); // Between the two phases, after the object culling
+
+	uint32_t getObjectSlot(Entity entity) const; // NO_SLOT when the object is drawn as a whole
+	uint32_t getMeshletCount() const;
+	VkDeviceSize getDrawOffset(uint32_t slot) const; // First command of the slot
+	VkDeviceSize getDrawCountOffset(uint32_t slot, bool latePhase) const; // In the draw count buffer
+	VkBuffer getEarlyDrawBuffer();
+	VkBuffer getLateDrawBuffer();
+	VkBuffer getDrawCountBuffer();
+	VkDescriptorSet getMeshletDescriptorSet(uint32_t currentFrame); // MESHLET_SET of the mesh shader pipelines
+	uint32_t getTaskGroupCount() const; // Task workgroups covering every meshlet of a slot
+	uint64_t getVersion() const; // Incremented when the slots change
+
+private:
+	static constexpr uint32_t GROUP_SIZE = 64; // local_size_x of cluster_cull.comp
+	static constexpr uint32_t COMPUTE_BINDING_COUNT = 7;
+
+	void createBuffers(CommandPools* pcommandPools);
+	void writeDescriptorSets();
+	void writeMeshletDescriptorSets(BufferManager* pbufferManager);
+	void freeSlot(uint32_t slot);
+
+	HiZPyramid* ppyramid = nullptr;
+	ComputePipeline cullPipeline;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE; // Owned by the DescriptorLayoutCache
+	DescriptorAllocator descriptorAllocator;
+	std::array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+	std::array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT> meshletDescriptorSets{}; // The phase is pushed
+
+	// Written by the CPU every frame: one persistently mapped buffer per frame in flight
+	std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> inputBuffers{};
+	std::array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> inputBuffersMemory{};
+	std::array<void*, MAX_FRAMES_IN_FLIGHT> inputBuffersMapped{};
+
+	// Written by the GPU only
+	VkBuffer earlyDrawBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory earlyDrawBufferMemory = VK_NULL_HANDLE;
+	VkBuffer lateDrawBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory lateDrawBufferMemory = VK_NULL_HANDLE;
+	VkBuffer drawCountBuffer = VK_NULL_HANDLE; // Early phase counts of the slots, then the late phase ones
+	VkDeviceMemory drawCountBufferMemory = VK_NULL_HANDLE;
+	VkBuffer visibilityBuffer = VK_NULL_HANDLE; // One word per meshlet and per slot
+	VkDeviceMemory visibilityBufferMemory = VK_NULL_HANDLE;
+
+	VkBuffer meshletBuffer = VK_NULL_HANDLE; // Owned by the BufferManager
+	uint32_t meshletCount = 0;
+	glm::mat4 positionDequantization = glm::mat4(1.0f);
+	bool supported = false;
+	bool meshShaders = false;
+	bool enabled = true;
+
+	// Preallocated, the update runs every frame
+	std::vector<uint32_t> objectSlots; // Per entity
+	std::vector<uint8_t> qualifying; // Per entity, visible at LOD 0 in this frame
+	std::array<Entity, MAX_CLUSTER_OBJECTS> slotObjects{};
+	uint32_t slotEnd = 0; // One past the last slot in use, the dispatch only covers the slots before
+	uint64_t version = 0;
+};
+
+#endif // CLUSTER_CULLER_H
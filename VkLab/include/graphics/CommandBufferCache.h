@@ -0,0 +1,58 @@
+#ifndef COMMAND_BUFFER_CACHE_H
+#define COMMAND_BUFFER_CACHE_H
+
+#include "core/Constant.h"
+#include "core/Device.h"
+#include "graphics/CommandPools.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <stdexcept>
+
+// Everything a recorded command buffer depends on. When one of them changes, the command buffer must be recorded again
+struct RecordingVersion {
+	uint64_t sceneVersion = 0;        // Objects or materials added/removed (see Scene::getVersion)
+	uint64_t swapchainGeneration = 0; // Framebuffers and extent change when the swap chain is recreated
+	uint64_t pipelineGeneration = 0;  // Pipeline handle changes when it is rebuilt
+	bool depthPrepass = false;        // The draws are recorded once or twice
+	bool occlusionCulling = false;    // One render pass with direct draws, or two with indirect draws around the culling
+	uint64_t visibleSetHash = 0;      // Objects that passed the CPU frustum culling, only they are recorded
+	uint64_t lodVersion = 0;          // Index ranges of the direct draws (see LodSelector::getVersion)
+	uint64_t clusterVersion = 0;      // Objects drawn meshlet by meshlet (see ClusterCuller::getVersion)
+
+	bool operator==(const RecordingVersion& other) const = default;
+};
+
+// Pre-recorded command buffers for static frames.
+// A recorded command buffer references the framebuffer of one swap chain image and the descriptor sets of one frame slot,
+// so there is one command buffer per (frame slot, swap chain image) pair. They are re-submitted as long as their
+// RecordingVersion is current: only the mapped uniform buffers are written each frame.
+// A command buffer is only reused by its own frame slot, whose fence guarantees it is not pending anymore.
+class CommandBufferCache
+{
+public:
+	void initialize(CommandPools* pcommandPools, uint32_t swapchainImageCount);
+	void cleanup(CommandPools* pcommandPools);
+	VkCommandBuffer getCommandBuffer(uint32_t frame, uint32_t imageIndex);
+	bool isCurrent(uint32_t frame, uint32_t imageIndex, const RecordingVersion& version);
+	void markRecorded(uint32_t frame, uint32_t imageIndex, const RecordingVersion& version);
+	uint64_t getReusedCount();
+	uint64_t getRecordedCount();
+
+private:
+	struct Entry {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		RecordingVersion version;
+		bool recorded = false;
+	};
+
+	Entry& getEntry(uint32_t frame, uint32_t imageIndex);
+
+	uint32_t imageCount = 0;
+	std::vector<Entry> entries; // MAX_FRAMES_IN_FLIGHT * imageCount, indexed by frame * imageCount + imageIndex
+
+	uint64_t reusedCount = 0;
+	uint64_t recordedCount = 0;
+};
+
+#endif // COMMAND_BUFFER_CACHE_H
\ No newline at end of file
@@ -5,8 +5,16 @@
 #include "graphics/SwapChain.h"
 #include "graphics/RenderPass.h"
 #include "graphics/DescriptorSet.h"
+#include "graphics/BindlessTextureSet.h"
 #include "graphics/Pipeline.h"
 #include "graphics/FrameBuffers.h"
+#include "graphics/CommandRecorder.h"
+#include "graphics/DrawList.h"
+#include "graphics/OcclusionCuller.h"
+#include "graphics/ClusterCuller.h"
+#include "scene/LodSelector.h"
+#include "scene/Scene.h"
+#include "utils/Profiler.h"
 //#include "graphics/CommandPools.h"
 //#include "graphics/BufferManager.h"
 
@@ -20,7 +28,7 @@ class CommandBuffers
 {
 public:
 	void initialize(CommandPools* pCommandPool);
-	std::vector<VkCommandBuffer> getCommandBuffers();
+	const std::vector<VkCommandBuffer>& getCommandBuffers();
 	VkCommandBuffer getCommandBuffer(const int index);
 	VkCommandBuffer* getCommandBufferPtr(const int index); // not a very good practice :/
 
@@ -35,9 +43,18 @@ void recordCommandBuffer(
     SwapChain* pSwapChain,
     RenderPass* pRenderPass,
     DescriptorSet* pDescriptorSet,
+    BindlessTextureSet* pBindlessTextureSet,
     Pipeline* pPipeline,
     FrameBuffers* pFrameBuffer,
-    BufferManager* pvertexbuffer
+    BufferManager* pvertexbuffer,
+    Scene* pScene,
+    DrawList* pDrawList,
+    const LodSelector* pLodSelector, // Index range each object is drawn with
+    CommandRecorder* pRecorder,
+    Profiler* pProfiler,
+    bool depthPrepass,
+    OcclusionCuller* pOcclusionCuller, // nullptr to draw every object in a single render pass
+    ClusterCuller* pClusterCuller // nullptr to draw every object as a whole, needs the occlusion culling
 );
 
 #endif // COMMANDBUFFERS_H
\ No newline at end of file
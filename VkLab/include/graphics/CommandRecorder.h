@@ -0,0 +1,69 @@
+#ifndef COMMAND_RECORDER_H
+#define COMMAND_RECORDER_H
+
+#include "core/DispatchTable.h"
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// Thin wrapper around the vkCmd* functions used to draw.
+// It shadows the currently bound state of the command buffer and drops the calls that would not change anything,
+// so the draw loop can simply set everything it needs for every draw. The calls go through the device dispatch table.
+class CommandRecorder
+{
+public:
+	// Number of calls forwarded to Vulkan and dropped because the state was already set
+	struct Stats {
+		uint64_t issued = 0;
+		uint64_t elided = 0;
+	};
+
+	void begin(VkCommandBuffer commandBuffer); // Resets the shadowed state, nothing is bound in a new command buffer
+	void bindPipeline(VkPipeline pipeline);
+	void bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset);
+	void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	void setViewport(const VkViewport& viewport);
+	void setScissor(const VkRect2D& scissor);
+	void bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet, uint32_t dynamicOffsetCount = 0, const uint32_t* pdynamicOffsets = nullptr);
+	void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* pvalues);
+	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+	void drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride); // Parameters read by the GPU from the buffer
+	void drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride); // The draw count too (VK_KHR_draw_indirect_count)
+	void drawMeshTasks(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ); // Mesh shader pipelines only
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	static constexpr uint32_t MAX_SHADOWED_SETS = 5; // Every set of DescriptorSetIndex
+	static constexpr uint32_t MAX_PUSH_CONSTANT_BYTES = 128; // Minimum guaranteed maxPushConstantsSize
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	const DeviceDispatch* pdispatch = nullptr; // Direct driver entry points, no loader trampoline
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceSize vertexBufferOffset = 0;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceSize indexBufferOffset = 0;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+	bool viewportSet = false;
+	VkViewport viewport{};
+	bool scissorSet = false;
+	VkRect2D scissor{};
+
+	// Descriptor sets are shadowed with the layout they were bound with and their (single) dynamic offset
+	VkPipelineLayout descriptorLayout = VK_NULL_HANDLE;
+	std::array<VkDescriptorSet, MAX_SHADOWED_SETS> descriptorSets{};
+	std::array<uint32_t, MAX_SHADOWED_SETS> dynamicOffsets{};
+
+	VkPipelineLayout pushConstantLayout = VK_NULL_HANDLE;
+	uint32_t pushConstantSize = 0;
+	std::array<uint8_t, MAX_PUSH_CONSTANT_BYTES> pushConstantData{};
+
+	Stats stats;
+};
+
+#endif // COMMAND_RECORDER_H
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef COMPUTE_PIPELINE_H
+#define COMPUTE_PIPELINE_H
+
+#include "core/Device.h"
+#include "utils/shaderUtils.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+// A compute pipeline only has one shader stage and a layout: the descriptor set layouts it binds and an optional
+// push constant block (visible to the compute stage). Dispatched with vkCmdDispatch, on the compute or the graphics queue
+class ComputePipeline
+{
+public:
+	void initialize(const std::vector<char>& shaderCode, const std::vector<VkDescriptorSetLayout>& setLayouts, uint32_t pushConstantSize = 0);
+	void cleanup();
+	VkPipelineLayout getPipelineLayout();
+	VkPipeline getPipeline();
+
+private:
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+};
+
+#endif // COMPUTE_PIPELINE_H
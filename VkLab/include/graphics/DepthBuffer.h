@@ -0,0 +1,35 @@
+#ifndef DEPTH_BUFFER_H
+#define DEPTH_BUFFER_H
+
+#include "core/Device.h"
+#include "graphics/SwapChain.h"
+#include "utils/Image.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+// Depth attachment shared by every framebuffer: only one frame is rendered at a time in the render pass,
+// so a single image is enough. It has the size of the swap chain and is recreated with it
+class DepthBuffer
+{
+public:
+	void initialize(SwapChain* pswapchain);
+	void cleanup();
+	VkImage getImage();
+	VkImageView getImageView();
+	VkFormat getFormat();
+	VkExtent2D getExtent();
+
+	// First format of the list usable as a depth attachment with optimal tiling, the format is needed before
+	// the image exists (render pass creation)
+	static VkFormat findDepthFormat();
+
+private:
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+	VkImageView imageView = VK_NULL_HANDLE;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent{};
+};
+
+#endif // DEPTH_BUFFER_H
@@ -0,0 +1,50 @@
+#ifndef DESCRIPTOR_ALLOCATOR_H
+#define DESCRIPTOR_ALLOCATOR_H
+
+#include "core/Device.h"
+#include "core/Constant.h"
+
+#include <vulkan/vulkan.h>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Descriptor sets can't be created directly, they must be allocated from a pool like command buffers.
+// A single fixed pool fails as soon as one more set is needed, so the allocator owns a list of pools
+// and simply creates a new one when the current pool is exhausted (VK_ERROR_OUT_OF_POOL_MEMORY) or fragmented.
+// Individual sets are never freed: all the pools are reset wholesale, which is much cheaper.
+// - One allocator for sets living as long as the application (reset at shutdown only)
+// - One allocator per owner of sets following the swap chain (see HiZPyramid), reset when the swap chain is recreated
+class DescriptorAllocator
+{
+public:
+	void initialize(uint32_t setsPerPool = 64);
+	void cleanup();
+	VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+	void resetPools(); // Returns every set to the pools, they can't be used anymore
+
+private:
+	VkDescriptorPool grabPool();
+	VkDescriptorPool createPool(uint32_t setCount);
+
+	// Number of descriptors of each type reserved per set in a pool
+	// This is a guess of the average set, a pool which doesn't fit simply makes the allocator grow
+	std::vector<std::pair<VkDescriptorType, float>> poolSizes = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f }
+	};
+
+	uint32_t setsPerPool = 64; // Doubled each time a new pool is created, up to MAX_SETS_PER_POOL
+	static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+	VkDescriptorPool currentPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorPool> usedPools;
+	std::vector<VkDescriptorPool> freePools; // Pools that were reset and can be reused
+};
+
+#endif // DESCRIPTOR_ALLOCATOR_H
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef DESCRIPTOR_LAYOUT_CACHE_H
+#define DESCRIPTOR_LAYOUT_CACHE_H
+
+#include "core/Device.h"
+
+#include <vulkan/vulkan.h>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Descriptor set layouts are deduplicated: two identical descriptions return the same VkDescriptorSetLayout.
+// Identical layouts are then also compatible for pipeline layouts and the cache owns (and destroys) all of them.
+class DescriptorLayoutCache
+{
+public:
+	void cleanup();
+	VkDescriptorSetLayout createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo* pcreateInfo);
+
+private:
+	// Everything that identifies a layout: its bindings sorted by binding number, their binding flags and the layout flags
+	struct DescriptorLayoutInfo {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+		VkDescriptorSetLayoutCreateFlags flags = 0;
+
+		bool operator==(const DescriptorLayoutInfo& other) const;
+		size_t hash() const;
+	};
+
+	struct DescriptorLayoutHash {
+		size_t operator()(const DescriptorLayoutInfo& info) const {
+			return info.hash();
+		}
+	};
+
+	std::unordered_map<DescriptorLayoutInfo, VkDescriptorSetLayout, DescriptorLayoutHash> layoutCache;
+};
+
+#endif // DESCRIPTOR_LAYOUT_CACHE_H
\ No newline at end of file
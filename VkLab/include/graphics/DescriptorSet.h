@@ -3,35 +3,91 @@
 
 #include "core/Constant.h"
 #include "core/Device.h"
-#include "graphics/DescriptorPool.h"
+#include "graphics/DescriptorAllocator.h"
+#include "graphics/DescriptorLayoutCache.h"
 #include "graphics/BufferManager.h"
 
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
+#include <array>
 
 class BufferManager;
 
-struct UniformBufferObject {
-    glm::mat4 model;
+// Descriptor sets are partitioned by update frequency, lower sets change less often.
+// Every pipeline uses the same set layouts in the same order, so binding a pipeline or a higher set
+// never disturbs the lower sets (pipeline layout compatibility).
+// The mesh shader pipelines add a fifth set, their push constants differ so they are not compatible with the others
+enum DescriptorSetIndex : uint32_t {
+    FRAME_SET = 0,    // View data, bound once per frame
+    MATERIAL_SET = 1, // Material table, bound once per frame and indexed with the per-draw material index
+    OBJECT_SET = 2,   // Per-object data, dynamic offset per draw (only when push constants can't be used)
+    BINDLESS_SET = 3, // Global texture table, bound once per frame (see BindlessTextureSet)
+    MESHLET_SET = 4   // Meshlets and culling results of the mesh shaders, bound per phase (see ClusterCuller)
+};
+
+// Set 0 - only the view data, uploaded once per frame
+struct FrameUniformBufferObject {
     glm::mat4 view;
     glm::mat4 proj;
 };
 
+// Set 1 - one entry of the material table, written once when the material is created
+// 32 bytes, which is also its std140 array stride
+struct MaterialUniformBufferObject {
+    glm::vec4 baseColor;
+    uint32_t textureIndex; // Index in the bindless texture table
+    uint32_t padding[3];   // std140 rounds the block up to a vec4
+};
+
+// Per-draw data: pushed as push constants (see Pipeline::usesPushConstants),
+// or as a fallback written in a dynamic uniform buffer at set 2. Both blocks have this layout
+struct ObjectUniformBufferObject {
+    glm::mat4 model;
+    uint32_t materialIndex;  // Index in the material table
+    uint32_t instanceOffset; // First slot of the per-instance data of an instanced draw, 0 for a single draw
+};
+
+// Per-draw data of the mesh shader pipelines, always pushed: the transform and the material are read from the input
+// of the cluster culling, which is written every frame
+struct MeshletPushConstants {
+    uint32_t slot; // Of the object in the ClusterCuller
+    uint32_t latePhase; // The task shader launches the meshlets visible at the last culling (0) or the newly visible ones (1)
+};
+
 // A Descriptor Set is a collection of descriptors that tell shaders where and how to access resources(buffers, images, samplers, etc.)
 // It serves as a link between a shader and its associated resources
 class DescriptorSet
 {
 public:
-	void initialize();
+    // Set 4: cluster input, meshlets, meshlet vertices, meshlet triangles, vertices and meshlet visibility
+    static constexpr uint32_t MESHLET_BINDING_COUNT = 6;
+
+	void initialize(DescriptorLayoutCache* playoutCache);
     void cleanup();
-    void allocate(DescriptorPool* descriptorPool, BufferManager* bufferManager);
-    VkDescriptorSetLayout* getDescriptorSetLayoutPtr();
-    VkDescriptorSet* getDescriptorSetPtr(uint32_t index);
+    void allocate(DescriptorAllocator* pdescriptorAllocator, BufferManager* bufferManager);
+    std::array<VkDescriptorSetLayout, 3> getDescriptorSetLayouts(); // Layouts of sets 0 to 2
+    VkDescriptorSetLayout getMeshletSetLayout(); // Set 4, VK_NULL_HANDLE without mesh shaders
+    VkDescriptorSet* getDescriptorSetPtr(uint32_t index); // Frame set
+    VkDescriptorSet* getMaterialDescriptorSetPtr();
+    VkDescriptorSet* getObjectDescriptorSetPtr(uint32_t index);
 
 private:
-    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout createLayout(DescriptorLayoutCache* playoutCache, VkDescriptorType type, VkShaderStageFlags stages);
+    VkDescriptorUpdateTemplate createUpdateTemplate(VkDescriptorSetLayout layout, VkDescriptorType type);
+
+    // Layouts are owned by the DescriptorLayoutCache
+    VkDescriptorSetLayout frameSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout materialSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout objectSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout meshletSetLayout = VK_NULL_HANDLE;
+
+    VkDescriptorUpdateTemplate frameUpdateTemplate = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate materialUpdateTemplate = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate objectUpdateTemplate = VK_NULL_HANDLE;
 
-    std::vector<VkDescriptorSet> descriptorSets;
+    std::vector<VkDescriptorSet> descriptorSets; // Frame sets, one per frame in flight
+    VkDescriptorSet materialDescriptorSet = VK_NULL_HANDLE; // Materials never change, shared by every frame in flight
+    std::vector<VkDescriptorSet> objectDescriptorSets; // One per frame in flight
 };
 
 #endif // DESCRIPTOR_SET_H
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "utils/LinearAllocator.h"
+
+#include <cstdint>
+#include <vector>
+
+// A draw to record: the object it comes from and a 64-bit sort key
+struct DrawCommand {
+	uint64_t key;
+	uint32_t objectIndex;
+};
+
+// List of the draws of a frame, sorted by key so that draws sharing the same state are consecutive.
+// Key layout, most significant first (the most expensive state change gets the highest bits):
+// | pipeline (8) | material (16) | vertex buffer (8) | depth (32) |
+// The depth is the positive view distance: opaque draws inside a bucket go front to back to help early depth rejection
+class DrawList
+{
+public:
+	static uint64_t makeKey(uint32_t pipelineId, uint32_t materialIndex, uint32_t vertexBufferId, float depth);
+
+	void clear();
+	void add(uint64_t key, uint32_t objectIndex);
+	void sort(LinearAllocator* pframeArena); // The scratch buffer comes from the frame arena
+	const std::vector<DrawCommand>& getCommands() const;
+
+private:
+	std::vector<DrawCommand> commands; // Kept between frames, its capacity only grows with the number of objects
+};
+
+#endif // DRAW_LIST_H
\ No newline at end of file
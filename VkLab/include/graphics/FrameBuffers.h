@@ -5,6 +5,7 @@
 #include "graphics/SwapChain.h"
 #include "graphics/ImageViews.h"
 #include "graphics/RenderPass.h"
+#include "graphics/DepthBuffer.h"
 
 #include <vulkan/vulkan.h>
 
@@ -13,9 +14,9 @@
 class FrameBuffers
 {
 public:
-	void initialize(SwapChain* pSwapChain, ImageViews* pImageViews, RenderPass* pRenderPass);
+	void initialize(SwapChain* pSwapChain, ImageViews* pImageViews, DepthBuffer* pDepthBuffer, RenderPass* pRenderPass);
     void cleanup();
-    const std::vector<VkFramebuffer> getSwapChainFramebuffers();
+    const std::vector<VkFramebuffer>& getSwapChainFramebuffers();
 
 private:
 	// We have to create a framebuffer for all of the images in the swap chain and use the one that corresponds to the retrieved image at drawing time.
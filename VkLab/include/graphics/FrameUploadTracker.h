@@ -0,0 +1,30 @@
+#ifndef FRAME_UPLOAD_TRACKER_H
+#define FRAME_UPLOAD_TRACKER_H
+
+#include "core/Constant.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Data written to persistently mapped buffers has one copy per frame in flight, and only the copy of the current frame
+// can be written (the GPU may still read the others). An object that changed must therefore be written again in each of
+// the next MAX_FRAMES_IN_FLIGHT frames: the tracker keeps one bit per frame for the objects whose copies are stale,
+// so the writes of a frame cost as much as what changed in the last few frames, not as the whole scene.
+class FrameUploadTracker
+{
+public:
+	void initialize(uint32_t capacity);
+	void markChanged(std::span<const uint32_t> changedObjects); // Every copy of these objects is stale
+	std::span<const uint32_t> takeStaleObjects(uint32_t currentFrame); // To write in the copy of the frame, now up to date
+
+private:
+	static_assert(MAX_FRAMES_IN_FLIGHT <= 8, "one bit per frame in flight");
+	static constexpr uint8_t ALL_FRAMES = static_cast<uint8_t>((1u << MAX_FRAMES_IN_FLIGHT) - 1);
+
+	std::vector<uint8_t> staleFrames; // Per object, bit f set when the copy of frame f is stale
+	std::vector<uint32_t> staleObjects; // Objects with at least one stale copy
+	std::vector<uint32_t> frameObjects; // Result of takeStaleObjects
+};
+
+#endif // FRAME_UPLOAD_TRACKER_H
@@ -0,0 +1,60 @@
+#ifndef HIZ_PYRAMID_H
+#define HIZ_PYRAMID_H
+
+#include "core/Device.h"
+#include "graphics/ComputePipeline.h"
+#include "graphics/DepthBuffer.h"
+#include "graphics/DescriptorAllocator.h"
+#include "graphics/DescriptorLayoutCache.h"
+#include "utils/Image.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+// Hierarchical-Z pyramid: a mip chain where each texel holds the farthest depth of the screen region it covers.
+// Level 0 has half the resolution of the depth buffer, each level halves the previous one down to a single texel, so the
+// depth behind any screen rectangle is bounded by at most 2x2 texels of the right level (see OcclusionCuller).
+// It is rebuilt from the depth buffer by a compute shader (shaders/hiz.comp) in the middle of every culled frame, one
+// dispatch per level, and is always in the GENERAL layout: written as a storage image and read with texelFetch.
+// Like the depth buffer, it has the size of the swap chain and its images are recreated with it.
+class HiZPyramid
+{
+public:
+	void initialize(DescriptorLayoutCache* playoutCache, DepthBuffer* pdepthBuffer);
+	void cleanup();
+	void createPyramid(DepthBuffer* pdepthBuffer); // Image, views and descriptor sets, with the swap chain
+	void cleanupPyramid();
+
+	void cmdBuild(VkCommandBuffer commandBuffer); // Reduces the depth buffer, which must be in DEPTH_STENCIL_READ_ONLY_OPTIMAL
+
+	VkImageView getImageView(); // Whole mip chain
+	VkSampler getSampler();
+	VkExtent2D getDepthExtent(); // Size of the depth buffer the pyramid was built from
+	uint32_t getLevelCount();
+
+private:
+	static constexpr uint32_t GROUP_SIZE = 8; // local_size_x and local_size_y of hiz.comp
+
+	// Push constants of hiz.comp
+	struct BuildConstants {
+		uint32_t inputWidth;
+		uint32_t inputHeight;
+		uint32_t outputWidth;
+		uint32_t outputHeight;
+	};
+
+	ComputePipeline buildPipeline;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE; // Owned by the DescriptorLayoutCache
+	DescriptorAllocator descriptorAllocator; // Reset with the swap chain, the sets reference the image views
+	VkSampler sampler = VK_NULL_HANDLE; // Nearest, texelFetch ignores the filtering but a combined image sampler needs one
+
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+	VkImageView imageView = VK_NULL_HANDLE;
+	std::vector<VkImageView> levelViews; // One per level, written by the dispatch of this level and read by the next one
+	std::vector<VkExtent2D> levelExtents;
+	std::vector<VkDescriptorSet> levelSets; // Input (depth buffer or previous level) and output of each dispatch
+	VkExtent2D depthExtent{};
+};
+
+#endif // HIZ_PYRAMID_H
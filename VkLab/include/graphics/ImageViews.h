@@ -17,7 +17,7 @@ class ImageViews
 public:
 	void initialize(SwapChain* swapchain);
 	void cleanup();
-	std::vector<VkImageView> getSwapChainImageViews();
+	const std::vector<VkImageView>& getSwapChainImageViews();
 
 private:
 	std::vector<VkImageView> swapChainImageViews;
@@ -0,0 +1,106 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "core/Constant.h"
+#include "core/Device.h"
+#include "graphics/BufferManager.h"
+#include "graphics/CommandPools.h"
+#include "graphics/ComputePipeline.h"
+#include "graphics/DescriptorAllocator.h"
+#include "graphics/DescriptorLayoutCache.h"
+#include "graphics/FrameUploadTracker.h"
+#include "graphics/HiZPyramid.h"
+#include "scene/LodSelector.h"
+#include "scene/Scene.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+// Camera of the frame and size of the Hi-Z pyramid, read by the culling tests of shaders/culling.glsl (std430)
+struct CullCamera {
+	glm::mat4 view;
+	glm::vec4 projection; // proj[0][0], proj[1][1], proj[2][2] and proj[3][2]: all the shader needs of the symmetric projection
+	glm::uvec2 depthExtent; // Size of the depth buffer the Hi-Z pyramid is built from
+	float nearPlane;
+	uint32_t pyramidLevelCount;
+
+	static CullCamera fromView(const glm::mat4& view, const glm::mat4& proj, HiZPyramid* ppyramid);
+};
+
+// Header of the per-frame input of cull.comp (std430), followed by one CullObject per object
+struct CullFrameData {
+	CullCamera camera;
+	uint32_t objectCount;
+	uint32_t padding[3]; // std430 rounds the block up to the alignment of the objects
+};
+
+// Bounding sphere of an object in world space and the index range of its LOD, written to its indirect draws
+struct CullObject {
+	glm::vec4 sphere; // Center and radius
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t padding;
+};
+
+// GPU occlusion culling against the Hi-Z pyramid of the current frame, in two phases:
+// - Early: the objects that were visible in the previous frame are drawn first, they are very likely still visible
+//   and their depth makes a good occluder for everything else.
+// - The Hi-Z pyramid is built from that depth, then cull.comp tests the bounding sphere of every object against the
+//   frustum and the pyramid. The objects found visible that were not drawn in the early phase are drawn in the late phase.
+//   The result also becomes the early draw list of the next frame.
+// An object that becomes visible is therefore never missed: it is drawn in the late phase of the frame it appears in.
+//
+// The draws stay the ones of the DrawList (same order, same per-draw data), but their parameters come from one indirect
+// command per object written by the GPU: a culled object is a draw with an instance count of 0. The CPU doesn't read
+// anything back, and recorded command buffers stay valid as long as the scene doesn't change.
+// The indirect commands are shared by the frames in flight, which execute in submission order on the graphics queue.
+class OcclusionCuller
+{
+public:
+	void initialize(CommandPools* pcommandPools, DescriptorLayoutCache* playoutCache, HiZPyramid* ppyramid, BufferManager* pbufferManager);
+	void cleanup();
+	void bindPyramid(HiZPyramid* ppyramid); // The pyramid was recreated with the swap chain
+
+	// Camera of the frame, and bounding spheres and LODs of the entities that changed, in the mapped input buffer of the frame
+	// Called every frame even while the culling is disabled, so that the spheres stay up to date
+	void update(uint32_t currentFrame, const EntityStore& entities, const LodSelector& lodSelector, const glm::mat4& view, const glm::mat4& proj);
+
+	void cmdBeginFrame(VkCommandBuffer commandBuffer); // Before the early phase, outside the render pass
+	void cmdCull(VkCommandBuffer commandBuffer, uint32_t currentFrame, uint32_t objectCount); // Between the two phases
+
+	VkBuffer getEarlyDrawBuffer();
+	VkBuffer getLateDrawBuffer();
+	static constexpr uint32_t DRAW_COMMAND_STRIDE = sizeof(VkDrawIndexedIndirectCommand); // Indirect command of object i at i * stride
+
+private:
+	static constexpr uint32_t GROUP_SIZE = 64; // local_size_x of cull.comp
+
+	void createBuffers(CommandPools* pcommandPools);
+	void writeDescriptorSets();
+
+	HiZPyramid* ppyramid = nullptr;
+	ComputePipeline cullPipeline;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE; // Owned by the DescriptorLayoutCache
+	DescriptorAllocator descriptorAllocator;
+	std::array<VkDescriptorSet, MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+
+	// Written by the CPU every frame: one persistently mapped buffer per frame in flight
+	std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> inputBuffers{};
+	std::array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> inputBuffersMemory{};
+	std::array<void*, MAX_FRAMES_IN_FLIGHT> inputBuffersMapped{};
+	FrameUploadTracker sphereUploads;
+
+	// Written by the GPU only
+	VkBuffer earlyDrawBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory earlyDrawBufferMemory = VK_NULL_HANDLE;
+	VkBuffer lateDrawBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory lateDrawBufferMemory = VK_NULL_HANDLE;
+
+	// Every object draws the single mesh of BufferManager for now
+	float meshRadius = 0.0f;
+};
+
+#endif // OCCLUSION_CULLER_H
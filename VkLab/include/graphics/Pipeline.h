@@ -7,21 +7,59 @@
 #include "utils/shaderUtils.h"
 
 #include <iostream>
+#include <vector>
 
 class DescriptorSet;
+class BindlessTextureSet;
+
+// SPIR-V bytecode of the pipeline shaders, both vertex shader variants are read since the one used
+// depends on a device limit that is only known once the device exists
+struct PipelineShaderCode {
+	std::vector<char> vertex; // Per-draw data in push constants
+	std::vector<char> vertexObjectUbo; // Per-draw data in the dynamic object UBO
+	std::vector<char> fragment;
+	std::vector<char> depthVertex; // Depth pre-pass, positions only
+	std::vector<char> depthVertexObjectUbo;
+	std::vector<char> meshletTask; // Mesh shader path, only read with USE_MESH_SHADERS and used when the device supports it
+	std::vector<char> meshletMesh;
+
+	static PipelineShaderCode load();
+};
 
 // The Pipeline is assembled with the renderpass infos and shaders
 class Pipeline
 {
 public:
-	void initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset);
+	void initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset, BindlessTextureSet* pbindlessTextureSet, const PipelineShaderCode& shaderCode, bool allowPushConstants = true);
 	void cleanup();
 	VkPipelineLayout getPipelineLayout();
-	VkPipeline getGraphicsPipeline();
+	VkPipeline getGraphicsPipeline(); // Depth test LESS with depth writes, used without depth pre-pass
+	VkPipeline getDepthEqualPipeline(); // Depth test EQUAL without depth writes, after the depth pre-pass
+	VkPipeline getDepthPrepassPipeline(); // Depth only, reads the position stream (see BufferManager)
+	bool usesPushConstants();
+	uint64_t getGeneration();
+
+	// Same three variants drawing the meshlets of an object with task and mesh shaders (see ClusterCuller), with their own
+	// layout (MESHLET_SET and MeshletPushConstants). VK_NULL_HANDLE when the device has no mesh shaders
+	VkPipelineLayout getMeshletPipelineLayout();
+	VkPipeline getMeshletGraphicsPipeline();
+	VkPipeline getMeshletDepthEqualPipeline();
+	VkPipeline getMeshletDepthPrepassPipeline();
 
 private:
 	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-	VkPipeline graphicsPipeline;
+	VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+	VkPipeline depthEqualPipeline = VK_NULL_HANDLE;
+	VkPipeline depthPrepassPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout meshletPipelineLayout = VK_NULL_HANDLE;
+	VkPipeline meshletGraphicsPipeline = VK_NULL_HANDLE;
+	VkPipeline meshletDepthEqualPipeline = VK_NULL_HANDLE;
+	VkPipeline meshletDepthPrepassPipeline = VK_NULL_HANDLE;
+
+	// Per-draw data goes through push constants when the device limit allows it,
+	// otherwise through the dynamic uniform buffer of set 2 (vert_ubo.spv)
+	bool pushConstantsEnabled = false;
+	uint64_t generation = 0; // Incremented every time the pipeline is (re)built
 };
 
 #endif // PIPELINE_H
\ No newline at end of file
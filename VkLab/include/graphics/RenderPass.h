@@ -14,15 +14,26 @@
 // We need to specify how many color and depth buffers there will be,
 // how many samples to use for each of them and how their contents should be handled throughout the rendering operations.
 // All of this information is wrapped in a render pass object
+//
+// The occlusion culling splits the frame in two render passes around the compute work (see OcclusionCuller):
+// the first one keeps the depth buffer to build the Hi-Z pyramid, the second one loads both attachments and ends the frame.
+// The three render passes only differ by their load/store operations and layouts, so they are compatible:
+// the same framebuffers and pipelines are used with all of them.
 class RenderPass
 {
 public:
-	void initialize(SwapChain* pswapchain);
+	void initialize(SwapChain* pswapchain, VkFormat depthFormat); // Attachment 0: swap chain image, attachment 1: depth
 	void cleanup();
-	VkRenderPass getRenderPass();
+	VkRenderPass getRenderPass(); // Whole frame: clear, draw, present
+	VkRenderPass getEarlyRenderPass(); // Clear, draw, keep the depth to be sampled
+	VkRenderPass getLateRenderPass(); // Load, draw, present
 
 private:
-	VkRenderPass renderPass;
+	VkRenderPass createRenderPass(VkFormat colorFormat, VkFormat depthFormat, bool firstPass, bool lastPass);
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkRenderPass earlyRenderPass = VK_NULL_HANDLE;
+	VkRenderPass lateRenderPass = VK_NULL_HANDLE;
 };
 
 #endif // RENDERPASS_H
\ No newline at end of file
@@ -16,16 +16,16 @@ class ImageViews;
 class SwapChain
 {
 public:
-	void initialize(GLFWwindow* window);
+	void initialize(GLFWwindow* window, const std::vector<VkPresentModeKHR>& presentModePreference);
 	void cleanup();
 	const VkSwapchainKHR getSwapChain();
-	const std::vector<VkImage> getSwapChainImages();
+	const std::vector<VkImage>& getSwapChainImages();
 	const VkFormat getSwapChainImageFormat();
 	const VkExtent2D getSwapChainExtent();
 	
 private:
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, const std::vector<VkPresentModeKHR>& presentModePreference);
 	VkExtent2D chooseSwapExtent(GLFWwindow* pwindow, const VkSurfaceCapabilitiesKHR& capabilities);
 
 	VkSwapchainKHR swapChain = VK_NULL_HANDLE;
@@ -1,22 +1,42 @@
 #ifndef TEXTURE_IMAGE_H
 #define TEXTURE_IMAGE_H
 
+#include "graphics/BindlessTextureSet.h"
 #include "utils/Buffer.h"
 #include "utils/Image.h"
 #include "utils/CommandBuffersUtils.h"
 
 #include <vulkan/vulkan.h>
 #include <stdexcept>
+#include <memory>
+
+// RGBA8 pixels decoded on the CPU, independent of Vulkan so the decoding can run on another thread
+struct DecodedImage {
+	struct PixelsDeleter {
+		void operator()(unsigned char* pixels) const; // stbi_image_free
+	};
+
+	std::unique_ptr<unsigned char, PixelsDeleter> pixels;
+	int width = 0;
+	int height = 0;
+
+	static DecodedImage load(const char* filename);
+};
 
 class TextureImage
 {
 public:
-	void initialize(CommandPools commandPools);
+	// Uploads the decoded pixels and registers the texture in the bindless table
+	void initialize(CommandPools commandPools, BindlessTextureSet* pbindlessTextureSet, const DecodedImage& image);
     void cleanup();
+    uint32_t getTextureIndex();
 
 private:
     VkImage textureImage;
     VkDeviceMemory textureImageMemory;
+    VkImageView textureImageView;
+
+    uint32_t textureIndex = 0; // Stable index in the bindless texture table
 };
 
 void transitionImageLayout(VkCommandPool commandPool, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
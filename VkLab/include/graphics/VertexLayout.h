@@ -0,0 +1,209 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include "scene/Mesh.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Per-mesh dequantization of the 16-bit positions: position = offset + scale * stored, with stored in [-1, 1].
+// The scale is the same on every axis so that it can be folded in the model matrix (see getDequantization) without
+// skewing the normals, the vertex shaders then read the stored value as the object space position
+struct VertexQuantization {
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	float positionScale = 1.0f;
+
+	static VertexQuantization fromBounds(glm::vec3 boundsMin, glm::vec3 boundsMax);
+	glm::mat4 getDequantization() const; // Multiplied on the right of the model matrix
+};
+
+// Vertex input declared by a shader: one VERTEX_INPUT(location, type, name) line of shaders/*_vertex_inputs.glsl
+struct ShaderVertexInput {
+	uint32_t location;
+	std::string_view type;
+	std::string_view name;
+};
+
+// Attributes of a vertex layout. Each one gives its storage on the GPU, the Vulkan format the input assembler reads it
+// with, the GLSL declaration that receives it and how it is encoded from the import format (see Vertex). Only the
+// attributes that depend on the mesh bounds take the VertexQuantization
+struct PositionFloat {
+	using Storage = glm::vec3;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr const char* GLSL_TYPE = "vec3";
+	static constexpr const char* NAME = "inPosition";
+	static Storage encode(const Vertex& vertex);
+};
+
+// 16-bit normalized, dequantized by the model matrix. The fourth component pads the attribute to 8 bytes and reads as 1
+struct PositionSnorm16 {
+	using Storage = std::array<int16_t, 4>;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SNORM;
+	static constexpr const char* GLSL_TYPE = "vec4";
+	static constexpr const char* NAME = "inPosition";
+	static Storage encode(const Vertex& vertex, const VertexQuantization& quantization);
+};
+
+struct NormalFloat {
+	using Storage = glm::vec3;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr const char* GLSL_TYPE = "vec3";
+	static constexpr const char* NAME = "inNormal";
+	static Storage encode(const Vertex& vertex);
+};
+
+// Octahedral mapping: the unit sphere is projected on an octahedron unfolded into the [-1, 1] square, two 16-bit
+// components keep the error under 0.05 degree. Decoded by decodeOctahedral in shaders/octahedral.glsl
+struct NormalOctahedral16 {
+	using Storage = uint32_t;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R16G16_SNORM;
+	static constexpr const char* GLSL_TYPE = "vec2";
+	static constexpr const char* NAME = "inNormal";
+	static Storage encode(const Vertex& vertex);
+};
+
+struct TexCoordFloat {
+	using Storage = glm::vec2;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R32G32_SFLOAT;
+	static constexpr const char* GLSL_TYPE = "vec2";
+	static constexpr const char* NAME = "inTexCoord";
+	static Storage encode(const Vertex& vertex);
+};
+
+// Half floats keep a texel of precision on a 2048 texture for coordinates in [0, 1], it degrades on heavily wrapped UVs
+struct TexCoordHalf {
+	using Storage = uint32_t;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R16G16_SFLOAT;
+	static constexpr const char* GLSL_TYPE = "vec2";
+	static constexpr const char* NAME = "inTexCoord";
+	static Storage encode(const Vertex& vertex);
+};
+
+struct ColorFloat {
+	using Storage = glm::vec3;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr const char* GLSL_TYPE = "vec3";
+	static constexpr const char* NAME = "inColor";
+	static Storage encode(const Vertex& vertex);
+};
+
+struct ColorUnorm8 {
+	using Storage = uint32_t;
+	static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+	static constexpr const char* GLSL_TYPE = "vec4";
+	static constexpr const char* NAME = "inColor";
+	static Storage encode(const Vertex& vertex);
+};
+
+// Interleaved vertex made of the given attributes, at locations 0, 1, 2... in this order.
+// Everything the pipeline and the upload need is derived from the list at compile time: the offsets and the stride,
+// the Vulkan binding and attribute descriptions, and the check of the GLSL declarations of the vertex shader
+template <typename... Attributes>
+class VertexLayout
+{
+public:
+	static constexpr uint32_t ATTRIBUTE_COUNT = sizeof...(Attributes);
+
+private:
+	// Each attribute starts on 4 bytes, the alignment Vulkan requires for the largest component used
+	static constexpr uint32_t alignedSize(uint32_t size) {
+		return (size + 3) & ~3u;
+	}
+
+	static constexpr std::array<uint32_t, ATTRIBUTE_COUNT + 1> computeOffsets() {
+		std::array<uint32_t, ATTRIBUTE_COUNT + 1> offsets{};
+		uint32_t sizes[] = { alignedSize(sizeof(typename Attributes::Storage))... };
+		for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+			offsets[i + 1] = offsets[i] + sizes[i];
+		}
+		return offsets;
+	}
+
+public:
+	static constexpr std::array<uint32_t, ATTRIBUTE_COUNT + 1> OFFSETS = computeOffsets(); // The last one is the stride
+	static constexpr uint32_t STRIDE = OFFSETS[ATTRIBUTE_COUNT];
+
+	// One vertex in the vertex buffer
+	struct Data {
+		alignas(4) std::byte bytes[STRIDE];
+	};
+	static_assert(sizeof(Data) == STRIDE, "vertex data must be tightly packed");
+
+	static Data encode(const Vertex& vertex, const VertexQuantization& quantization) {
+		Data data{};
+		uint32_t attribute = 0;
+		(encodeAttribute<Attributes>(data, attribute++, vertex, quantization), ...);
+		return data;
+	}
+
+	static std::vector<Data> encode(const std::vector<Vertex>& vertices, const VertexQuantization& quantization) {
+		std::vector<Data> data(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			data[i] = encode(vertices[i], quantization);
+		}
+		return data;
+	}
+
+	static constexpr VkVertexInputBindingDescription getBindingDescription(uint32_t binding = 0) {
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = binding;
+		bindingDescription.stride = STRIDE;
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescription;
+	}
+
+	static constexpr std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> getAttributeDescriptions(uint32_t binding = 0) {
+		std::array<VkVertexInputAttributeDescription, ATTRIBUTE_COUNT> attributeDescriptions{};
+		VkFormat formats[] = { Attributes::FORMAT... };
+		for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+			attributeDescriptions[i].binding = binding;
+			attributeDescriptions[i].location = i;
+			attributeDescriptions[i].format = formats[i];
+			attributeDescriptions[i].offset = OFFSETS[i];
+		}
+		return attributeDescriptions;
+	}
+
+	// True when the shader declares the attributes of the layout, in order from location 0, with their GLSL types and names
+	static constexpr bool matchesShaderInputs(std::span<const ShaderVertexInput> inputs) {
+		std::string_view types[] = { Attributes::GLSL_TYPE... };
+		std::string_view names[] = { Attributes::NAME... };
+		if (inputs.size() != ATTRIBUTE_COUNT) {
+			return false;
+		}
+		for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+			if (inputs[i].location != i || inputs[i].type != types[i] || inputs[i].name != names[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	template <typename Attribute>
+	static void encodeAttribute(Data& data, uint32_t attribute, const Vertex& vertex, const VertexQuantization& quantization) {
+		typename Attribute::Storage value;
+		if constexpr (std::is_invocable_v<decltype(&Attribute::encode), const Vertex&, const VertexQuantization&>) {
+			value = Attribute::encode(vertex, quantization);
+		}
+		else {
+			value = Attribute::encode(vertex);
+		}
+		memcpy(data.bytes + OFFSETS[attribute], &value, sizeof(value));
+	}
+};
+
+// Layouts of the geometry buffers (see BufferManager), 20 bytes per vertex instead of the 44 of the float attributes.
+// Their shader side is shaders/mesh_vertex_inputs.glsl and shaders/position_vertex_inputs.glsl (see VertexLayout.cpp)
+using MeshVertexLayout = VertexLayout<PositionSnorm16, NormalOctahedral16, TexCoordHalf, ColorUnorm8>;
+using PositionVertexLayout = VertexLayout<PositionSnorm16>; // Position stream of the depth pre-pass
+
+#endif // VERTEX_LAYOUT_H
@@ -0,0 +1,74 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "scene/ObjectStore.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Node of the flat BVH array, 32 bytes so that two nodes fill a cache line.
+// A leaf (count > 0) references count entries of the object index list starting at leftFirst,
+// an interior node (count == 0) has its two children at leftFirst and leftFirst + 1.
+struct BVHNode {
+	glm::vec3 boundsMin;
+	uint32_t leftFirst;
+	glm::vec3 boundsMax;
+	uint32_t count;
+};
+
+// Bounding volume hierarchy over the world AABBs of an ObjectStore, for the spatial queries of the scene:
+// frustum culling, range queries and picking reject whole subtrees at once instead of testing every object.
+// The tree is built with the surface area heuristic. When objects move it is refitted (the topology is kept and only
+// the bounds grow or shrink), which is much cheaper than a build but loosens the tree: isDegraded tells when the SAH
+// cost drifted far enough from the one of the last build that a rebuild pays off.
+// Nothing is allocated after initialize as long as the store stays below the capacity.
+class BVH
+{
+public:
+	static constexpr uint32_t NO_HIT = UINT32_MAX;
+
+	void initialize(const ObjectStore* pobjectStore, uint32_t capacity);
+	void build(); // From the current bounds of the store
+	void refit(); // Every node, after the store was updated
+	void refit(std::span<const uint32_t> movedObjects); // Only the paths from the leaves of these objects to the root
+	bool isDegraded() const; // The SAH cost grew past REBUILD_COST_RATIO times the one of the last build, O(1)
+
+	// Same visible set as ObjectStore::cull, in tree order. pvisibleIndices must have room for size() indices
+	uint32_t cull(const Frustum& frustum, uint32_t* pvisibleIndices) const;
+	// Objects whose AABB overlaps the box, at most capacity indices are written, returns the number written
+	uint32_t query(glm::vec3 boundsMin, glm::vec3 boundsMax, uint32_t* pindices, uint32_t capacity) const;
+	// Closest object whose AABB the ray hits before maxDistance, NO_HIT if none. The distance is in units of direction
+	uint32_t raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, float& hitDistance) const;
+
+	uint32_t getNodeCount() const;
+	float getCost() const; // SAH cost relative to the root: expected node visits and object tests per random query
+
+private:
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+	static constexpr uint32_t BIN_COUNT = 16; // Candidate split planes per axis of the binned SAH build
+	static constexpr uint32_t MAX_DEPTH = 64; // Size of the traversal stacks, deeper nodes are made leaves
+	static constexpr float TRAVERSAL_COST = 1.0f; // Cost of a node visit relative to an object test
+	static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+	void subdivide(uint32_t nodeIndex, uint32_t depth);
+	void updateLeafBounds(uint32_t nodeIndex);
+	void updateInteriorBounds(uint32_t nodeIndex);
+	double getNodeCost(uint32_t nodeIndex) const; // Surface area weighted by the cost of visiting the node
+	void computeCostSum();
+
+	const ObjectStore* pobjectStore = nullptr;
+
+	std::vector<BVHNode> nodes; // Root at 0, the children of a node are always after it
+	std::vector<uint32_t> parents; // Parent of each node (not in BVHNode, only the refit reads it)
+	std::vector<uint32_t> objectIndices; // Object indices grouped by leaf
+	std::vector<uint32_t> objectLeaves; // Leaf of each object
+	uint32_t nodeCount = 0;
+	uint32_t objectCount = 0;
+
+	float builtCost = 0.0f;
+	double costSum = 0.0; // Of getNodeCost over the nodes, updated by the refits along the paths they change
+};
+
+#endif // BVH_H
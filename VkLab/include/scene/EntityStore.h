@@ -0,0 +1,66 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using Entity = uint32_t; // Index in the component arrays, also the slot of the entity in the per-object GPU buffers
+constexpr Entity NO_ENTITY = UINT32_MAX;
+
+// Components of the scene entities in structure-of-arrays layout: each component has its own contiguous array indexed
+// by the entity, so a pass over one component doesn't load the others. Every entity is drawn (with the single mesh of
+// BufferManager for now), the world bounds are the ObjectStore arrays, indexed the same way.
+//
+// Entities form a hierarchy: the world transform of an entity is the world transform of its parent times its local
+// transform. Changing a local transform only marks the entity dirty, update() then recomputes the world transforms of the
+// dirty subtrees alone and lists every entity whose world transform or material changed. The users of the components
+// (GPU buffers, bounds, BVH) only process that list, so a frame where nothing moves costs nothing.
+class EntityStore
+{
+public:
+	void initialize(uint32_t capacity); // Nothing is allocated until the capacity is reached
+	Entity create(const glm::mat4& localTransform, uint32_t materialIndex, Entity parent = NO_ENTITY);
+	void setLocalTransform(Entity entity, const glm::mat4& localTransform);
+	void setMaterial(Entity entity, uint32_t materialIndex);
+
+	void update(); // World transforms of the dirty subtrees
+	std::span<const Entity> getChangedEntities() const; // By the last update, in no particular order
+
+	uint32_t size() const;
+	Entity getParent(Entity entity) const;
+	const glm::mat4& getLocalTransform(Entity entity) const;
+	const glm::mat4& getWorldTransform(Entity entity) const;
+	uint32_t getMaterialIndex(Entity entity) const;
+	std::span<const glm::mat4> getWorldTransforms() const;
+
+private:
+	enum Flags : uint8_t {
+		PENDING = 1, // In pendingEntities
+		DIRTY = 2,   // The local transform changed, the world transforms of the subtree must be recomputed
+		QUEUED = 4,  // In updateQueue
+		CHANGED = 8  // In changedEntities
+	};
+
+	void markPending(Entity entity);
+	void markChanged(Entity entity);
+	bool hasDirtyAncestor(Entity entity) const;
+
+	// Components
+	std::vector<glm::mat4> localTransforms;
+	std::vector<glm::mat4> worldTransforms;
+	std::vector<uint32_t> materialIndices;
+
+	// Hierarchy, the children of an entity are a linked list so that adding one doesn't move the others
+	std::vector<Entity> parents;
+	std::vector<Entity> firstChildren;
+	std::vector<Entity> nextSiblings;
+
+	std::vector<uint8_t> flags;
+	std::vector<Entity> pendingEntities; // Local transform or material changed since the last update
+	std::vector<Entity> updateQueue; // Entities to recompute, every parent before its children
+	std::vector<Entity> changedEntities;
+};
+
+#endif // ENTITY_STORE_H
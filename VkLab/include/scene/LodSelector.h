@@ -0,0 +1,50 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include "scene/EntityStore.h"
+#include "scene/Mesh.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Picks the LOD each visible object is drawn with (see MeshSimplifier): the coarsest one whose error, projected on the
+// screen, stays under LOD_ERROR_THRESHOLD_PIXELS. The error is projected at the point of the bounding sphere of the object
+// closest to the camera, so it is never underestimated.
+// An object only switches when the error crosses the threshold by LOD_HYSTERESIS, so that it doesn't pop back and forth
+// while the camera hovers around a switching distance. Objects outside the frustum keep their LOD until they are visible.
+class LodSelector
+{
+public:
+	void initialize(uint32_t capacity, std::span<const MeshLod> lods, float meshRadius); // Every object starts at LOD 0
+	void setEnabled(bool enabled); // Disabled, every object is drawn with LOD 0
+	bool isEnabled() const;
+
+	// The camera of the frame and the height of the viewport in pixels
+	void update(const EntityStore& entities, std::span<const uint32_t> visibleObjects, const glm::mat4& view, const glm::mat4& proj, float viewportHeight);
+
+	const MeshLod& getObjectLod(Entity entity) const;
+	uint32_t getObjectLodLevel(Entity entity) const; // 0 for the full detail mesh
+	std::span<const Entity> getChangedObjects() const; // Whose LOD changed in the last update
+	uint64_t getVersion() const; // Incremented by the updates that changed a LOD
+
+	// Triangles of the visible objects at their LOD, and at LOD 0, in the last update
+	uint64_t getSubmittedTriangleCount() const;
+	uint64_t getFullDetailTriangleCount() const;
+
+private:
+	float getScreenError(uint32_t lod, float pixelsPerUnit) const;
+
+	std::vector<MeshLod> lods;
+	float meshRadius = 0.0f;
+	bool enabled = true;
+
+	std::vector<uint8_t> objectLods; // Per entity, grows up to the capacity
+	std::vector<Entity> changedObjects;
+	uint64_t version = 0;
+	uint64_t submittedTriangleCount = 0;
+	uint64_t fullDetailTriangleCount = 0;
+};
+
+#endif // LOD_SELECTOR_H
@@ -0,0 +1,60 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Vertex as imported, in full precision. It is encoded to a compact GPU layout at upload time (see VertexLayout)
+struct Vertex
+{
+	glm::vec3 pos;
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+	glm::vec3 color;
+};
+
+// Level of detail of a mesh: a range of its index buffer. Every LOD indexes the same vertices
+struct MeshLod {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error; // Object space distance between this LOD and the full mesh, 0 for LOD 0
+};
+
+// Small cluster of neighboring triangles of LOD 0, culled on its own on the GPU (see MeshletBuilder and ClusterCuller)
+// Read by the shaders with the std430 layout, the vec4 come first
+struct Meshlet {
+	glm::vec4 sphere; // Object space bounding sphere: center and radius
+	glm::vec4 cone; // Normal cone: average normal and cutoff, every triangle faces away from viewpoints past the cutoff
+	uint32_t firstIndex; // The triangles of a meshlet are contiguous in the index buffer
+	uint32_t triangleCount;
+	uint32_t firstVertex; // In MeshData::meshletVertices
+	uint32_t vertexCount;
+};
+
+// Indexed triangle list of a mesh on the CPU, before its upload to the geometry buffers (see BufferManager)
+// The indices are always kept on 32 bits here, they are narrowed at upload time when the vertex count allows it
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	// Ranges of indices, from the full mesh to the coarsest (see MeshSimplifier). Empty when the mesh has a single LOD,
+	// getLods then returns the whole index buffer
+	std::vector<MeshLod> lods;
+	// Meshlets of LOD 0, empty for the meshes too small to gain from culling parts of them. For the mesh shaders, each meshlet
+	// also lists the vertices it uses, and each triangle its 3 vertices within that list (8 bits each, packed in a word)
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> meshletTriangles; // One per triangle of LOD 0, in the order of the index buffer
+
+	static MeshData createQuad(); // Textured unit quad in the XY plane, drawn when no model is imported
+
+	void computeBounds();
+	std::vector<MeshLod> getLods() const;
+	// 16-bit indices halve the index buffer and its fetches, they are used whenever every vertex can be addressed
+	VkIndexType getIndexType() const;
+};
+
+#endif // MESH_H
@@ -0,0 +1,69 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "scene/Mesh.h"
+#include "utils/MappedFile.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// The streams of a mesh in the exact format of the geometry buffers (see BufferManager), copied to the GPU as they are
+struct MeshGeometry {
+	std::span<const char> vertices; // MeshVertexLayout
+	std::span<const char> positions; // PositionVertexLayout, for the depth pre-pass
+	std::span<const char> indices; // 16 or 32 bits, from MeshData::getIndexType
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	glm::vec3 boundsMin = glm::vec3(0.0f); // The vertex quantization is derived from them
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	std::span<const MeshLod> lods; // At least LOD 0
+	std::span<const Meshlet> meshlets;
+	std::span<const uint32_t> meshletVertices;
+	std::span<const uint32_t> meshletTriangles;
+};
+
+// Versioned binary container of a processed mesh: a header, then every stream of MeshGeometry in its own aligned section.
+// Importing and processing a mesh (see MeshImporter, MeshOptimizer, MeshSimplifier and MeshletBuilder) takes far longer
+// than the upload, so the result is saved once to MESH_CACHE_DIRECTORY and the next launches map it instead: the sections
+// are uploaded straight from the mapping, nothing is parsed or converted.
+// The header records the hash of the source file and of the processing settings. A file written from another source, by
+// another version of the format or with other vertex layouts is ignored and written again.
+class MeshCache
+{
+public:
+	static constexpr uint32_t MAGIC = 0x48534D56; // "VMSH"
+	static constexpr uint32_t VERSION = 1; // Incremented when the format or the processing of the meshes changes
+
+	// In MESH_CACHE_DIRECTORY, named after the source file and a hash of its absolute path: two sources with the same
+	// name in different directories get their own cache file
+	static std::string getCachePath(const std::string& sourceFilename);
+	// Hash of the source file, of the files it references (see MeshImporter::getExternalFiles) and of the settings
+	// changing the processed mesh, false when one of the files can't be read
+	static bool computeSourceHash(const std::string& sourceFilename, uint64_t& hash);
+
+	static std::vector<char> serialize(const MeshData& mesh, uint64_t sourceHash); // The content of the cache file
+	static bool write(const std::string& filename, std::span<const char> data); // False when the file can't be written
+	// False when the data is not a valid cache file for the source, the geometry then points into the data
+	static bool parse(std::span<const char> data, uint64_t sourceHash, MeshGeometry& geometry);
+};
+
+// A mesh ready for upload, in the cache format: mapped from its cache file, or serialized in memory when it was just
+// processed. The geometry stays valid until the mesh is released or destroyed
+class CachedMesh
+{
+public:
+	bool map(const std::string& filename, uint64_t sourceHash); // False when the file is missing or not valid for the source
+	void assign(std::vector<char> data, uint64_t sourceHash); // From MeshCache::serialize
+	void release(); // Once the geometry is uploaded
+	const MeshGeometry& getGeometry() const;
+
+private:
+	MappedFile file;
+	std::vector<char> data;
+	MeshGeometry geometry;
+};
+
+#endif // MESH_CACHE_H
@@ -0,0 +1,37 @@
+#ifndef MESH_IMPORTER_H
+#define MESH_IMPORTER_H
+
+#include "scene/Mesh.h"
+#include "utils/Json.h"
+#include "utils/ThreadPool.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+// Loads a model file into a single indexed mesh: Wavefront OBJ (.obj), glTF 2.0 (.gltf with external or embedded
+// buffers, and binary .glb). Every triangle of the file ends up in the mesh, the glTF node transforms are applied.
+//
+// The work is split in two steps that both run on the thread pool:
+// - Parsing: the OBJ text is cut in chunks at line boundaries that are parsed independently, the glTF primitives are
+//   decoded independently. Both produce three vertices per triangle.
+// - Deduplication: identical vertices are merged with an open addressing hash map, which builds the index buffer.
+//   The hashes are computed in parallel, the insertions are sequential.
+// Missing normals are replaced by the face normal, missing texture coordinates by 0 and missing colors by white.
+class MeshImporter
+{
+public:
+	static MeshData load(const std::string& filename, ThreadPool* pthreadPool);
+	// The other files the model is read from: the external buffers of a glTF file, with their URIs decoded.
+	// Only the JSON of the given content of the file is parsed, the BIN chunk of a .glb is skipped
+	static std::vector<std::string> getExternalFiles(const std::string& filename, std::span<const char> file);
+
+private:
+	static JsonValue parseGltfFile(const std::string& filename, std::span<const char> file, std::vector<char>* pglbBuffer);
+	static std::vector<Vertex> parseObj(std::span<const char> text, ThreadPool* pthreadPool);
+	static std::vector<Vertex> parseGltf(const JsonValue& document, std::vector<std::vector<char>>& buffers, ThreadPool* pthreadPool);
+	static std::vector<std::vector<char>> loadGltfBuffers(const JsonValue& document, const std::string& directory, std::vector<char>* pglbBuffer);
+	static MeshData deduplicate(const std::vector<Vertex>& triangleVertices, ThreadPool* pthreadPool);
+};
+
+#endif // MESH_IMPORTER_H
@@ -0,0 +1,47 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "scene/Mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// Vertex cache efficiency of an index buffer, simulated with a FIFO post-transform cache
+struct VertexCacheStatistics {
+	float acmr = 0.0f; // Average cache miss ratio: vertex shader invocations per triangle, 0.5 at best on a regular grid, 3 at worst
+	float atvr = 0.0f; // Average transformed vertex ratio: invocations per vertex, 1 at best
+};
+
+// Reorders a mesh at import time so that the GPU does less work drawing it, the triangles and vertices stay the same:
+// - Vertex cache: the triangles are reordered with Tipsify (Sander et al. 2007), which fans around the vertices that are
+//   still in the cache, so that their shaded result is reused by the next triangles.
+// - Overdraw: the Tipsify output is cut in clusters where the cache starts cold anyway, or where cutting barely changes
+//   the ACMR, and the clusters that face outwards are drawn first so that they occlude the others early.
+// - Vertex fetch: the vertices are renumbered in the order the index buffer first uses them, so that the vertex fetches
+//   walk the vertex buffer forwards.
+class MeshOptimizer
+{
+public:
+	static constexpr uint32_t VERTEX_CACHE_SIZE = 16; // Entries of the simulated cache, a conservative size for current GPUs
+	static constexpr float OVERDRAW_THRESHOLD = 1.05f; // ACMR loss accepted to cut the clusters finer for the overdraw order
+
+	struct Report {
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+	};
+
+	// Runs the three passes in order, the vertex fetch one last since it only renumbers. The LODs of MeshSimplifier are
+	// generated afterwards: they index the same vertices and reorder their own triangles for the cache
+	static Report optimize(MeshData& mesh);
+
+	static VertexCacheStatistics analyzeVertexCache(const MeshData& mesh, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+	// Fills pclusterStarts, when given, with the first triangle of each run that starts on a cold cache
+	static void optimizeVertexCache(MeshData& mesh, std::vector<uint32_t>* pclusterStarts = nullptr);
+	static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* pclusterStarts = nullptr);
+	// Expects the triangles in the order of optimizeVertexCache and its cluster starts
+	static void optimizeOverdraw(MeshData& mesh, const std::vector<uint32_t>& clusterStarts, float threshold = OVERDRAW_THRESHOLD);
+	static void optimizeVertexFetch(MeshData& mesh); // Also drops the vertices no triangle uses
+};
+
+#endif // MESH_OPTIMIZER_H
@@ -0,0 +1,31 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "scene/Mesh.h"
+
+#include <cstdint>
+
+// Builds the LOD chain of a mesh at import time with quadric error metrics (Garland and Heckbert 1997).
+// Each position accumulates the planes of its triangles weighted by their area. The edges are collapsed cheapest first,
+// the cost of moving a position onto its neighbor being the mean squared distance to the planes of both.
+// One pass simplifies from the full mesh down: the live triangles are copied out each time the count halves, so every
+// LOD is a subset of the collapses of the next one. The LODs keep the vertices of the full mesh (a collapse moves a
+// vertex onto an existing one) and only add index ranges, which all share the vertex buffer.
+// What the collapses can't move:
+// - Borders and non-manifold edges: the silhouette of open meshes would shrink.
+// - Positions shared by several vertices (UV or normal seams): the seam would tear. They can still receive a collapse.
+// A collapse is also rejected when it flips a triangle or when it would fold the surface onto itself (link condition).
+class MeshSimplifier
+{
+public:
+	static constexpr uint32_t MAX_LOD_COUNT = 6; // LOD 0 included
+	static constexpr float LOD_REDUCTION = 0.5f; // Triangles of a LOD relative to the previous one
+	static constexpr uint32_t MIN_LOD_TRIANGLES = 64; // Below that, a LOD doesn't save anything worth an extra index range
+	static constexpr float MIN_NORMAL_COSINE = 0.25f; // Rotation a collapse may apply to a triangle, about 75 degrees
+
+	// Appends the LODs to the index buffer and fills mesh.lods, LOD 0 being the mesh as it is.
+	// The mesh stops at fewer LODs when the locked positions prevent halving it again
+	static void generateLods(MeshData& mesh);
+};
+
+#endif // MESH_SIMPLIFIER_H
@@ -0,0 +1,27 @@
+#ifndef MESHLET_BUILDER_H
+#define MESHLET_BUILDER_H
+
+#include "scene/Mesh.h"
+
+#include <cstdint>
+
+// Splits LOD 0 of a mesh into meshlets at import time, so that the GPU can cull the hidden parts of a mesh which is only
+// partly visible (see ClusterCuller). The meshlets grow greedily over the triangles sharing their vertices: the next triangle
+// is the one adding the fewest vertices, then the closest to the meshlet and the most aligned with its normals, so that
+// the meshlets stay compact (tight spheres) and flat (narrow cones). A meshlet ends when no neighbor fits anymore.
+// The limits are the ones commonly recommended for mesh shaders, whose outputs must fit the on-chip memory of a workgroup.
+// The index range of LOD 0 is reordered meshlet by meshlet: the order of MeshOptimizer only survives within each meshlet,
+// but the meshlets are small enough that the vertex cache keeps working across them.
+class MeshletBuilder
+{
+public:
+	static constexpr uint32_t MAX_VERTICES = 64;
+	static constexpr uint32_t MAX_TRIANGLES = 124;
+	static constexpr uint32_t MIN_MESH_TRIANGLES = 1024; // Below that, the whole mesh is culled as one object anyway
+	static constexpr float MIN_CONE_COSINE = 0.1f; // Wider cones are never culled, they would only cull from behind the surface
+
+	// Fills the meshlets of the mesh, its LODs must be generated before
+	static void build(MeshData& mesh);
+};
+
+#endif // MESHLET_BUILDER_H
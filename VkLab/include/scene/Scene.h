@@ -0,0 +1,60 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "core/Constant.h"
+#include "scene/EntityStore.h"
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+
+// What the fragment shader needs to shade a surface, stored in the material table (set 1)
+struct Material {
+	glm::vec4 baseColor;
+	uint32_t textureIndex; // Index in the bindless texture table
+};
+
+// Materials and drawable entities (see EntityStore), the draw order is decided by the DrawList
+class Scene
+{
+public:
+	void initialize(uint32_t textureIndex);
+	void update(); // Advances the animation clock while animating, then updates the world transforms that changed
+	uint32_t addMaterial(glm::vec4 baseColor, uint32_t textureIndex);
+	// The transform is relative to the parent, rotationSpeed is in degrees per second around the local Z axis
+	Entity addObject(glm::mat4 localTransform, uint32_t materialIndex, float rotationSpeed = 0.0f, Entity parent = NO_ENTITY);
+	glm::mat4 getViewMatrix();
+	void orbitCamera(float degrees);
+	void setAnimating(bool enabled);
+	bool isAnimating();
+	uint64_t getVersion();
+	uint64_t getViewVersion();
+	std::vector<Material>& getMaterials();
+	EntityStore& getEntities();
+
+private:
+	// Look at the geometry from above at a 45 degree angle
+	glm::vec3 cameraPosition = glm::vec3(2.5f, 2.5f, 2.5f);
+	glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	uint64_t version = 0; // Incremented when materials or objects are added, transforms alone don't change it
+	uint64_t viewVersion = 0; // Incremented when the camera moves
+
+	// The animation clock only runs while animating, so pausing and resuming doesn't make the objects jump
+	bool animating = true;
+	float animationTime = 0.0f; // Seconds
+	std::chrono::high_resolution_clock::time_point lastUpdateTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<Material> materials;
+	EntityStore entities;
+
+	// Demo animation, only the rotating entities are listed so that the others are never marked dirty
+	std::vector<Entity> rotatingEntities;
+	std::vector<glm::mat4> baseTransforms; // Local transforms before animation, same order as rotatingEntities
+	std::vector<float> rotationSpeeds;
+};
+
+#endif // SCENE_H
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Debug builds replace the global operator new to count the heap allocations of the process,
+// so the renderer can check that steady-state frames don't allocate (see CHECK_FRAME_ALLOCATIONS).
+// Allocations made by the Vulkan driver or GLFW through malloc are not counted.
+#ifdef NDEBUG
+const bool allocationCounterEnabled = false;
+#else
+const bool allocationCounterEnabled = true;
+#endif
+
+uint64_t getHeapAllocationCount(); // Always 0 when the counter is disabled
+
+#endif // ALLOCATION_COUNTER_H
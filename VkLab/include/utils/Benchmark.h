@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// The benchmarks (DispatchBenchmark, CullingBenchmark, MeshImportBenchmark, MeshOptimizerBenchmark, LodBenchmark) are
+// only compiled by the Benchmark configurations of the project, which define VKLAB_BENCHMARKS. The renderer runs each of
+// them once, during startup or over its first frames.
+
+// Best time of the given function over the rounds, in milliseconds. Keeping the best round ignores preemption and warm-up
+template <typename Function>
+double measureBestMilliseconds(uint32_t rounds, Function&& function) {
+	double best = 1e30;
+	for (uint32_t round = 0; round < rounds; round++) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+#endif // BENCHMARK_H
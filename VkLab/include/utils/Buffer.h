@@ -13,8 +13,11 @@ inline uint32_t findMemoryType(Device* pdevice, uint32_t typeFilter, VkMemoryPro
 inline void createBuffer(Device* pdevice, VkDeviceSize deviceSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
 	auto logicalDevice = pdevice->getLogicalDevice();
 	
-	QueueFamilyIndices indices = findQueueFamilies(RendererContext::getInstance().pdevice->getPhysicalDevice());
+	// Buffers are filled by the transfer queue and read by the graphics queue (compute work is recorded on the graphics
+	// queue too), shared between the two families when they differ
+	const QueueFamilyIndices& indices = pdevice->getQueueFamilyIndices();
 	uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.transferFamily.value() };
+	uint32_t queueFamilyCount = indices.graphicsFamily != indices.transferFamily ? 2 : 1;
 
 	// Create the buffer
 	VkBufferCreateInfo bufferInfo{};
@@ -22,17 +25,16 @@ inline void createBuffer(Device* pdevice, VkDeviceSize deviceSize, VkBufferUsage
 	bufferInfo.size = deviceSize;
 	bufferInfo.usage = usage;
 
-	if (indices.graphicsFamily != indices.transferFamily) {
+	if (queueFamilyCount > 1) {
 		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
-		bufferInfo.queueFamilyIndexCount = 2;
+		bufferInfo.queueFamilyIndexCount = queueFamilyCount;
 		bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
-		std::cout << "Transfer Queue Index is different than Graphic Queue Index" << std::endl;
 	}
 	else {
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	}
 
-	if (vkCreateBuffer(logicalDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+	if (vkCreateBuffer(logicalDevice, &bufferInfo, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER), &buffer) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create buffer!");
 	}
 
@@ -49,7 +51,7 @@ inline void createBuffer(Device* pdevice, VkDeviceSize deviceSize, VkBufferUsage
 	allocInfo.allocationSize = memoryRequirements.size;
 	allocInfo.memoryTypeIndex = findMemoryType(pdevice, memoryRequirements.memoryTypeBits, properties);
 
-	if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+	if (vkAllocateMemory(logicalDevice, &allocInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY), &bufferMemory) != VK_SUCCESS) {
 		throw std::runtime_error("failed to allocate buffer memory");
 	}
 
@@ -67,7 +69,7 @@ inline void copyBuffer(Device* pdevice, VkCommandPool commandPool, VkBuffer srcB
 	// Transfer buffer content
 	VkBufferCopy copyRegion{};
 	copyRegion.size = size;
-	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+	pdevice->getDispatch().vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
 	// End recording and submit to the transfer queue
 	endSingleTimeCommands(logicalDevice, transferQueue, commandPool, commandBuffer);
@@ -101,7 +103,7 @@ inline void copyBufferToImage(Device* pdevice, VkCommandPool commandPool, VkBuff
 	};
 
 	// Buffer to image copy operations are enqueued using the vkCmdCopyBufferToImage function
-	vkCmdCopyBufferToImage(
+	pdevice->getDispatch().vkCmdCopyBufferToImage(
 		commandBuffer,
 		buffer,
 		image,
@@ -115,9 +117,8 @@ inline void copyBufferToImage(Device* pdevice, VkCommandPool commandPool, VkBuff
 
 // typeFilter parameter is used to specify the bit field of memory types that are suitable
 inline uint32_t findMemoryType(Device* pdevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-	// Query about the available types of memory
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(pdevice->getPhysicalDevice(), &memProperties);
+	// Available types of memory
+	const VkPhysicalDeviceMemoryProperties& memProperties = pdevice->getMemoryProperties();
 
 	// Find a memory type that is suitable according to VkMemoryPropertyFlags
 	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
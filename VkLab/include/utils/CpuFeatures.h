@@ -0,0 +1,16 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// The project is built for the baseline instruction set of its platform (SSE2), the AVX2 paths of the hot loops are
+// selected at runtime with hasAvx2() so that the binary also runs on CPUs without it.
+// MSVC emits the AVX2 intrinsics in any function, GCC and Clang only in functions marked with AVX2_FUNCTION
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+// True when both the CPU and the OS (saving of the YMM registers) support AVX2, checked once
+bool hasAvx2();
+
+#endif // CPU_FEATURES_H
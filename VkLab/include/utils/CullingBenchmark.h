@@ -0,0 +1,10 @@
+#ifndef CULLING_BENCHMARK_H
+#define CULLING_BENCHMARK_H
+
+// Throughput of the CPU frustum culling (see ObjectStore): scalar and SIMD (AVX2 when the CPU has it), on a large random
+// scene, then the hierarchical culling of the BVH with its build and refit times.
+// Prints the objects culled per microsecond of each variant (see Benchmark.h). The range queries and raycasts of the BVH
+// are checked against brute force references and timed, a mismatch is printed.
+void runCullingBenchmark();
+
+#endif // CULLING_BENCHMARK_H
@@ -1,6 +1,8 @@
 #ifndef DEBUG_MESSENGER_H
 #define DEBUG_MESSENGER_H
 
+#include "core/DispatchTable.h"
+
 #include <vulkan/vulkan.h>
 #include <iostream>
 #include <vector>
@@ -13,7 +15,7 @@ const std::vector<const char*> validationLayers = {
 class DebugMessenger {
 public:
     DebugMessenger();
-    void initialize(VkInstance instance);
+    void initialize(VkInstance instance, const InstanceDispatch* pdispatch);
     void cleanup(VkInstance instance);
 
 private:
@@ -21,6 +23,7 @@ private:
     void destroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator);
 
     VkDebugUtilsMessengerEXT debugMessenger;
+    const InstanceDispatch* pdispatch = nullptr;
 };
 
 void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
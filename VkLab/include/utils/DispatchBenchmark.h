@@ -0,0 +1,10 @@
+#ifndef DISPATCH_BENCHMARK_H
+#define DISPATCH_BENCHMARK_H
+
+#include "graphics/CommandPools.h"
+
+// Microbenchmark of the per-call cost of the loader trampolines against the device dispatch table (see DispatchTable.h):
+// records the same cheap command many times both ways and prints the time per call (see Benchmark.h).
+void runDispatchBenchmark(CommandPools* pcommandPools);
+
+#endif // DISPATCH_BENCHMARK_H
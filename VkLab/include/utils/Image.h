@@ -15,7 +15,8 @@ inline void createImage(
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory
+    VkDeviceMemory& imageMemory,
+    uint32_t mipLevels = 1
 ) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -23,7 +24,7 @@ inline void createImage(
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -32,7 +33,7 @@ inline void createImage(
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // The image will only be used by one queue family : the one that supports graphics(and therefore also) transfer operations
 
-    if (vkCreateImage(pdevice->getLogicalDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    if (vkCreateImage(pdevice->getLogicalDevice(), &imageInfo, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE), &image) != VK_SUCCESS) {
         throw std::runtime_error("failed to create image!");
     }
 
@@ -45,11 +46,33 @@ inline void createImage(
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(pdevice, memRequirements.memoryTypeBits, properties);
 
-    if (vkAllocateMemory(pdevice->getLogicalDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+    if (vkAllocateMemory(pdevice->getLogicalDevice(), &allocInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY), &imageMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate image memory!");
     }
 
     vkBindImageMemory(pdevice->getLogicalDevice(), image, imageMemory, 0);
 }
 
+// An image view describes how to access the image and which part of the image to access
+// By default the view covers the first mip level, a range of levels can be selected for mip chains
+inline VkImageView createImageView(Device* pdevice, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseMipLevel = 0, uint32_t levelCount = 1) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = aspectFlags;
+    viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    viewInfo.subresourceRange.levelCount = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView imageView;
+    if (vkCreateImageView(pdevice->getLogicalDevice(), &viewInfo, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW), &imageView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image view!");
+    }
+
+    return imageView;
+}
+
 #endif IMAGE_H
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document, enough to read the glTF description of a mesh (see MeshImporter).
+// Numbers are doubles, objects keep their members in file order and are searched linearly (glTF objects are small).
+// Parse errors throw std::runtime_error.
+class JsonValue
+{
+public:
+	enum class Type { Null, Bool, Number, String, Array, Object };
+
+	static JsonValue parse(std::string_view text);
+
+	Type getType() const;
+	bool isNull() const;
+
+	// Typed accessors, the default is returned when the value has another type
+	bool getBool(bool defaultValue = false) const;
+	double getNumber(double defaultValue = 0.0) const;
+	uint32_t getUint(uint32_t defaultValue = 0) const; // Also the default unless a whole number below 2^32
+	const std::string& getString() const; // Empty when not a string
+
+	// Arrays, an out of range index returns a null value
+	size_t size() const;
+	const JsonValue& operator[](size_t index) const;
+
+	// Objects, a missing member returns a null value
+	const JsonValue& operator[](std::string_view key) const;
+	bool contains(std::string_view key) const;
+
+private:
+	class Parser;
+
+	Type type = Type::Null;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string;
+	std::vector<JsonValue> elements;
+	std::vector<std::pair<std::string, JsonValue>> members;
+};
+
+#endif // JSON_H
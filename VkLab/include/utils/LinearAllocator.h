@@ -0,0 +1,39 @@
+#ifndef LINEAR_ALLOCATOR_H
+#define LINEAR_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Bump allocator for transient CPU data: an allocation only moves an offset in a block allocated once,
+// and everything is released at once with reset(). Nothing is destructed, so it only holds trivially destructible types.
+// The renderer keeps one per frame in flight, reset once the fence of the frame is signaled.
+class LinearAllocator
+{
+public:
+	void initialize(size_t size);
+	void cleanup();
+	void* allocate(size_t size, size_t alignment);
+	void reset();
+	size_t getUsed() const;
+	size_t getCapacity() const;
+	size_t getHighWaterMark() const; // Largest usage since initialize, to size the capacity
+
+	// Uninitialized storage for count objects of type T
+	template <typename T>
+	T* allocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>, "the linear allocator never calls destructors");
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+private:
+	std::unique_ptr<std::byte[]> memory;
+	size_t capacity = 0;
+	size_t offset = 0;
+	size_t highWaterMark = 0;
+};
+
+#endif // LINEAR_ALLOCATOR_H
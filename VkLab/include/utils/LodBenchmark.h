@@ -0,0 +1,13 @@
+#ifndef LOD_BENCHMARK_H
+#define LOD_BENCHMARK_H
+
+#include "scene/LodSelector.h"
+#include "utils/Profiler.h"
+
+// GPU throughput of the scene with the LODs off, then on (see LodSelector). Called by the main loop before each frame, it
+// switches the LODs and returns true while it needs more frames to be drawn. Each setting is measured over the frames
+// whose timestamps and statistics the Profiler read, after the frames still recorded with the previous setting.
+// Prints the primitives and the GPU time per frame of both settings (see Benchmark.h), then restores START_WITH_LODS
+bool updateLodBenchmark(LodSelector& lodSelector, const Profiler& profiler);
+
+#endif // LOD_BENCHMARK_H
@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole file. Nothing is read when it is opened: the OS loads the pages on first access,
+// straight from its page cache, so a file that is copied once from start to end (see MeshCache) is never copied to an
+// intermediate buffer of the application. The data stays valid until the file is closed.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool open(const std::string& filename); // False when the file is missing, empty or can't be mapped
+	void close();
+	bool isOpen() const;
+	std::span<const char> getData() const;
+
+private:
+	const char* pdata = nullptr;
+	size_t size = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,11 @@
+#ifndef MESH_IMPORT_BENCHMARK_H
+#define MESH_IMPORT_BENCHMARK_H
+
+#include "utils/ThreadPool.h"
+
+// Import time of a generated grid of about a million triangles (see MeshImporter), written as an OBJ and as a GLB in the
+// temporary directory. Each file is loaded on the calling thread alone, then with the pool, and the millions of
+// triangles imported per second are printed (see Benchmark.h).
+void runMeshImportBenchmark(ThreadPool* pthreadPool);
+
+#endif // MESH_IMPORT_BENCHMARK_H
@@ -0,0 +1,9 @@
+#ifndef MESH_OPTIMIZER_BENCHMARK_H
+#define MESH_OPTIMIZER_BENCHMARK_H
+
+// Self-check of the import time reordering (see MeshOptimizer) on a generated grid whose triangles and vertices are
+// shuffled: the optimized mesh must draw the same triangles with the same winding, and its simulated ACMR must be lower.
+// Prints the ACMR and ATVR before and after and the time of each pass (see Benchmark.h), a failed check is printed.
+void runMeshOptimizerBenchmark();
+
+#endif // MESH_OPTIMIZER_BENCHMARK_H
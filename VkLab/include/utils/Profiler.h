@@ -0,0 +1,73 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "core/Constant.h"
+#include "core/RendererContext.h"
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+// Measures how busy the CPU and the GPU are, to check what the on-demand main loop saves.
+// CPU: process CPU time over wall time (100% = one core fully used).
+// GPU: time between a timestamp written at the start and at the end of every frame command buffer, over wall time.
+// Host: allocations made by the driver through the HostAllocator callbacks, and the host memory it currently holds.
+// Pipeline statistics (if the device supports them): primitives assembled and fragment shader invocations per frame,
+// and the primitives per second of GPU time when the timestamps are supported too, over the frames whose timestamps and
+// statistics were both read.
+// The results are printed every PROFILER_REPORT_INTERVAL seconds and when the application exits.
+class Profiler
+{
+public:
+	// Frames whose timestamps and statistics were both read, since initialize
+	struct Throughput {
+		uint32_t frameCount = 0;
+		double gpuTime = 0.0; // Seconds
+		uint64_t primitives = 0;
+	};
+
+	void initialize();
+	void cleanup();
+
+	// Recorded in the frame command buffer, outside of the render pass
+	void cmdBeginFrame(VkCommandBuffer commandBuffer, uint32_t currentFrame);
+	void cmdEndFrame(VkCommandBuffer commandBuffer, uint32_t currentFrame);
+
+	void frameSubmitted(uint32_t currentFrame);
+	void collectFrame(uint32_t currentFrame); // Once the fence of the frame is signaled
+	void update(); // Prints the report when the interval is over
+	void report();
+
+	bool isThroughputSupported() const; // Both the timestamps and the pipeline statistics are supported
+	const Throughput& getThroughput() const;
+
+private:
+	static constexpr uint32_t QUERIES_PER_FRAME = 2;
+	static constexpr uint32_t STATISTICS_COUNT = 2; // In the order of their flag bits: primitives, fragment invocations
+
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	bool timestampsSupported = false;
+	double timestampPeriod = 0.0; // Nanoseconds per tick
+	uint64_t timestampMask = ~0ull; // Only timestampValidBits bits are meaningful
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> pendingFrames{}; // Submitted frames whose queries were not read yet
+
+	VkQueryPool statisticsQueryPool = VK_NULL_HANDLE; // One pipeline statistics query per frame slot
+	bool statisticsSupported = false;
+
+	// Current report interval
+	std::chrono::steady_clock::time_point intervalStart;
+	double intervalCpuStart = 0.0;
+	double gpuTime = 0.0; // Seconds
+	uint32_t frameCount = 0;
+	uint32_t statisticsFrameCount = 0;
+	uint64_t primitives = 0;
+	uint64_t fragmentInvocations = 0;
+	uint64_t hostAllocationsStart = 0; // Driver host allocations (see HostAllocator)
+
+	Throughput throughput;
+	Throughput intervalThroughputStart;
+};
+
+#endif // PROFILER_H
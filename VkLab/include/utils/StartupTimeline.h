@@ -0,0 +1,39 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records when every startup stage begins and ends, and on which thread, to see which stages overlap
+// and what the time to first frame is made of. Stages may be recorded from several threads.
+// The timeline is printed once, when the first frame has been presented.
+class StartupTimeline
+{
+public:
+	void initialize(); // Time zero, called on the main thread
+	size_t beginStage(const char* name); // Returns the stage to pass to endStage
+	void endStage(size_t stage);
+	void firstFramePresented();
+
+private:
+	struct Stage {
+		const char* name;
+		double start = 0.0; // Milliseconds since initialize
+		double end = 0.0;
+		bool mainThread = true;
+	};
+
+	double elapsedMilliseconds() const;
+
+	std::chrono::steady_clock::time_point startTime;
+	std::thread::id mainThreadId;
+	std::mutex stageMutex;
+	std::vector<Stage> stages;
+	bool complete = false;
+};
+
+#endif // STARTUP_TIMELINE_H
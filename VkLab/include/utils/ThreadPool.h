@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops (see MeshImporter).
+// parallelFor splits a range in batches that the workers and the calling thread take in turn, and returns once all of
+// them are done. The job is a plain function pointer with a context, so submitting work never allocates and can be used
+// in the steady state of the frame loop. Only one thread submits work at a time.
+class ThreadPool
+{
+public:
+	using Job = void (*)(void* pcontext, uint32_t begin, uint32_t end);
+
+	ThreadPool() = default;
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	void initialize(uint32_t workerCount); // 0 to use every hardware thread but the calling one
+	void cleanup();
+
+	// Runs job on [0, count) in batches of at least minBatchSize items, inline when the range is too small to be split
+	void parallelFor(uint32_t count, uint32_t minBatchSize, Job job, void* pcontext);
+
+	uint32_t getWorkerCount() const;
+
+private:
+	void workerLoop();
+	void runBatches();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition; // A new job was published, or the pool stops
+	std::condition_variable idleCondition; // The last busy worker went back to sleep
+
+	// Current job, published under the mutex. A worker only reads it while it is counted in busyWorkers, and a new job is
+	// only published once no worker is busy, so a late worker never mixes two jobs
+	Job job = nullptr;
+	void* pcontext = nullptr;
+	uint32_t count = 0;
+	uint32_t batchSize = 0;
+	std::atomic<uint32_t> nextBatch{ 0 };
+	uint32_t batchCount = 0;
+
+	uint64_t generation = 0; // Incremented for each job
+	uint32_t busyWorkers = 0;
+	bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,84 @@
+#ifndef VALIDATION_MESSAGE_SINK_H
+#define VALIDATION_MESSAGE_SINK_H
+
+#include "core/Constant.h"
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// The debug callback is called synchronously from inside the Vulkan calls, printing there slows down every frame
+// that triggers messages. The callback only copies the message into a bounded lock-free ring (multiple producers,
+// since any thread calling Vulkan may report, and one consumer) and a background thread prints it.
+// The consumer dedupes by message id (only the first VALIDATION_MESSAGES_PER_ID occurrences are printed, the messages
+// without an id number are told apart by their id name or their text), applies a global
+// rate limit and prints a summary of the counts per id when it stops. It never allocates once started.
+class ValidationMessageSink
+{
+public:
+	~ValidationMessageSink(); // Stops the consumer if the renderer didn't, e.g. when an exception skipped the cleanup
+	void start();
+	void stop(); // Drains the ring, joins the thread and prints the summary
+
+	// Called by the debug callback, never blocks: the message is dropped if the ring is full
+	bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData);
+
+private:
+	static constexpr size_t ID_NAME_SIZE = 64;
+	static constexpr size_t TEXT_SIZE = 1024; // Longer messages are truncated
+	static constexpr uint32_t POLL_INTERVAL_MS = 10;
+	static_assert((VALIDATION_SINK_CAPACITY & (VALIDATION_SINK_CAPACITY - 1)) == 0, "the ring capacity must be a power of two");
+
+	struct Message {
+		int32_t idNumber;
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+		VkDebugUtilsMessageTypeFlagsEXT type;
+		char idName[ID_NAME_SIZE];
+		char text[TEXT_SIZE];
+	};
+
+	// The sequence tells the state of the slot: equal to the position for a free slot, position + 1 once written
+	struct Slot {
+		std::atomic<uint64_t> sequence{ 0 };
+		Message message;
+	};
+
+	struct IdStats {
+		bool used = false;
+		uint64_t key = 0; // See getMessageKey
+		int32_t idNumber = 0;
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity{};
+		char idName[ID_NAME_SIZE] = {};
+		uint64_t count = 0;
+		uint64_t printed = 0;
+	};
+
+	void run();
+	bool pop(Message& message);
+	void handle(const Message& message);
+	static uint64_t getMessageKey(const Message& message);
+	IdStats* findStats(const Message& message);
+	bool takeRateLimitToken();
+	void printSummary();
+
+	std::unique_ptr<Slot[]> slots;
+	alignas(64) std::atomic<uint64_t> enqueuePosition{ 0 }; // Shared by the producers
+	alignas(64) uint64_t dequeuePosition = 0; // Consumer thread only
+	std::atomic<uint64_t> droppedCount{ 0 };
+	std::atomic<bool> running{ false };
+	std::thread consumer;
+
+	// Consumer thread only
+	std::unique_ptr<IdStats[]> idStats; // Open addressing on the message id
+	uint32_t idCount = 0;
+	uint64_t untrackedCount = 0; // Messages whose id didn't fit in the table
+	uint64_t messageCount = 0;
+	uint64_t printedCount = 0;
+	uint64_t rateLimitedCount = 0;
+	uint64_t rateWindowStart = 0; // Milliseconds
+	uint32_t rateWindowLines = 0;
+};
+
+#endif // VALIDATION_MESSAGE_SINK_H
@@ -11,7 +11,7 @@ static std::vector<char> readFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
     if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
+        throw std::runtime_error("failed to open file " + filename + "!");
     }
 
     size_t fileSize = (size_t)file.tellg();
@@ -34,7 +34,7 @@ static VkShaderModule createShaderModule(const std::vector<char>& code, VkDevice
     createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
     VkShaderModule shaderModule;
-    if (vkCreateShaderModule(*device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+    if (vkCreateShaderModule(*device, &createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE), &shaderModule) != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader module!");
     }
 
@@ -1,3 +1,14 @@
-C:/VulkanSDK/1.3.296.0/Bin/glslc.exe shader.vert -o vert.spv
-C:/VulkanSDK/1.3.296.0/Bin/glslc.exe shader.frag -o frag.spv
+REM The project compiles the shaders before the C++ code (CompileShaders target of VkLab.vcxproj), this script is only
+REM needed to recompile them without building, the list must be kept in sync with the Shader items of the project
+if "%VULKAN_SDK%"=="" set VULKAN_SDK=C:/VulkanSDK/1.3.296.0
+"%VULKAN_SDK%/Bin/glslc.exe" shader.vert -o vert.spv
+"%VULKAN_SDK%/Bin/glslc.exe" shader.vert -DOBJECT_UBO -o vert_ubo.spv
+"%VULKAN_SDK%/Bin/glslc.exe" shader.frag -o frag.spv
+"%VULKAN_SDK%/Bin/glslc.exe" depth.vert -o depth.spv
+"%VULKAN_SDK%/Bin/glslc.exe" depth.vert -DOBJECT_UBO -o depth_ubo.spv
+"%VULKAN_SDK%/Bin/glslc.exe" hiz.comp -o hiz.spv
+"%VULKAN_SDK%/Bin/glslc.exe" cull.comp -o cull.spv
+"%VULKAN_SDK%/Bin/glslc.exe" cluster_cull.comp -o cluster_cull.spv
+"%VULKAN_SDK%/Bin/glslc.exe" --target-env=vulkan1.1 --target-spv=spv1.4 meshlet.task -o meshlet_task.spv
+"%VULKAN_SDK%/Bin/glslc.exe" --target-env=vulkan1.1 --target-spv=spv1.4 meshlet.mesh -o meshlet_mesh.spv
 pause
\ No newline at end of file
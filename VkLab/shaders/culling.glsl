@@ -0,0 +1,72 @@
+// Culling tests of a bounding sphere against the view frustum and the Hi-Z pyramid, shared by the culling shaders
+// (cull.comp for the objects, cluster_cull.comp for the meshlets)
+
+// Camera of the frame and size of the pyramid, the header of the culling inputs (CullCamera on the CPU)
+struct CullCamera {
+    mat4 view;
+    vec4 projection; // proj[0][0], proj[1][1], proj[2][2], proj[3][2]
+    uvec2 depthExtent;
+    float nearPlane;
+    uint pyramidLevelCount;
+};
+
+// The view space looks down -Z, viewDistance is the distance in front of the camera (-z)
+// The side planes of the symmetric frustum go through the eye: a point is inside when |x| * proj[0][0] <= -z
+bool isInFrustum(CullCamera camera, vec3 center, float viewDistance, float radius) {
+    float scaleX = abs(camera.projection.x);
+    float scaleY = abs(camera.projection.y); // Negative, the Y axis is flipped for Vulkan
+    bool visible = viewDistance + radius > camera.nearPlane;
+    visible = visible && (viewDistance - abs(center.x) * scaleX) * inversesqrt(1.0 + scaleX * scaleX) > -radius;
+    visible = visible && (viewDistance - abs(center.y) * scaleY) * inversesqrt(1.0 + scaleY * scaleY) > -radius;
+    return visible; // The far plane is left to the clipping
+}
+
+// Screen rectangle of the sphere from its tangent planes (Mara and McGuire 2013, "2D Polyhedral Bounds of a Clipped,
+// Perspective-Projected 3D Sphere"), in [0, 1] texture coordinates. The sphere must be entirely in front of the near plane
+vec4 projectSphere(CullCamera camera, vec3 center, float viewDistance, float radius) {
+    vec2 cx = vec2(center.x, viewDistance);
+    vec2 vx = vec2(sqrt(dot(cx, cx) - radius * radius), radius);
+    vec2 minX = mat2(vx.x, vx.y, -vx.y, vx.x) * cx;
+    vec2 maxX = mat2(vx.x, -vx.y, vx.y, vx.x) * cx;
+
+    vec2 cy = vec2(center.y, viewDistance);
+    vec2 vy = vec2(sqrt(dot(cy, cy) - radius * radius), radius);
+    vec2 minY = mat2(vy.x, vy.y, -vy.y, vy.x) * cy;
+    vec2 maxY = mat2(vy.x, -vy.y, vy.y, vy.x) * cy;
+
+    // Normalized device coordinates, the flipped Y axis swaps the bounds
+    vec2 x = vec2(minX.x / minX.y, maxX.x / maxX.y) * camera.projection.x;
+    vec2 y = vec2(minY.x / minY.y, maxY.x / maxY.y) * camera.projection.y;
+    vec4 rect = vec4(min(x.x, x.y), min(y.x, y.y), max(x.x, x.y), max(y.x, y.y));
+
+    return clamp(rect * 0.5 + 0.5, 0.0, 1.0);
+}
+
+// Hidden when the nearest point of the sphere is behind the farthest depth of the pyramid texels covering its rectangle
+bool isOccluded(CullCamera camera, sampler2D pyramid, vec3 center, float viewDistance, float radius) {
+    vec4 rect = projectSphere(camera, center, viewDistance, radius) * vec4(camera.depthExtent, camera.depthExtent); // In depth buffer pixels
+    vec2 size = rect.zw - rect.xy;
+
+    // A texel of level L covers 2^(L+1) pixels: the first level where the rectangle spans at most 2x2 texels
+    float level = max(ceil(log2(max(max(size.x, size.y), 1.0))) - 1.0, 0.0);
+    level = min(level, float(camera.pyramidLevelCount - 1));
+    float texelSize = exp2(level + 1.0);
+
+    ivec2 lastTexel = textureSize(pyramid, int(level)) - 1;
+    ivec2 minTexel = clamp(ivec2(rect.xy / texelSize), ivec2(0), lastTexel);
+    ivec2 maxTexel = clamp(ivec2(rect.zw / texelSize), ivec2(0), lastTexel);
+
+    float pyramidDepth = 0.0;
+    for (int y = minTexel.y; y <= maxTexel.y; y++) {
+        for (int x = minTexel.x; x <= maxTexel.x; x++) {
+            pyramidDepth = max(pyramidDepth, texelFetch(pyramid, ivec2(x, y), int(level)).r);
+        }
+    }
+
+    // Depth of the nearest point, through the same projection as the vertex shaders (clip w is the distance). The projection
+    // maps [near, far] to [0, 1] (glm::perspectiveRH_ZO), the range of the depth buffer and of the pyramid
+    float nearest = viewDistance - radius;
+    float sphereDepth = (camera.projection.z * -nearest + camera.projection.w) / nearest;
+
+    return sphereDepth > pyramidDepth;
+}
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Depth pre-pass: same transform as shader.vert, but only the positions are read and nothing is passed to a fragment shader
+
+// Set 0 - view data, bound once per frame
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} frame;
+
+#ifdef OBJECT_UBO
+layout(set = 2, binding = 0) uniform ObjectUniformBufferObject {
+#else
+layout(push_constant) uniform ObjectPushConstants {
+#endif
+    mat4 model;
+    uint materialIndex;
+    uint instanceOffset;
+} object;
+
+// Vertex inputs of PositionVertexLayout: 16-bit normalized, dequantized by the model matrix
+#define VERTEX_INPUT(LOCATION, TYPE, NAME) layout(location = LOCATION) in TYPE NAME;
+#include "position_vertex_inputs.glsl"
+#undef VERTEX_INPUT
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition.xyz, 1.0);
+}
@@ -0,0 +1,6 @@
+// Vertex inputs of MeshVertexLayout, included by vertex_layout.glsl as GLSL declarations and by VertexLayout.cpp,
+// which checks at compile time that they match the layout
+VERTEX_INPUT(0, vec4, inPosition)
+VERTEX_INPUT(1, vec2, inNormal)
+VERTEX_INPUT(2, vec2, inTexCoord)
+VERTEX_INPUT(3, vec4, inColor)
@@ -0,0 +1,45 @@
+// Data of the meshlets and of the objects split in meshlets by the ClusterCuller, shared by the cluster culling and the
+// mesh shaders. The layouts match Meshlet (Mesh.h), ClusterFrameData and ClusterObject (ClusterCuller.h)
+
+#include "culling.glsl"
+
+const uint MAX_CLUSTER_OBJECTS = 64; // ClusterCuller::MAX_CLUSTER_OBJECTS
+
+// Bits of the visibility written by cluster_cull.comp for each meshlet of each slot
+const uint MESHLET_VISIBLE = 1; // At the last culling, so drawn by the next early phase
+const uint MESHLET_DRAWN_EARLY = 2; // By the early phase of the current frame
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+struct Meshlet {
+    vec4 sphere; // Object space center and radius
+    vec4 cone; // Average normal and cutoff, 1 when the meshlet can't be culled by its cone
+    uint firstIndex;
+    uint triangleCount;
+    uint firstVertex;
+    uint vertexCount;
+};
+
+struct ClusterObject {
+    mat4 model;
+    float scale; // Largest axis scale of the model
+    uint active; // 0 for a free slot, it draws nothing
+    uint coneCulling; // Uniform scale without mirroring: the cones stay valid
+    uint materialIndex;
+};
+
+// Header of the input of the frame, the objects follow it
+struct ClusterFrame {
+    CullCamera camera;
+    mat4 viewProjection;
+    mat4 positionDequantization; // Object space from the 16-bit positions
+    uint meshletCount;
+    uint drawCommands; // 0 with mesh shaders, which only read the visibility
+};
@@ -0,0 +1,45 @@
+// Set 4 of the mesh shader pipelines (MESHLET_SET), one set per frame in flight (see ClusterCuller)
+
+#include "meshlet.glsl"
+
+layout(std430, set = 4, binding = 0) readonly buffer ClusterInput {
+    ClusterFrame frame;
+    ClusterObject objects[];
+} clusters;
+
+layout(std430, set = 4, binding = 1) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+// Vertices of each meshlet in the vertex buffer
+layout(std430, set = 4, binding = 2) readonly buffer MeshletVertices {
+    uint meshletVertices[];
+};
+
+// 3 local vertex indices of 8 bits per triangle
+layout(std430, set = 4, binding = 3) readonly buffer MeshletTriangles {
+    uint meshletTriangles[];
+};
+
+// The vertex buffer, MeshVertexLayout read as words
+layout(std430, set = 4, binding = 4) readonly buffer Vertices {
+    uint vertexWords[];
+};
+
+// Visibility of the meshlets of each slot written by cluster_cull.comp (MESHLET_VISIBLE and MESHLET_DRAWN_EARLY)
+layout(std430, set = 4, binding = 5) readonly buffer MeshletVisibility {
+    uint meshletVisibility[];
+};
+
+// Per-draw data: the slot of the object in the ClusterCuller and the phase, everything else is read from its ClusterObject
+layout(push_constant) uniform MeshletPushConstants {
+    uint slot;
+    uint latePhase;
+} draw;
+
+const uint TASK_GROUP_SIZE = 32; // Meshlets per task workgroup, must match ClusterCuller::TASK_GROUP_SIZE
+
+// Meshlets a task workgroup hands to the mesh workgroups it launches
+struct MeshletPayload {
+    uint meshletIndices[TASK_GROUP_SIZE];
+};
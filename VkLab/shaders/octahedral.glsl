@@ -0,0 +1,8 @@
+// Inverse of the octahedral mapping of NormalOctahedral16::encode
+vec3 decodeOctahedral(vec2 octahedral) {
+    vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    float fold = max(-normal.z, 0.0); // Lower half: unfold it back over the diagonals
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
@@ -0,0 +1,3 @@
+// Vertex inputs of PositionVertexLayout, included by depth.vert as GLSL declarations and by VertexLayout.cpp,
+// which checks at compile time that they match the layout
+VERTEX_INPUT(0, vec4, inPosition)
@@ -1,9 +1,35 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require // Runtime sized descriptor arrays
+
+const uint MAX_MATERIALS = 256; // Must match Constant.h
+
+struct Material {
+    vec4 baseColor;
+    uint textureIndex;
+};
+
+// Set 1 - material table, bound once per frame
+layout(set = 1, binding = 0) uniform MaterialUniformBufferObject {
+    Material materials[MAX_MATERIALS];
+};
+
+// Set 3 - global bindless texture table, see BindlessTextureSet
+layout(set = 3, binding = 0) uniform texture2D textures[];
+layout(set = 3, binding = 1) uniform sampler samplers[];
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragMaterialIndex;
+layout(location = 3) in vec3 fragNormal;
 
 layout(location = 0) out vec4 outColor;
 
+const vec3 LIGHT_DIRECTION = normalize(vec3(0.3, 0.5, 1.0)); // Towards the light, in world space
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    // The material index is the same for the whole draw, dynamic indexing is enough (no nonuniformEXT)
+    Material material = materials[fragMaterialIndex];
+    // Half-Lambert: the side facing away from the light stays visible instead of turning black
+    float lighting = dot(normalize(fragNormal), LIGHT_DIRECTION) * 0.5 + 0.5;
+    outColor = texture(sampler2D(textures[material.textureIndex], samplers[0]), fragTexCoord) * material.baseColor * vec4(fragColor * lighting, 1.0);
 }
\ No newline at end of file
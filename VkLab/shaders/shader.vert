@@ -1,17 +1,39 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+// Set 0 - view data, bound once per frame
+layout(set = 0, binding = 0) uniform FrameUniformBufferObject {
     mat4 view;
     mat4 proj;
-} ubo;
+} frame;
+
+// Per-draw data, pushed by default. Compiled with OBJECT_UBO (vert_ubo.spv) for devices
+// whose maxPushConstantsSize is too small: the same block is then read from a dynamic UBO at set 2
+#ifdef OBJECT_UBO
+layout(set = 2, binding = 0) uniform ObjectUniformBufferObject {
+#else
+layout(push_constant) uniform ObjectPushConstants {
+#endif
+    mat4 model;
+    uint materialIndex;
+    uint instanceOffset;
+} object;
 
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec3 inColor;
+#include "vertex_layout.glsl"
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterialIndex;
+layout(location = 3) out vec3 fragNormal;
+
+// Must match the depth pre-pass (depth.vert) bit for bit, the main pass tests the depth with EQUAL
+invariant gl_Position;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = frame.proj * frame.view * object.model * vec4(inPosition.xyz, 1.0);
+    fragColor = inColor.rgb;
+    fragTexCoord = inTexCoord;
+    fragMaterialIndex = object.materialIndex;
+    // World space normal, the model matrices have no non-uniform scale so the inverse transpose isn't needed
+    fragNormal = mat3(object.model) * decodeOctahedral(inNormal);
 }
\ No newline at end of file
@@ -0,0 +1,8 @@
+// Vertex inputs of MeshVertexLayout (see VertexLayout.h)
+#define VERTEX_INPUT(LOCATION, TYPE, NAME) layout(location = LOCATION) in TYPE NAME;
+#include "mesh_vertex_inputs.glsl"
+#undef VERTEX_INPUT
+
+// inPosition is 16-bit normalized, its dequantization is folded in the model matrix: inPosition.xyz is used as is
+
+#include "octahedral.glsl"
@@ -1,4 +1,5 @@
 #include "core/Device.h"
+#include "core/Constant.h"
 
 Device::Device() {
     physicalDevice = VK_NULL_HANDLE;
@@ -16,7 +17,7 @@ void Device::initialize(VkInstance instance) {
 
 void Device::cleanup() {
     if (device != VK_NULL_HANDLE) {
-        vkDestroyDevice(device, nullptr);
+        vkDestroyDevice(device, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE));
     }
     device = VK_NULL_HANDLE;
 }
@@ -50,16 +51,25 @@ void Device::pickPhysicalDevice(VkInstance instance) {
         }
     }
 
-#ifdef _DEBUG
-    VkPhysicalDeviceProperties deviceProperties;
-    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
-    std::cout << "Selected physical device: " << deviceProperties.deviceName << std::endl;
-    std::cout << "API Version: " << deviceProperties.apiVersion << std::endl;
-#endif
-
     if (physicalDevice == VK_NULL_HANDLE) {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
+
+    // Everything the other modules need to know about the selected GPU is queried here once
+    // (buffer creation, command pools, swap chain recreation... used to query it again every time)
+    queueFamilyIndices = findQueueFamilies(physicalDevice);
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    queueFamilyProperties.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+#ifdef _DEBUG
+    std::cout << "Selected physical device: " << properties.deviceName << std::endl;
+    std::cout << "API Version: " << properties.apiVersion << std::endl;
+#endif
 }
 
 // Creates a Vulkan logical device for the selected GPU.
@@ -67,8 +77,8 @@ void Device::createLogicalDevice() {
     // Next, we need to have multiple VkDeviceQueueCreateInfo structs to create a queue from both families.
     // Create a set of all unique queue families that are necessary for the required queues
     
-    // Store needed queue family indices
-    QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+    // Needed queue family indices (found when the physical device was picked)
+    const QueueFamilyIndices& indices = queueFamilyIndices;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {
@@ -87,7 +97,42 @@ void Device::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures deviceFeatures{};
+    // Descriptor indexing features needed by the bindless texture set (non uniform indexing of a partially bound,
+    // update-after-bind, runtime sized array of sampled images). They are chained through VkPhysicalDeviceFeatures2
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures{};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &indexingFeatures;
+    deviceFeatures.features.shaderSampledImageArrayDynamicIndexing = VK_TRUE; // Texture index read from the material UBO
+
+    // Optional features, only enabled when supported
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+    deviceFeatures.features.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery; // Fragment invocation counts (see Profiler)
+    deviceFeatures.features.multiDrawIndirect = supportedFeatures.multiDrawIndirect; // One indirect call per meshlet range (see ClusterCuller)
+    enabledFeatures = deviceFeatures.features;
+
+    std::vector<const char*> extensions = deviceExtensions;
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+    meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    meshShadersEnabled = USE_MESH_SHADERS && checkMeshShaderSupport(physicalDevice);
+    if (meshShadersEnabled) {
+        meshShaderFeatures.taskShader = VK_TRUE;
+        meshShaderFeatures.meshShader = VK_TRUE;
+        meshShaderFeatures.pNext = deviceFeatures.pNext;
+        deviceFeatures.pNext = &meshShaderFeatures;
+        extensions.insert(extensions.end(), meshShaderExtensions.begin(), meshShaderExtensions.end());
+    }
+    drawIndirectCountEnabled = checkDeviceExtensionSupport(physicalDevice, drawIndirectCountExtensions);
+    if (drawIndirectCountEnabled) {
+        extensions.insert(extensions.end(), drawIndirectCountExtensions.begin(), drawIndirectCountExtensions.end());
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -95,10 +140,12 @@ void Device::createLogicalDevice() {
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-    createInfo.pEnabledFeatures = &deviceFeatures;
+    // When features are given through pNext, pEnabledFeatures must be null
+    createInfo.pNext = &deviceFeatures;
+    createInfo.pEnabledFeatures = nullptr;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -109,7 +156,7 @@ void Device::createLogicalDevice() {
     }
 
     // Create logical device
-    if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
+    if (vkCreateDevice(physicalDevice, &createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE), &device) != VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
     }
 
@@ -117,6 +164,8 @@ void Device::createLogicalDevice() {
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
     vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
+
+    dispatch.load(device, meshShadersEnabled, drawIndirectCountEnabled);
 }
 
 VkPhysicalDevice Device::getPhysicalDevice() {
@@ -139,6 +188,38 @@ VkQueue Device::getTransferQueue() {
     return transferQueue;
 }
 
+const DeviceDispatch& Device::getDispatch() {
+    return dispatch;
+}
+
+const QueueFamilyIndices& Device::getQueueFamilyIndices() {
+    return queueFamilyIndices;
+}
+
+const VkPhysicalDeviceProperties& Device::getProperties() {
+    return properties;
+}
+
+const VkPhysicalDeviceMemoryProperties& Device::getMemoryProperties() {
+    return memoryProperties;
+}
+
+const VkPhysicalDeviceFeatures& Device::getEnabledFeatures() {
+    return enabledFeatures;
+}
+
+bool Device::hasMeshShaders() {
+    return meshShadersEnabled;
+}
+
+bool Device::hasDrawIndirectCount() {
+    return drawIndirectCountEnabled;
+}
+
+const std::vector<VkQueueFamilyProperties>& Device::getQueueFamilyProperties() {
+    return queueFamilyProperties;
+}
+
 // Checks if the given physical device meets the requirements.
 bool isDeviceSuitable(VkPhysicalDevice physicalDevice) {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
@@ -151,7 +232,9 @@ bool isDeviceSuitable(VkPhysicalDevice physicalDevice) {
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate;
+    bool descriptorIndexingSupported = extensionsSupported && checkDescriptorIndexingSupport(physicalDevice);
+
+    return indices.isComplete() && extensionsSupported && swapChainAdequate && descriptorIndexingSupported;
 }
 
 // Finds queue families that support required operations.
@@ -196,15 +279,15 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice) {
     return indices;
 }
 
-// Checks if the given physical device supports necessary extensions
-bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice) {
+// Checks if the given physical device supports the given extensions, the necessary ones by default
+bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<const char*>& extensions) {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
 
     std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
     for (const auto& extension : availableExtensions) {
         requiredExtensions.erase(extension.extensionName);
@@ -213,6 +296,40 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice) {
     return requiredExtensions.empty();
 }
 
+// Checks if the given physical device supports the descriptor indexing features used by the bindless texture set
+bool checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures{};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
+
+    return deviceFeatures.features.shaderSampledImageArrayDynamicIndexing &&
+        indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+        indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+        indexingFeatures.descriptorBindingPartiallyBound &&
+        indexingFeatures.runtimeDescriptorArray;
+}
+
+// Checks if the given physical device supports the extensions and the features of the mesh shader path
+bool checkMeshShaderSupport(VkPhysicalDevice physicalDevice) {
+    if (!checkDeviceExtensionSupport(physicalDevice, meshShaderExtensions)) {
+        return false;
+    }
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+    meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures{};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &meshShaderFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
+
+    return meshShaderFeatures.taskShader && meshShaderFeatures.meshShader;
+}
+
 // Checks physical device and surface support capabilities
 SwapChainSupportDetails querySwapChainSupport(const VkPhysicalDevice device, const VkSurfaceKHR surface) {
     SwapChainSupportDetails details;
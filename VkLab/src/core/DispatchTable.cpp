@@ -0,0 +1,30 @@
+#include "core/DispatchTable.h"
+
+#include <string>
+
+void DeviceDispatch::load(VkDevice device, bool meshShaders, bool drawIndirectCount) {
+    // Every function of the table belongs to the core API or to an enabled extension, so a null pointer is an error
+#define VKLAB_LOAD_FUNCTION(name) \
+    name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+    if (name == nullptr) { \
+        throw std::runtime_error(std::string("failed to load device function ") + #name + "!"); \
+    }
+
+    VKLAB_DEVICE_FUNCTIONS(VKLAB_LOAD_FUNCTION)
+    if (meshShaders) {
+        VKLAB_MESH_SHADER_FUNCTIONS(VKLAB_LOAD_FUNCTION)
+    }
+    if (drawIndirectCount) {
+        VKLAB_DRAW_INDIRECT_COUNT_FUNCTIONS(VKLAB_LOAD_FUNCTION)
+    }
+
+#undef VKLAB_LOAD_FUNCTION
+}
+
+void InstanceDispatch::load(VkInstance instance) {
+#define VKLAB_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+
+    VKLAB_INSTANCE_EXTENSION_FUNCTIONS(VKLAB_LOAD_FUNCTION)
+
+#undef VKLAB_LOAD_FUNCTION
+}
@@ -0,0 +1,111 @@
+#include "core/FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+void FramePacer::initialize(PacingMode pacingMode) {
+    setMode(pacingMode);
+    inputSampleTime = Clock::now();
+    intervalStart = Clock::now();
+}
+
+PacingMode FramePacer::getMode() {
+    return mode;
+}
+
+// The caller must wait for the device to be idle and recreate the swap chain, the present mode and the frame count change
+void FramePacer::setMode(PacingMode pacingMode) {
+    mode = pacingMode;
+    nextFrameStart = Clock::now();
+}
+
+uint32_t FramePacer::getFramesInFlight() {
+    return mode == PacingMode::LATENCY ? 1 : MAX_FRAMES_IN_FLIGHT;
+}
+
+std::vector<VkPresentModeKHR> FramePacer::getPresentModePreference() {
+    if (mode == PacingMode::LATENCY) {
+        return { VK_PRESENT_MODE_FIFO_KHR };
+    }
+    // MAILBOX replaces the queued image instead of tearing, IMMEDIATE doesn't wait for the vertical blank at all
+    return { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+}
+
+// Start frames at a fixed rate. Waiting here rather than in vkAcquireNextImageKHR/vkQueuePresentKHR keeps the input
+// sampling and the recording of the frame as close as possible to the moment it is displayed
+void FramePacer::waitForNextFrame() {
+    if (mode != PacingMode::LATENCY || LATENCY_MODE_TARGET_FPS <= 0.0) {
+        return;
+    }
+
+    auto framePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / LATENCY_MODE_TARGET_FPS));
+    auto now = Clock::now();
+    if (nextFrameStart > now) {
+        preciseSleepUntil(nextFrameStart);
+    }
+
+    // Don't try to catch up after a long frame (or an idle period of the on-demand loop), restart from now
+    nextFrameStart = std::max(nextFrameStart + framePeriod, Clock::now());
+}
+
+// The OS sleep is too coarse to hit a deadline (up to a scheduler tick, ~15 ms on Windows by default):
+// sleep by 1 ms steps while the remaining time is larger than what a sleep is observed to take, then spin
+void FramePacer::preciseSleepUntil(Clock::time_point deadline) {
+    while (true) {
+        double remaining = std::chrono::duration<double>(deadline - Clock::now()).count();
+        if (remaining <= sleepEstimate) {
+            break;
+        }
+
+        auto start = Clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double observed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        sleepCount++;
+        double delta = observed - sleepMean;
+        sleepMean += delta / sleepCount;
+        sleepM2 += delta * (observed - sleepMean);
+        sleepEstimate = sleepMean + std::sqrt(sleepM2 / (sleepCount - 1));
+    }
+
+    while (Clock::now() < deadline) {
+        // Spin for the last part
+    }
+}
+
+void FramePacer::markInputSampled() {
+    inputSampleTime = Clock::now();
+}
+
+void FramePacer::markSubmitted() {
+    double latency = std::chrono::duration<double>(Clock::now() - inputSampleTime).count();
+    latencySum += latency;
+    latencyMax = std::max(latencyMax, latency);
+    latencyCount++;
+
+    if (LOG_FRAME_LATENCY) {
+        std::cout << "Input to submit: " << latency * 1000.0 << " ms" << std::endl;
+    }
+}
+
+void FramePacer::update() {
+    if (PROFILER_REPORT_INTERVAL <= 0.0) {
+        return;
+    }
+    if (std::chrono::duration<double>(Clock::now() - intervalStart).count() >= PROFILER_REPORT_INTERVAL) {
+        report();
+    }
+}
+
+void FramePacer::report() {
+    if (latencyCount > 0) {
+        std::cout << "Frame pacing (" << (mode == PacingMode::LATENCY ? "latency" : "throughput") << "): input to submit "
+            << latencySum / latencyCount * 1000.0 << " ms average, " << latencyMax * 1000.0 << " ms max over " << latencyCount << " frames" << std::endl;
+    }
+
+    intervalStart = Clock::now();
+    latencySum = 0.0;
+    latencyMax = 0.0;
+    latencyCount = 0;
+}
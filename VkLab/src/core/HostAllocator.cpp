@@ -0,0 +1,249 @@
+#include "core/HostAllocator.h"
+#include "core/RendererContext.h"
+#include "core/Constant.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Bump pool for the command scope allocations of one thread. They are freed before the command that made them returns,
+    // so the pool is rewound as soon as nothing is live anymore. Frees may come from another thread, hence the atomic count;
+    // only the owning thread moves the offset.
+    struct CommandScopePool {
+        static constexpr size_t CAPACITY = 64 * 1024;
+
+        std::byte* memory = nullptr;
+        size_t offset = 0;
+        std::atomic<uint32_t> liveCount{ 0 };
+
+        ~CommandScopePool() {
+            std::free(memory);
+        }
+
+        void* allocate(size_t size) {
+            if (memory == nullptr) {
+                memory = static_cast<std::byte*>(std::malloc(CAPACITY));
+                if (memory == nullptr) {
+                    return nullptr;
+                }
+            }
+            if (liveCount.load(std::memory_order_acquire) == 0) {
+                offset = 0;
+            }
+            size = (size + 15) & ~size_t(15);
+            if (offset + size > CAPACITY) {
+                return nullptr; // Too big or too many live allocations, fall back to malloc
+            }
+            void* pointer = memory + offset;
+            offset += size;
+            liveCount.fetch_add(1, std::memory_order_relaxed);
+            return pointer;
+        }
+    };
+
+    thread_local CommandScopePool commandScopePool;
+
+    // Stored right before every returned pointer, the free callback only receives the pointer
+    struct AllocationHeader {
+        size_t size;
+        CommandScopePool* ppool; // Null if allocated with malloc
+        uint32_t offset; // From the start of the block to the returned pointer
+        uint32_t scope;
+    };
+    constexpr size_t HEADER_SIZE = (sizeof(AllocationHeader) + 15) & ~size_t(15);
+
+    AllocationHeader* getHeader(void* pmemory) {
+        return reinterpret_cast<AllocationHeader*>(static_cast<std::byte*>(pmemory) - HEADER_SIZE);
+    }
+
+    const char* getObjectTypeName(VkObjectType objectType) {
+        switch (objectType) {
+        case VK_OBJECT_TYPE_INSTANCE: return "instance";
+        case VK_OBJECT_TYPE_DEVICE: return "device";
+        case VK_OBJECT_TYPE_SEMAPHORE: return "semaphore";
+        case VK_OBJECT_TYPE_FENCE: return "fence";
+        case VK_OBJECT_TYPE_DEVICE_MEMORY: return "device memory";
+        case VK_OBJECT_TYPE_BUFFER: return "buffer";
+        case VK_OBJECT_TYPE_IMAGE: return "image";
+        case VK_OBJECT_TYPE_QUERY_POOL: return "query pool";
+        case VK_OBJECT_TYPE_IMAGE_VIEW: return "image view";
+        case VK_OBJECT_TYPE_SHADER_MODULE: return "shader module";
+        case VK_OBJECT_TYPE_PIPELINE_CACHE: return "pipeline cache";
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT: return "pipeline layout";
+        case VK_OBJECT_TYPE_RENDER_PASS: return "render pass";
+        case VK_OBJECT_TYPE_PIPELINE: return "pipeline";
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: return "descriptor set layout";
+        case VK_OBJECT_TYPE_SAMPLER: return "sampler";
+        case VK_OBJECT_TYPE_DESCRIPTOR_POOL: return "descriptor pool";
+        case VK_OBJECT_TYPE_FRAMEBUFFER: return "framebuffer";
+        case VK_OBJECT_TYPE_COMMAND_POOL: return "command pool";
+        case VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE: return "descriptor update template";
+        case VK_OBJECT_TYPE_SURFACE_KHR: return "surface";
+        case VK_OBJECT_TYPE_SWAPCHAIN_KHR: return "swap chain";
+        case VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT: return "debug messenger";
+        default: return "other";
+        }
+    }
+
+    const char* scopeNames[HostAllocator::SCOPE_COUNT] = { "command", "object", "cache", "device", "instance" };
+}
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks(VkObjectType objectType) {
+    std::lock_guard<std::mutex> lock(slotMutex);
+
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if (slots[i].objectType == objectType) {
+            return &slots[i].callbacks;
+        }
+    }
+
+    if (slotCount == MAX_OBJECT_TYPES) {
+        throw std::runtime_error("failed to track host allocations, too many object types!");
+    }
+
+    TypeSlot& slot = slots[slotCount++];
+    slot.objectType = objectType;
+    slot.callbacks.pUserData = &slot;
+    slot.callbacks.pfnAllocation = allocation;
+    slot.callbacks.pfnReallocation = reallocation;
+    slot.callbacks.pfnFree = deallocation;
+    slot.callbacks.pfnInternalAllocation = internalAllocation;
+    slot.callbacks.pfnInternalFree = internalFree;
+    return &slot.callbacks;
+}
+
+void* VKAPI_CALL HostAllocator::allocation(void* puserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope) {
+    if (size == 0) {
+        return nullptr;
+    }
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    size_t blockSize = HEADER_SIZE + alignment + size;
+
+    // Command scope allocations live for the duration of a single Vulkan call
+    CommandScopePool* ppool = nullptr;
+    std::byte* pblock = nullptr;
+    if (POOL_COMMAND_SCOPE_ALLOCATIONS && allocationScope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        pblock = static_cast<std::byte*>(commandScopePool.allocate(blockSize));
+        if (pblock != nullptr) {
+            ppool = &commandScopePool;
+        }
+    }
+    if (pblock == nullptr) {
+        pblock = static_cast<std::byte*>(std::malloc(blockSize));
+        if (pblock == nullptr) {
+            return nullptr; // The driver reports VK_ERROR_OUT_OF_HOST_MEMORY
+        }
+    }
+
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(pblock) + HEADER_SIZE + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    void* pmemory = reinterpret_cast<void*>(aligned);
+
+    AllocationHeader* pheader = getHeader(pmemory);
+    pheader->size = size;
+    pheader->ppool = ppool;
+    pheader->offset = static_cast<uint32_t>(aligned - reinterpret_cast<uintptr_t>(pblock));
+    pheader->scope = allocationScope;
+
+    auto& stats = static_cast<TypeSlot*>(puserData)->scopes[allocationScope];
+    stats.allocations.fetch_add(1, std::memory_order_relaxed);
+    if (ppool != nullptr) {
+        stats.pooled.fetch_add(1, std::memory_order_relaxed);
+    }
+    uint64_t live = stats.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = stats.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !stats.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+
+    return pmemory;
+}
+
+void* VKAPI_CALL HostAllocator::reallocation(void* puserData, void* poriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope) {
+    if (poriginal == nullptr) {
+        return allocation(puserData, size, alignment, allocationScope);
+    }
+    if (size == 0) {
+        deallocation(puserData, poriginal);
+        return nullptr;
+    }
+
+    void* pmemory = allocation(puserData, size, alignment, allocationScope);
+    if (pmemory != nullptr) {
+        memcpy(pmemory, poriginal, std::min(size, getHeader(poriginal)->size));
+        deallocation(puserData, poriginal);
+    }
+    return pmemory; // On failure the original allocation must stay valid
+}
+
+void VKAPI_CALL HostAllocator::deallocation(void* puserData, void* pmemory) {
+    if (pmemory == nullptr) {
+        return;
+    }
+
+    AllocationHeader* pheader = getHeader(pmemory);
+    auto& stats = static_cast<TypeSlot*>(puserData)->scopes[pheader->scope];
+    stats.frees.fetch_add(1, std::memory_order_relaxed);
+    stats.liveBytes.fetch_sub(pheader->size, std::memory_order_relaxed);
+
+    if (pheader->ppool != nullptr) {
+        pheader->ppool->liveCount.fetch_sub(1, std::memory_order_release);
+    }
+    else {
+        std::free(static_cast<std::byte*>(pmemory) - pheader->offset);
+    }
+}
+
+void VKAPI_CALL HostAllocator::internalAllocation(void* puserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope) {
+    static_cast<TypeSlot*>(puserData)->scopes[allocationScope].internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void VKAPI_CALL HostAllocator::internalFree(void* puserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope) {
+    static_cast<TypeSlot*>(puserData)->scopes[allocationScope].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+std::array<HostAllocator::ScopeStats, HostAllocator::SCOPE_COUNT> HostAllocator::getTotals() {
+    std::lock_guard<std::mutex> lock(slotMutex);
+
+    std::array<ScopeStats, SCOPE_COUNT> totals{};
+    for (uint32_t i = 0; i < slotCount; i++) {
+        for (uint32_t scope = 0; scope < SCOPE_COUNT; scope++) {
+            const auto& stats = slots[i].scopes[scope];
+            totals[scope].allocations += stats.allocations.load(std::memory_order_relaxed);
+            totals[scope].frees += stats.frees.load(std::memory_order_relaxed);
+            totals[scope].liveBytes += stats.liveBytes.load(std::memory_order_relaxed);
+            totals[scope].peakBytes += stats.peakBytes.load(std::memory_order_relaxed); // Sum of the peaks, an upper bound
+            totals[scope].internalBytes += stats.internalBytes.load(std::memory_order_relaxed);
+            totals[scope].pooled += stats.pooled.load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+void HostAllocator::printStats() {
+    std::lock_guard<std::mutex> lock(slotMutex);
+
+    std::cout << "Host allocations by object type and scope (allocations, frees, live bytes, peak bytes):\n";
+    for (uint32_t i = 0; i < slotCount; i++) {
+        for (uint32_t scope = 0; scope < SCOPE_COUNT; scope++) {
+            const auto& stats = slots[i].scopes[scope];
+            if (stats.allocations.load() == 0 && stats.internalBytes.load() == 0) {
+                continue;
+            }
+            std::cout << "  " << getObjectTypeName(slots[i].objectType) << " / " << scopeNames[scope] << ": "
+                << stats.allocations.load() << ", " << stats.frees.load() << ", " << stats.liveBytes.load() << ", " << stats.peakBytes.load();
+            if (stats.pooled.load() > 0) {
+                std::cout << " (" << stats.pooled.load() << " pooled)";
+            }
+            if (stats.internalBytes.load() > 0) {
+                std::cout << " + " << stats.internalBytes.load() << " internal bytes";
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
+const VkAllocationCallbacks* getAllocationCallbacks(VkObjectType objectType) {
+    HostAllocator* phostAllocator = RendererContext::getInstance().phostallocator;
+    return phostAllocator != nullptr ? phostAllocator->getCallbacks(objectType) : nullptr;
+}
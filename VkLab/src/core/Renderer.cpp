@@ -1,8 +1,18 @@
 #include "Core/Renderer.h"
+#ifdef VKLAB_BENCHMARKS
+#include "utils/DispatchBenchmark.h"
+#include "utils/CullingBenchmark.h"
+#include "utils/LodBenchmark.h"
+#include "utils/MeshImportBenchmark.h"
+#include "utils/MeshOptimizerBenchmark.h"
+#endif
 
 // Main function
 void Renderer::run() {
+    r_startuptimeline.initialize();
+    size_t stage = r_startuptimeline.beginStage("Window");
     initWindow();
+    r_startuptimeline.endStage(stage);
     initVulkan();
     mainLoop();
     cleanup();
@@ -18,32 +28,181 @@ void Renderer::initWindow() {
     window = glfwCreateWindow(WIDTH, HEIGHT, "Renderer", nullptr, nullptr);
     glfwSetWindowUserPointer(window, this);
     glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback); // The window content was damaged (uncovered, restored...)
+    glfwSetWindowIconifyCallback(window, windowIconifyCallback);
+    glfwSetKeyCallback(window, keyCallback);
 }
 
 // Initializes Vulkan components needed for the application
 void Renderer::initVulkan() {
+    // Every Vulkan object created from now on reports its host allocations, it must be set before the instance
+    if (TRACK_HOST_ALLOCATIONS) {
+        RendererContext::getInstance().phostallocator = &r_hostallocator;
+    }
+    // Same for the validation messages, including the ones of the instance creation
+    if (enableValidationLayers) {
+        r_validationsink.start();
+        RendererContext::getInstance().pvalidationsink = &r_validationsink;
+    }
+
+    // The stages that only need the CPU (file reads, image decoding, mesh import) start right away on other threads,
+    // the main thread creates the instance and the device meanwhile. The mesh import is the only user of the thread pool
+    // until its result is taken
+    r_threadpool.initialize(WORKER_THREAD_COUNT);
+    auto shaderCodeFuture = std::async(std::launch::async, [this] {
+        size_t stage = r_startuptimeline.beginStage("Shader loading");
+        PipelineShaderCode shaderCode = PipelineShaderCode::load();
+        r_startuptimeline.endStage(stage);
+        return shaderCode;
+    });
+    auto textureFuture = std::async(std::launch::async, [this] {
+        size_t stage = r_startuptimeline.beginStage("Texture decoding");
+        DecodedImage image = DecodedImage::load("textures/statue.jpg");
+        r_startuptimeline.endStage(stage);
+        return image;
+    });
+    auto meshFuture = std::async(std::launch::async, [this] {
+        // A processed mesh is mapped from the cache, the source is only imported when its hash changed
+        CachedMesh cachedMesh;
+        uint64_t sourceHash = 0;
+        bool useCache = USE_MESH_CACHE && std::filesystem::exists(MODEL_PATH) && MeshCache::computeSourceHash(MODEL_PATH, sourceHash);
+        std::string cachePath = MeshCache::getCachePath(MODEL_PATH);
+        if (useCache) {
+            size_t stage = r_startuptimeline.beginStage("Mesh cache load");
+            bool cacheHit = cachedMesh.map(cachePath, sourceHash);
+            r_startuptimeline.endStage(stage);
+            if (cacheHit) {
+                std::cout << "Mesh cache: " << cachePath << " loaded" << std::endl;
+                return cachedMesh;
+            }
+        }
+
+        size_t stage = r_startuptimeline.beginStage("Mesh import");
+        MeshData mesh = std::filesystem::exists(MODEL_PATH) ? MeshImporter::load(MODEL_PATH, &r_threadpool) : MeshData::createQuad();
+        r_startuptimeline.endStage(stage);
+
+        if (OPTIMIZE_MESHES) {
+            stage = r_startuptimeline.beginStage("Mesh optimization");
+            MeshOptimizer::Report report = MeshOptimizer::optimize(mesh);
+            r_startuptimeline.endStage(stage);
+            std::cout << "Mesh optimization: ACMR " << report.before.acmr << " -> " << report.after.acmr
+                << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+        }
+        if (GENERATE_LODS) {
+            stage = r_startuptimeline.beginStage("LOD generation");
+            MeshSimplifier::generateLods(mesh);
+            r_startuptimeline.endStage(stage);
+            std::cout << "LODs:";
+            for (const MeshLod& lod : mesh.lods) {
+                std::cout << " " << lod.indexCount / 3 << " triangles (error " << lod.error << ")";
+            }
+            std::cout << std::endl;
+        }
+        stage = r_startuptimeline.beginStage("Meshlet building");
+        MeshletBuilder::build(mesh);
+        r_startuptimeline.endStage(stage);
+        if (!mesh.meshlets.empty()) {
+            std::cout << "Meshlets: " << mesh.meshlets.size() << " for " << mesh.getLods()[0].indexCount / 3 << " triangles" << std::endl;
+        }
+
+        // The upload reads the serialized streams either way, the cache file is just the same bytes
+        stage = r_startuptimeline.beginStage("Mesh serialization");
+        std::vector<char> data = MeshCache::serialize(mesh, sourceHash);
+        if (useCache && !MeshCache::write(cachePath, data)) {
+            std::cout << "Mesh cache: failed to write " << cachePath << std::endl;
+        }
+        cachedMesh.assign(std::move(data), sourceHash);
+        r_startuptimeline.endStage(stage);
+        return cachedMesh;
+    });
+
+    size_t stage = r_startuptimeline.beginStage("Instance and device");
     r_instance.initialize();
 
     if (enableValidationLayers) {
-        r_debugMessenger.initialize(r_instance.getInstance());
+        r_debugMessenger.initialize(r_instance.getInstance(), &r_instance.getDispatch());
     }
 
     createSurface();
 
     r_device.initialize(r_instance.getInstance());
     RendererContext::getInstance().pdevice = &r_device;
-    r_swapchain.initialize(window);
+    r_startuptimeline.endStage(stage);
+
+    stage = r_startuptimeline.beginStage("Swap chain and layouts");
+    r_framepacer.initialize(START_IN_LATENCY_MODE ? PacingMode::LATENCY : PacingMode::THROUGHPUT);
+    r_swapchain.initialize(window, r_framepacer.getPresentModePreference());
     r_imageviews.initialize(&r_swapchain);
-    r_renderpass.initialize(&r_swapchain);
-    r_descriptorpool.initialize();
-    r_descriptorset.initialize();
-    r_pipeline.initialize(&r_renderpass, &r_descriptorset);
-    r_framebuffer.initialize(&r_swapchain, &r_imageviews, &r_renderpass);
+    r_depthbuffer.initialize(&r_swapchain);
+    r_renderpass.initialize(&r_swapchain, r_depthbuffer.getFormat());
+    r_descriptorallocator.initialize();
+    for (auto& arena : r_framearenas) {
+        arena.initialize(FRAME_ARENA_SIZE);
+    }
+    r_descriptorset.initialize(&r_layoutcache);
+    r_bindlesstextures.initialize(&r_layoutcache);
+    r_startuptimeline.endStage(stage);
+
+    // Compiling the pipeline is the longest stage of the startup, it runs on a worker thread while the main thread uploads
+    // the texture and the geometry. It only reads the render pass and the descriptor set layouts, which no longer change,
+    // and the host allocator callbacks are thread-safe. The upload stages stay on the main thread: they share the command pools,
+    // which must be externally synchronized
+    auto pipelineFuture = std::async(std::launch::async, [this, &shaderCodeFuture] {
+        PipelineShaderCode shaderCode = shaderCodeFuture.get();
+        size_t stage = r_startuptimeline.beginStage("Pipeline compilation");
+        r_pipeline.initialize(&r_renderpass, &r_descriptorset, &r_bindlesstextures, shaderCode, !REUSE_COMMAND_BUFFERS);
+        r_startuptimeline.endStage(stage);
+    });
+
+    r_framebuffer.initialize(&r_swapchain, &r_imageviews, &r_depthbuffer, &r_renderpass);
     r_commandpools.initialize();
-    r_textureimage.initialize(r_commandpools);
-    r_buffermanager.initialize(&r_commandpools);
-    r_descriptorset.allocate(&r_descriptorpool, &r_buffermanager); // UBO must be set
-    r_commandbuffers.initialize(&r_commandpools);
+    r_profiler.initialize();
+#ifdef VKLAB_BENCHMARKS
+    runDispatchBenchmark(&r_commandpools);
+#endif
+
+    DecodedImage textureImage = textureFuture.get();
+    stage = r_startuptimeline.beginStage("Texture upload");
+    r_textureimage.initialize(r_commandpools, &r_bindlesstextures, textureImage);
+    r_startuptimeline.endStage(stage);
+
+    CachedMesh mesh = meshFuture.get();
+    stage = r_startuptimeline.beginStage("Geometry upload");
+    r_scene.initialize(r_textureimage.getTextureIndex());
+    r_buffermanager.initialize(&r_commandpools, &r_scene, mesh.getGeometry());
+    r_descriptorset.allocate(&r_descriptorallocator, &r_buffermanager); // UBO must be set
+    r_startuptimeline.endStage(stage);
+    mesh.release(); // Unmaps the cache file, the streams are on the GPU now
+
+    // Every object draws the single mesh of BufferManager, its bounds are transformed per object
+    r_objectstore.initialize(MAX_OBJECTS);
+    r_objectstore.setMeshBounds(r_buffermanager.getMeshBoundsMin(), r_buffermanager.getMeshBoundsMax());
+    r_bvh.initialize(&r_objectstore, MAX_OBJECTS);
+    visibleObjects.resize(MAX_OBJECTS);
+    // The LOD errors are projected at the bounding sphere of the culling
+    glm::vec3 farthestCorner = glm::max(glm::abs(r_buffermanager.getMeshBoundsMin()), glm::abs(r_buffermanager.getMeshBoundsMax()));
+    r_lodselector.initialize(MAX_OBJECTS, r_buffermanager.getLods(), glm::length(farthestCorner));
+    r_lodselector.setEnabled(START_WITH_LODS);
+#ifdef VKLAB_BENCHMARKS
+    runCullingBenchmark();
+    runMeshImportBenchmark(&r_threadpool);
+    runMeshOptimizerBenchmark();
+#endif
+
+    // One of the two sets of command buffers, the other one would never be submitted
+    if (!REUSE_COMMAND_BUFFERS) {
+        r_commandbuffers.initialize(&r_commandpools);
+    }
+    r_hizpyramid.initialize(&r_layoutcache, &r_depthbuffer);
+    r_occlusionculler.initialize(&r_commandpools, &r_layoutcache, &r_hizpyramid, &r_buffermanager);
+    r_clusterculler.initialize(&r_commandpools, &r_layoutcache, &r_descriptorset, &r_hizpyramid, &r_buffermanager);
+    r_clusterculler.setEnabled(START_WITH_CLUSTER_CULLING);
+
+    // Recording needs the pipeline, get() also rethrows an exception thrown by the worker
+    pipelineFuture.get();
+    if (REUSE_COMMAND_BUFFERS) {
+        r_commandbuffercache.initialize(&r_commandpools, static_cast<uint32_t>(r_swapchain.getSwapChainImages().size()));
+    }
 
     createSyncObjects();
 }
@@ -51,12 +210,171 @@ void Renderer::initVulkan() {
 // Runs the main event loop of the application.
 void Renderer::mainLoop() {
     while (!glfwWindowShouldClose(window)) {
+        if (isSuspended()) {
+            // Nothing can be seen: block until an event (restore, resize, close) instead of presenting to a hidden window
+            glfwWaitEvents();
+            continue;
+        }
+
+#ifdef VKLAB_BENCHMARKS
+        if (updateLodBenchmark(r_lodselector, r_profiler)) {
+            requestRedraw(); // The measure needs a steady stream of frames
+        }
+#endif
+        if (RENDER_ON_DEMAND && !needsRedraw()) {
+            // The presented image is still valid, sleep until an event arrives or the timeout expires
+            glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+            r_profiler.update();
+            continue;
+        }
+
+        if (pacingModeChangeRequested) {
+            applyPacingMode();
+        }
+
+        r_framepacer.waitForNextFrame();
         glfwPollEvents();
+        r_framepacer.markInputSampled();
+
+        // Cleared before drawing: anything invalidating the image while drawing (swap chain recreation) requests another frame
+        redrawRequested = false;
+        if (r_scene.getVersion() != drawnSceneVersion) {
+            steadyFrameCount = 0; // New objects grow the containers of the frame (draw list)
+        }
+        drawnSceneVersion = r_scene.getVersion();
+        drawnViewVersion = r_scene.getViewVersion();
+        uint64_t allocationsBefore = getHeapAllocationCount();
         drawFrame();
+        checkFrameAllocations(allocationsBefore);
+
+        r_profiler.update();
+        r_framepacer.update();
     }
 
     // We should wait for the logical device to finish operations before exiting mainLoop and destroying the window
     vkDeviceWaitIdle(RendererContext::getInstance().pdevice->getLogicalDevice());
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        r_profiler.collectFrame(i);
+    }
+    r_profiler.report();
+    if (TRACK_HOST_ALLOCATIONS) {
+        r_hostallocator.printStats();
+    }
+    r_framepacer.report();
+
+#ifdef _DEBUG
+    const auto& stats = r_commandrecorder.getStats();
+    std::cout << "Command recorder: " << stats.issued << " calls issued, " << stats.elided << " redundant calls elided" << std::endl;
+    if (REUSE_COMMAND_BUFFERS) {
+        std::cout << "Command buffers: " << r_commandbuffercache.getRecordedCount() << " recorded, " << r_commandbuffercache.getReusedCount() << " reused" << std::endl;
+    }
+#endif
+}
+
+// Minimized or hidden window: there is no image to show (GLFW doesn't expose occlusion by other windows)
+bool Renderer::isSuspended() {
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    return glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE) || width == 0 || height == 0;
+}
+
+// Switch between the throughput and the latency modes: both the present mode and the number of frames in flight change
+void Renderer::applyPacingMode() {
+    pacingModeChangeRequested = false;
+
+    r_framepacer.setMode(r_framepacer.getMode() == PacingMode::LATENCY ? PacingMode::THROUGHPUT : PacingMode::LATENCY);
+    std::cout << "Frame pacing: " << (r_framepacer.getMode() == PacingMode::LATENCY ? "latency" : "throughput") << " mode\n";
+
+    recreateSwapChain(); // Waits for the device to be idle, so every frame slot is free
+    currentFrame = 0;
+}
+
+// Once the frame loop reached its steady state, a frame must not allocate: the transient data goes to the frame arena
+// and the containers kept between frames already have their capacity
+void Renderer::checkFrameAllocations(uint64_t allocationsBefore) {
+    if (!CHECK_FRAME_ALLOCATIONS || !allocationCounterEnabled) {
+        return;
+    }
+
+    uint64_t allocations = getHeapAllocationCount() - allocationsBefore;
+    if (steadyFrameCount++ < STEADY_STATE_WARMUP_FRAMES) {
+        return;
+    }
+    if (allocations != 0) {
+        throw std::runtime_error("failed steady-state allocation check, drawFrame made " + std::to_string(allocations) + " heap allocations!");
+    }
+}
+
+// Whether the last presented image is out of date
+bool Renderer::needsRedraw() {
+    return redrawRequested ||
+        framebufferResized ||
+        r_scene.isAnimating() ||
+        r_scene.getVersion() != drawnSceneVersion ||
+        r_scene.getViewVersion() != drawnViewVersion;
+}
+
+void Renderer::requestRedraw() {
+    redrawRequested = true;
+}
+
+// Space pauses/resumes the animation, A and D orbit the camera, P switches the frame pacing mode, Z toggles the depth pre-pass,
+// O toggles the occlusion culling, L toggles the LODs, M toggles the meshlet culling
+void Renderer::handleKey(int key, int action) {
+    if (action == GLFW_RELEASE) {
+        return;
+    }
+
+    switch (key) {
+    case GLFW_KEY_SPACE:
+        if (action == GLFW_PRESS) {
+            r_scene.setAnimating(!r_scene.isAnimating());
+        }
+        break;
+    case GLFW_KEY_A:
+        r_scene.orbitCamera(-5.0f);
+        break;
+    case GLFW_KEY_D:
+        r_scene.orbitCamera(5.0f);
+        break;
+    case GLFW_KEY_Z:
+        if (action == GLFW_PRESS) {
+            depthPrepassEnabled = !depthPrepassEnabled;
+            std::cout << "Depth pre-pass: " << (depthPrepassEnabled ? "on" : "off") << "\n";
+            requestRedraw();
+        }
+        break;
+    case GLFW_KEY_O:
+        if (action == GLFW_PRESS) {
+            occlusionCullingEnabled = !occlusionCullingEnabled;
+            std::cout << "Occlusion culling: " << (occlusionCullingEnabled ? "on" : "off") << "\n";
+            requestRedraw();
+        }
+        break;
+    case GLFW_KEY_L:
+        if (action == GLFW_PRESS) {
+            // The counts are the ones of the last frame, the Profiler reports the GPU throughput of the next ones (see LodBenchmark)
+            std::cout << "LODs: " << (r_lodselector.isEnabled() ? "off" : "on") << " (last frame submitted "
+                << r_lodselector.getSubmittedTriangleCount() << " of " << r_lodselector.getFullDetailTriangleCount() << " triangles)\n";
+            r_lodselector.setEnabled(!r_lodselector.isEnabled());
+            requestRedraw();
+        }
+        break;
+    case GLFW_KEY_M:
+        if (action == GLFW_PRESS) {
+            r_clusterculler.setEnabled(!r_clusterculler.isEnabled());
+            std::cout << "Meshlet culling: " << (r_clusterculler.isEnabled() ? "on" : "off")
+                << (r_clusterculler.isSupported() ? "" : " (not supported by the mesh or the device)") << "\n";
+            requestRedraw();
+        }
+        break;
+    case GLFW_KEY_P:
+        if (action == GLFW_PRESS) {
+            pacingModeChangeRequested = true; // Applied between two frames
+        }
+        break;
+    }
 }
 
 // Cleans up all Vulkan and GLFW resources.
@@ -67,34 +385,51 @@ void Renderer::cleanup() {
 
     r_textureimage.cleanup();
     r_buffermanager.cleanup();
-    r_descriptorpool.cleanup();
+    r_clusterculler.cleanup();
+    r_occlusionculler.cleanup();
+    r_hizpyramid.cleanup();
+    r_descriptorallocator.cleanup();
+    for (auto& arena : r_framearenas) {
+        arena.cleanup();
+    }
     r_descriptorset.cleanup();
+    r_bindlesstextures.cleanup();
     r_pipeline.cleanup();
+    r_layoutcache.cleanup();
     r_renderpass.cleanup();
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroySemaphore(context.pdevice->getLogicalDevice(), renderFinishedSemaphores[i], nullptr);
-        vkDestroySemaphore(context.pdevice->getLogicalDevice(), imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(context.pdevice->getLogicalDevice(), inFlightFences[i], nullptr);
+        vkDestroySemaphore(context.pdevice->getLogicalDevice(), renderFinishedSemaphores[i], getAllocationCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        vkDestroySemaphore(context.pdevice->getLogicalDevice(), imageAvailableSemaphores[i], getAllocationCallbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        vkDestroyFence(context.pdevice->getLogicalDevice(), inFlightFences[i], getAllocationCallbacks(VK_OBJECT_TYPE_FENCE));
     }
 
+    r_commandbuffercache.cleanup(&r_commandpools);
+    r_profiler.cleanup();
     r_commandpools.cleanup();
     context.pdevice->cleanup();
+    r_threadpool.cleanup();
 
     if (enableValidationLayers) {
         r_debugMessenger.cleanup(r_instance.getInstance());
     }
 
-    vkDestroySurfaceKHR(r_instance.getInstance(), context.surface, nullptr);
+    vkDestroySurfaceKHR(r_instance.getInstance(), context.surface, getAllocationCallbacks(VK_OBJECT_TYPE_SURFACE_KHR));
     r_instance.cleanup();
 
+    // Prints the message counts per id, once nothing can report anymore
+    if (enableValidationLayers) {
+        context.pvalidationsink = nullptr;
+        r_validationsink.stop();
+    }
+
     glfwDestroyWindow(window);
     glfwTerminate();
 }
 
 // Creates a Vulkan surface for the GLFW window.
 void Renderer::createSurface() {
-    if (glfwCreateWindowSurface(r_instance.getInstance(), window, nullptr, &RendererContext::getInstance().surface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(r_instance.getInstance(), window, getAllocationCallbacks(VK_OBJECT_TYPE_SURFACE_KHR), &RendererContext::getInstance().surface) != VK_SUCCESS) {
         throw std::runtime_error("failed to create window surface!");
     }
 
@@ -122,58 +457,87 @@ void Renderer::drawFrame() {
     // until the current frame has finished executing, as we dont want to overwrite the current contents of
     // the command buffer while the GPU is using it.
     auto& context = RendererContext::getInstance();
+    const DeviceDispatch& vkd = context.pdevice->getDispatch(); // Direct entry points for everything called per frame
 
     // - Wait for the previous frame to finish
-    vkWaitForFences(context.pdevice->getLogicalDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    vkd.vkWaitForFences(context.pdevice->getLogicalDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    r_profiler.collectFrame(currentFrame);
+
+    // The GPU is done with this frame, its transient CPU data can be released all at once
+    r_framearenas[currentFrame].reset();
     
     uint32_t imageIndex;
     // Recall that the swap chain is an extension feature, so we must use a function with the vk*KHR naming convention
-    VkResult result = vkAcquireNextImageKHR(context.pdevice->getLogicalDevice(), r_swapchain.getSwapChain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    VkResult result = vkd.vkAcquireNextImageKHR(context.pdevice->getLogicalDevice(), r_swapchain.getSwapChain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
+        return; // The image index refers to the old swap chain
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) { // VK_SUBOPTIMAL_KHR is ok because we still have an image
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 
-    // Generate a new transformation every frame to make the geometry spin around
-    r_buffermanager.updateUniformBuffer(r_swapchain, currentFrame);
+    // Latency mode: sample the input as late as possible, right before the frame data is written
+    if (r_framepacer.getMode() == PacingMode::LATENCY) {
+        glfwPollEvents();
+        r_framepacer.markInputSampled();
+    }
 
-    // Only reset the fence if we are submitting work (avoid Deadlock)
-    vkResetFences(context.pdevice->getLogicalDevice(), 1, &inFlightFences[currentFrame]);
+    // Upload the view data once, then the objects whose transform or material changed (also pushed at record time on
+    // the push constant path). The per-frame copies only receive the changes they missed, so they are always kept up to date
+    r_scene.update();
+    r_buffermanager.updateUniformBuffer(&r_swapchain, currentFrame, r_scene.getViewMatrix());
+    r_buffermanager.updateObjectBuffer(currentFrame, r_scene.getEntities());
+    cullObjects();
+    VkExtent2D extent = r_swapchain.getSwapChainExtent();
+    glm::mat4 proj = BufferManager::getProjection(extent);
+    r_lodselector.update(r_scene.getEntities(), std::span(visibleObjects.data(), visibleObjectCount), r_scene.getViewMatrix(), proj, static_cast<float>(extent.height));
+    r_occlusionculler.update(currentFrame, r_scene.getEntities(), r_lodselector, r_scene.getViewMatrix(), proj);
+    r_clusterculler.update(currentFrame, r_scene.getEntities(), std::span(visibleObjects.data(), visibleObjectCount), r_lodselector, r_scene.getViewMatrix(), proj);
 
-    vkResetCommandBuffer(r_commandbuffers.getCommandBuffer(currentFrame), /*VkCommandBufferResetFlagBits*/ 0);
-    recordCommandBuffer(
-        r_commandbuffers.getCommandBuffer(currentFrame),
-        currentFrame,
-        imageIndex,
-        &r_swapchain,
-        &r_renderpass,
-        &r_descriptorset,
-        &r_pipeline,
-        &r_framebuffer,
-        &r_buffermanager
-    );
+    // Only reset the fence if we are submitting work (avoid Deadlock)
+    vkd.vkResetFences(context.pdevice->getLogicalDevice(), 1, &inFlightFences[currentFrame]);
+
+    VkCommandBuffer commandBuffer;
+    if (REUSE_COMMAND_BUFFERS) {
+        // Static frames: re-submit what was recorded for this frame slot and image if nothing it depends on changed
+        // The per-frame data reaches the GPU through the mapped uniform buffers written above
+        // The indirect draws read their LOD from the culling input, only the direct draws record it
+        uint64_t lodVersion = occlusionCullingEnabled ? 0 : r_lodselector.getVersion();
+        uint64_t clusterVersion = getClusterCuller() ? r_clusterculler.getVersion() : 0;
+        RecordingVersion version{ r_scene.getVersion(), swapchainGeneration, r_pipeline.getGeneration(), depthPrepassEnabled, occlusionCullingEnabled, visibleSetHash, lodVersion, clusterVersion };
+        commandBuffer = r_commandbuffercache.getCommandBuffer(currentFrame, imageIndex);
+        if (!r_commandbuffercache.isCurrent(currentFrame, imageIndex, version)) {
+            recordFrame(commandBuffer, imageIndex);
+            r_commandbuffercache.markRecorded(currentFrame, imageIndex, version);
+        }
+    }
+    else {
+        commandBuffer = r_commandbuffers.getCommandBuffer(currentFrame);
+        recordFrame(commandBuffer, imageIndex);
+    }
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] }; // We want to wait with writing colors to the image until its available
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT }; // so were specifying the stage of the graphics pipeline that writes to the color attachment
-    
+
     submitInfo.waitSemaphoreCount = 1;
     submitInfo.pWaitSemaphores = waitSemaphores; // Each entry in the waitStages array corresponds to the semaphore with the same index in pWaitSemaphores
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = r_commandbuffers.getCommandBufferPtr(currentFrame); // Specify which command buffers to actually submit for execution
+    submitInfo.pCommandBuffers = &commandBuffer; // Specify which command buffers to actually submit for execution
 
     VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame]}; // Specify which command buffers to actually submit for execution
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores; // Specify which semaphores to signal once the command buffer(s) have finished execution
 
-    if (vkQueueSubmit(context.pdevice->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+    if (vkd.vkQueueSubmit(context.pdevice->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    r_profiler.frameSubmitted(currentFrame);
+    r_framepacer.markSubmitted();
 
     // The last step of drawing a frame is submitting the result back to the swap chain to have it eventually show up on the screen
     // Presentation is configured through a VkPresentInfoKHR structure
@@ -191,7 +555,7 @@ void Renderer::drawFrame() {
     // With 1 swapChain, you can simply use the return value of the vkQueuePresentKHR function.
 
     // Submits the request to present an image to the swap chain.
-    result = vkQueuePresentKHR(context.pdevice->getPresentQueue(), &presentInfo);
+    result = vkd.vkQueuePresentKHR(context.pdevice->getPresentQueue(), &presentInfo);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) { // Because we want the best possible result.
         framebufferResized = false; // Ensure that the semaphores are in a consistent state, otherwise a signaled semaphore may never be properly waited upon
         recreateSwapChain();
@@ -199,9 +563,103 @@ void Renderer::drawFrame() {
     else if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image!");
     }
+    r_startuptimeline.firstFramePresented(); // Only the first call prints
 
     // advance to the next frame every time
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT; // By using the modulo (%) operator, we ensure that the frame index loops around after every MAX_FRAMES_IN_FLIGHT enqueued frames.
+    currentFrame = (currentFrame + 1) % r_framepacer.getFramesInFlight(); // By using the modulo (%) operator, we ensure that the frame index loops around after every MAX_FRAMES_IN_FLIGHT enqueued frames.
+}
+
+// Build the draw list and record the whole frame in the given command buffer
+void Renderer::recordFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    buildDrawList();
+
+    RendererContext::getInstance().pdevice->getDispatch().vkResetCommandBuffer(commandBuffer, /*VkCommandBufferResetFlagBits*/ 0);
+    recordCommandBuffer(
+        commandBuffer,
+        currentFrame,
+        imageIndex,
+        &r_swapchain,
+        &r_renderpass,
+        &r_descriptorset,
+        &r_bindlesstextures,
+        &r_pipeline,
+        &r_framebuffer,
+        &r_buffermanager,
+        &r_scene,
+        &r_drawlist,
+        &r_lodselector,
+        &r_commandrecorder,
+        &r_profiler,
+        depthPrepassEnabled,
+        occlusionCullingEnabled ? &r_occlusionculler : nullptr,
+        getClusterCuller()
+    );
+}
+
+// The meshlets are culled against the pyramid of the occlusion culling, in its second phase
+ClusterCuller* Renderer::getClusterCuller() {
+    bool clusterCulling = occlusionCullingEnabled && r_clusterculler.isSupported() && r_clusterculler.isEnabled();
+    return clusterCulling ? &r_clusterculler : nullptr;
+}
+
+// Find the objects in the view frustum with the transforms of this frame
+void Renderer::cullObjects() {
+    const EntityStore& entities = r_scene.getEntities();
+    bool sceneChanged = culledSceneVersion != r_scene.getVersion();
+
+    if (CPU_FRUSTUM_CULLING) {
+        // Only the bounds of the entities that moved are recomputed, unless entities were added
+        if (sceneChanged) {
+            r_objectstore.update(entities.getWorldTransforms());
+        }
+        else {
+            r_objectstore.update(entities.getWorldTransforms(), entities.getChangedEntities());
+        }
+        glm::mat4 viewProjection = BufferManager::getProjection(r_swapchain.getSwapChainExtent()) * r_scene.getViewMatrix();
+        Frustum frustum = Frustum::fromViewProjection(viewProjection);
+
+        if (BVH_FRUSTUM_CULLING) {
+            // Refit the paths of the entities that moved, and rebuild the tree once the refits made it too loose
+            if (sceneChanged || r_bvh.isDegraded()) {
+                r_bvh.build();
+            }
+            else if (!entities.getChangedEntities().empty()) {
+                r_bvh.refit(entities.getChangedEntities());
+            }
+            visibleObjectCount = r_bvh.cull(frustum, visibleObjects.data());
+        }
+        else {
+            visibleObjectCount = r_objectstore.cull(frustum, visibleObjects.data());
+        }
+    }
+    else {
+        visibleObjectCount = entities.size();
+        for (uint32_t i = 0; i < visibleObjectCount; i++) {
+            visibleObjects[i] = i;
+        }
+    }
+
+    // FNV-1a of the visible list: a camera move that doesn't change it keeps the recorded command buffers
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t i = 0; i < visibleObjectCount; i++) {
+        hash = (hash ^ visibleObjects[i]) * 1099511628211ull;
+    }
+    visibleSetHash = (hash ^ visibleObjectCount) * 1099511628211ull;
+    culledSceneVersion = r_scene.getVersion();
+}
+
+// Sort the draws of the frame so that the objects sharing the same state are recorded together
+void Renderer::buildDrawList() {
+    glm::mat4 view = r_scene.getViewMatrix();
+    const EntityStore& entities = r_scene.getEntities();
+
+    r_drawlist.clear();
+    for (uint32_t i : std::span(visibleObjects.data(), visibleObjectCount)) {
+        float depth = -(view * entities.getWorldTransform(i)[3]).z; // View space distance of the object origin
+        // Single pipeline and single vertex buffer for now, the material decides the order
+        r_drawlist.add(DrawList::makeKey(0, entities.getMaterialIndex(i), 0, depth), i);
+    }
+    r_drawlist.sort(&r_framearenas[currentFrame]);
 }
 
 void Renderer::createSyncObjects() {
@@ -219,9 +677,9 @@ void Renderer::createSyncObjects() {
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // To be signaled the first time we wait for it
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (vkCreateSemaphore(context.pdevice->getLogicalDevice(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(context.pdevice->getLogicalDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(context.pdevice->getLogicalDevice(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+        if (vkCreateSemaphore(context.pdevice->getLogicalDevice(), &semaphoreInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SEMAPHORE), &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(context.pdevice->getLogicalDevice(), &semaphoreInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SEMAPHORE), &renderFinishedSemaphores[i]) != VK_SUCCESS ||
+            vkCreateFence(context.pdevice->getLogicalDevice(), &fenceInfo, getAllocationCallbacks(VK_OBJECT_TYPE_FENCE), &inFlightFences[i]) != VK_SUCCESS) {
 
             throw std::runtime_error("failed to create synchronization objects for a frame!");
         }
@@ -230,6 +688,8 @@ void Renderer::createSyncObjects() {
 
 void Renderer::cleanupSwapChain() {
     r_framebuffer.cleanup();
+    r_hizpyramid.cleanupPyramid();
+    r_depthbuffer.cleanup();
     r_imageviews.cleanup();
     r_swapchain.cleanup();
 }
@@ -247,13 +707,44 @@ void Renderer::recreateSwapChain() {
 
     cleanupSwapChain();
 
-    r_swapchain.initialize(window);
+    r_swapchain.initialize(window, r_framepacer.getPresentModePreference());
     r_imageviews.initialize(&r_swapchain);
-    r_framebuffer.initialize(&r_swapchain, &r_imageviews, &r_renderpass);
+    r_depthbuffer.initialize(&r_swapchain);
+    r_framebuffer.initialize(&r_swapchain, &r_imageviews, &r_depthbuffer, &r_renderpass);
+    r_hizpyramid.createPyramid(&r_depthbuffer);
+    r_occlusionculler.bindPyramid(&r_hizpyramid);
+    r_clusterculler.bindPyramid(&r_hizpyramid);
+
+    // Recorded command buffers reference the old framebuffers, and the number of images may have changed
+    // The new images have no content yet, so the on-demand loop must draw again
+    swapchainGeneration++;
+    redrawRequested = true;
+    steadyFrameCount = 0; // Recreating the swap chain allocates
+    if (REUSE_COMMAND_BUFFERS) {
+        r_commandbuffercache.cleanup(&r_commandpools);
+        r_commandbuffercache.initialize(&r_commandpools, static_cast<uint32_t>(r_swapchain.getSwapChainImages().size()));
+    }
 }
 
 // GLFW does not know how to properly call a member function with the right this pointer to our instance
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height) {
     auto app = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
     app->framebufferResized = true;
+}
+
+static void windowRefreshCallback(GLFWwindow* window) {
+    auto app = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
+    app->requestRedraw();
+}
+
+static void windowIconifyCallback(GLFWwindow* window, int iconified) {
+    if (!iconified) {
+        auto app = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
+        app->requestRedraw();
+    }
+}
+
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    auto app = reinterpret_cast<Renderer*>(glfwGetWindowUserPointer(window));
+    app->handleKey(key, action);
 }
\ No newline at end of file
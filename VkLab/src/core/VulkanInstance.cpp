@@ -1,4 +1,5 @@
 #include "core/VulkanInstance.h"
+#include "core/HostAllocator.h"
 
 VulkanInstance::VulkanInstance() : instance(VK_NULL_HANDLE) {}
 
@@ -17,7 +18,7 @@ void VulkanInstance::initialize() {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_1; // 1.1 for vkGetPhysicalDeviceFeatures2 and VK_EXT_descriptor_indexing
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -40,14 +41,16 @@ void VulkanInstance::initialize() {
         createInfo.pNext = nullptr;
     }
 
-    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+    if (vkCreateInstance(&createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_INSTANCE), &instance) != VK_SUCCESS) {
         throw std::runtime_error("failed to create instance!");
     }
+
+    dispatch.load(instance);
 }
 
 void VulkanInstance::cleanup() {
     if (instance != VK_NULL_HANDLE) {
-        vkDestroyInstance(instance, nullptr);
+        vkDestroyInstance(instance, getAllocationCallbacks(VK_OBJECT_TYPE_INSTANCE));
     }
     instance = VK_NULL_HANDLE;
 }
@@ -56,6 +59,10 @@ VkInstance VulkanInstance::getInstance() const {
     return instance;
 }
 
+const InstanceDispatch& VulkanInstance::getDispatch() const {
+    return dispatch;
+}
+
 // Checks if the requested validation layers are supported.
 bool VulkanInstance::checkValidationLayerSupport() {
     uint32_t layerCount;
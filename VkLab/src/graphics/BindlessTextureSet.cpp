@@ -0,0 +1,195 @@
+#include "graphics/BindlessTextureSet.h"
+
+#include <algorithm>
+#include <array>
+
+void BindlessTextureSet::initialize(DescriptorLayoutCache* playoutCache) {
+    createDescriptorSetLayout(playoutCache);
+    createDescriptorPool();
+    allocateDescriptorSet();
+    createDefaultSampler();
+}
+
+void BindlessTextureSet::cleanup() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    vkDestroySampler(logicalDevice, defaultSampler, getAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER));
+    // The descriptor set is implicitly freed with its pool
+    vkDestroyDescriptorPool(logicalDevice, descriptorPool, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+
+    textureCount = 0;
+    samplerCount = 0;
+}
+
+// Write the image view in the next free slot of the texture array
+// Thanks to UPDATE_AFTER_BIND, this is valid even while the set is bound in command buffers that are still pending
+uint32_t BindlessTextureSet::registerTexture(VkImageView imageView) {
+    if (textureCount >= textureCapacity) {
+        throw std::runtime_error("failed to register texture, bindless table is full!");
+    }
+    uint32_t index = textureCount++;
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = VK_NULL_HANDLE; // Samplers live in their own array
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = BINDLESS_TEXTURE_BINDING;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(RendererContext::getInstance().pdevice->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+
+    return index;
+}
+
+uint32_t BindlessTextureSet::registerSampler(VkSampler sampler) {
+    if (samplerCount >= samplerCapacity) {
+        throw std::runtime_error("failed to register sampler, bindless table is full!");
+    }
+    uint32_t index = samplerCount++;
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = BINDLESS_SAMPLER_BINDING;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(RendererContext::getInstance().pdevice->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+
+    return index;
+}
+
+VkDescriptorSetLayout* BindlessTextureSet::getDescriptorSetLayoutPtr() {
+    return &descriptorSetLayout;
+}
+
+VkDescriptorSet* BindlessTextureSet::getDescriptorSetPtr() {
+    return &descriptorSet;
+}
+
+uint32_t BindlessTextureSet::getTextureCapacity() {
+    return textureCapacity;
+}
+
+void BindlessTextureSet::createDescriptorSetLayout(DescriptorLayoutCache* playoutCache) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+
+    // Update-after-bind descriptors have their own (usually much larger) limits, clamp the tables to them
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 deviceProperties{};
+    deviceProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    deviceProperties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(pdevice->getPhysicalDevice(), &deviceProperties);
+
+    textureCapacity = std::min({ MAX_BINDLESS_TEXTURES,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+    samplerCapacity = std::min({ MAX_BINDLESS_SAMPLERS,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+        indexingProperties.maxDescriptorSetUpdateAfterBindSamplers });
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    // Sampled images and samplers are kept separate so any texture can be combined with any sampler in the shader
+    bindings[0].binding = BINDLESS_TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = textureCapacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    bindings[1].binding = BINDLESS_SAMPLER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[1].descriptorCount = samplerCapacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // PARTIALLY_BOUND: slots that are never accessed by the shaders don't need a valid descriptor
+    // UPDATE_AFTER_BIND: new textures can be written while the set is bound by in flight command buffers
+    std::array<VkDescriptorBindingFlags, 2> bindingFlags = {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT; // Must be allocated from an update-after-bind pool
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    descriptorSetLayout = playoutCache->createDescriptorLayout(&layoutInfo);
+}
+
+// The bindless set has its own pool: update-after-bind sets can't come from the regular DescriptorAllocator pools
+void BindlessTextureSet::createDescriptorPool() {
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    poolSizes[0].descriptorCount = textureCapacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    poolSizes[1].descriptorCount = samplerCapacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1; // Only one global set, shared by every frame in flight
+
+    if (vkCreateDescriptorPool(RendererContext::getInstance().pdevice->getLogicalDevice(), &poolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+    }
+}
+
+void BindlessTextureSet::allocateDescriptorSet() {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(RendererContext::getInstance().pdevice->getLogicalDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+}
+
+// Linear filtering with repeat addressing, registered at DEFAULT_SAMPLER_INDEX
+void BindlessTextureSet::createDefaultSampler() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = VK_FALSE; // The samplerAnisotropy feature is not enabled
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(RendererContext::getInstance().pdevice->getLogicalDevice(), &samplerInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER), &defaultSampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture sampler!");
+    }
+
+    registerSampler(defaultSampler);
+}
\ No newline at end of file
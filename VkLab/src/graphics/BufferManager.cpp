@@ -1,114 +1,204 @@
 #include "graphics/BufferManager.h"
 
-void BufferManager::initialize(CommandPools* pcommandPools) {
-    createVertexBuffer(pcommandPools);
-    createIndexBuffer(pcommandPools);
+// Descriptor offsets (and dynamic offsets) into a uniform buffer must be multiples of minUniformBufferOffsetAlignment
+static VkDeviceSize alignUniformBufferSize(VkDeviceSize size) {
+    VkDeviceSize alignment = RendererContext::getInstance().pdevice->getProperties().limits.minUniformBufferOffsetAlignment;
+    if (alignment > 0) {
+        size = (size + alignment - 1) & ~(alignment - 1);
+    }
+    return size;
+}
+
+void BufferManager::initialize(CommandPools* pcommandPools, Scene* pscene, const MeshGeometry& geometry) {
+    meshBoundsMin = geometry.boundsMin;
+    meshBoundsMax = geometry.boundsMax;
+    // The same quantization the vertices were encoded with (see MeshCache::serialize)
+    quantization = VertexQuantization::fromBounds(geometry.boundsMin, geometry.boundsMax);
+    positionDequantization = quantization.getDequantization();
+    createVertexBuffer(pcommandPools, geometry);
+    createIndexBuffer(pcommandPools, geometry);
+    createPositionBuffer(pcommandPools, geometry);
+    createMeshletBuffers(pcommandPools, geometry);
     createUniformBuffer();
+    createObjectBuffer();
+    createMaterialBuffer(pscene->getMaterials());
 }
 
 // Memory that is bound to a buffer object may be freed once the buffer is no longer used
 void BufferManager::cleanup() {
     VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-    vkDestroyBuffer(logicalDevice, indexBuffer, nullptr);
-    vkFreeMemory(logicalDevice, indexBufferMemory, nullptr);
+    vkDestroyBuffer(logicalDevice, indexBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, indexBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
 
-    vkDestroyBuffer(logicalDevice, vertexBuffer, nullptr);
-    vkFreeMemory(logicalDevice, vertexBufferMemory, nullptr);
+    vkDestroyBuffer(logicalDevice, vertexBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, vertexBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+    vkDestroyBuffer(logicalDevice, positionBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, positionBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+    vkDestroyBuffer(logicalDevice, meshletBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, meshletBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, meshletVertexBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, meshletVertexBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, meshletTriangleBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, meshletTriangleBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyBuffer(logicalDevice, uniformBuffers[i], nullptr);
-        vkFreeMemory(logicalDevice, uniformBuffersMemory[i], nullptr);
+        vkDestroyBuffer(logicalDevice, uniformBuffers[i], getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, uniformBuffersMemory[i], getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+        vkDestroyBuffer(logicalDevice, objectBuffers[i], getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, objectBuffersMemory[i], getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
     }
+
+    vkDestroyBuffer(logicalDevice, materialBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, materialBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
 }
 
-// Update UBO to turn the model in the scene
-void BufferManager::updateUniformBuffer(SwapChain swapchain, uint32_t currentImage) {
-    //  Calculate the time in seconds since rendering has started with floating point accuracy
-    static auto startTime = std::chrono::high_resolution_clock::now();
+// Update the view data, once per frame
+void BufferManager::updateUniformBuffer(SwapChain* pswapchain, uint32_t currentImage, const glm::mat4& view) {
+    // Define the view and projection transformations, the model transformations are per object (see updateObjectBuffer)
+    FrameUniformBufferObject ubo{};
+    ubo.view = view; // The camera belongs to the scene
+    // Use the current swap chain extent to calculate the aspect ratio to take into account the new width and height of the window after a resize
+    ubo.proj = getProjection(pswapchain->getSwapChainExtent());
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    // We only map the uniform buffer once, so we can directly write to it without having to map again
+    memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+}
 
-    // Define the model, view and projection transformations
-    UniformBufferObject ubo{};
-    ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(10.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Accomplishes the purpose of rotation 90 degrees per second
-    ubo.view = glm::lookAt(glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Look at the geometry from above at a 45 degree angle
+glm::mat4 BufferManager::getProjection(VkExtent2D extent) {
     // Configure FOV, aspect ratio, near view plane, far view plane ..
-    // Use the current swap chain extent to calculate the aspect ratio to take into account the new width and height of the window after a resize
-    ubo.proj = glm::perspective(glm::radians(45.0f), swapchain.getSwapChainExtent().width / (float) swapchain.getSwapChainExtent().height, 0.1f, 10.0f);
+    // The clip depth of Vulkan is [0, w] where OpenGL's is [-w, w]: glm::perspective would put the near plane at about
+    // 2nf / (n + f) and leave half of the depth range unused, unless GLM_FORCE_DEPTH_ZERO_TO_ONE is defined everywhere
+    glm::mat4 proj = glm::perspectiveRH_ZO(glm::radians(CAMERA_FOV_DEGREES), extent.width / (float) extent.height, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
 
     // GLM was originally designed for OpenGL, where the Y coordinate of the clip coordinates is inverted
     // The easiest way to compensate for that is to flip the sign on the scaling factor of the Y axis in the projection matrix
     // If you dont do this, then the image will be rendered upside down
-    ubo.proj[1][1] *= -1;
+    proj[1][1] *= -1;
 
-    // We only map the uniform buffer once, so we can directly write to it without having to map again
-    memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+    return proj;
+}
 
-    // Using a UBO this way is not the most efficient way to pass frequently changing values to the shader
-    // A more efficient way to pass a small buffer of data to shaders are push constants
+// Write the per-draw data of each object at its aligned slot, the draws select their slot with a dynamic offset
+// Only the slots of this frame's copy that missed a change are written, a static scene writes nothing
+void BufferManager::updateObjectBuffer(uint32_t currentImage, const EntityStore& entities) {
+    auto pdata = static_cast<char*>(objectBuffersMapped[currentImage]);
+
+    objectUploads.markChanged(entities.getChangedEntities());
+    for (Entity entity : objectUploads.takeStaleObjects(currentImage)) {
+        ObjectUniformBufferObject object{};
+        object.model = entities.getWorldTransform(entity) * positionDequantization;
+        object.materialIndex = entities.getMaterialIndex(entity);
+        object.instanceOffset = 0;
+        memcpy(pdata + entity * objectStride, &object, sizeof(object));
+    }
 }
 
 VkBuffer BufferManager::getVertexBuffer() {
     return vertexBuffer;
 }
 
+VkBuffer BufferManager::getPositionBuffer() {
+    return positionBuffer;
+}
+
 VkBuffer BufferManager::getIndexBuffer() {
     return indexBuffer;
 }
 
-std::vector<VkBuffer> BufferManager::getUniformBuffers() {
+VkIndexType BufferManager::getIndexType() {
+    return indexType;
+}
+
+uint32_t BufferManager::getIndexCount() {
+    return indexCount;
+}
+
+std::span<const MeshLod> BufferManager::getLods() {
+    return lods;
+}
+
+glm::vec3 BufferManager::getMeshBoundsMin() {
+    return meshBoundsMin;
+}
+
+glm::vec3 BufferManager::getMeshBoundsMax() {
+    return meshBoundsMax;
+}
+
+const glm::mat4& BufferManager::getPositionDequantization() {
+    return positionDequantization;
+}
+
+std::span<const Meshlet> BufferManager::getMeshlets() {
+    return meshlets;
+}
+
+VkBuffer BufferManager::getMeshletBuffer() {
+    return meshletBuffer;
+}
+
+VkBuffer BufferManager::getMeshletVertexBuffer() {
+    return meshletVertexBuffer;
+}
+
+VkBuffer BufferManager::getMeshletTriangleBuffer() {
+    return meshletTriangleBuffer;
+}
+
+const std::vector<VkBuffer>& BufferManager::getUniformBuffers() {
     return uniformBuffers;
 }
 
-void BufferManager::createVertexBuffer(CommandPools* pcommandPools) {
-    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+const std::vector<VkBuffer>& BufferManager::getObjectBuffers() {
+    return objectBuffers;
+}
 
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+VkDeviceSize BufferManager::getObjectStride() {
+    return objectStride;
+}
 
-    // Create staging buffer
-    VkBuffer stagingBuffer; // For mapping and copying the vertex data.
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        RendererContext::getInstance().pdevice,
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // Buffer can be used as source in a memory transfer operation
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer,
-        stagingBufferMemory
-    );
+VkBuffer BufferManager::getMaterialBuffer() {
+    return materialBuffer;
+}
 
-    // Copy the vertex data to the buffer.
-    void* data;
-    // This is done by mapping the buffer memory into CPU accessible memory
-    vkMapMemory(logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-    // Memcpy the vertex data to the mapped memory and unmap it again
-    memcpy(data, vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(logicalDevice, stagingBufferMemory);
+// The vertices are already encoded to the compact layout the shaders read (see VertexLayout). The mesh shaders fetch them as a storage buffer
+void BufferManager::createVertexBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry) {
+    createDeviceLocalBuffer(pcommandPools, geometry.vertices.data(), geometry.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+}
 
-    createBuffer(
-        RendererContext::getInstance().pdevice,
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, // Buffer can be used as destination in a memory transfer operation
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, // The vertexBuffer is now allocated from a memory type that is device local
-        vertexBuffer,
-        vertexBufferMemory
-    );
+// The indices are 16 bits when every vertex can be addressed with them. The LODs follow the full mesh
+void BufferManager::createIndexBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry) {
+    indexType = geometry.indexType;
+    lods.assign(geometry.lods.begin(), geometry.lods.end());
+    indexCount = lods[0].indexCount;
+    createDeviceLocalBuffer(pcommandPools, geometry.indices.data(), geometry.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+}
 
-    copyBuffer(RendererContext::getInstance().pdevice, pcommandPools->getTransferCommandPool(), stagingBuffer, vertexBuffer, bufferSize);
+// The depth pre-pass only needs the positions: a separate stream fetches less memory per vertex than the interleaved buffer
+void BufferManager::createPositionBuffer(CommandPools* pcommandPools, const MeshGeometry& geometry) {
+    createDeviceLocalBuffer(pcommandPools, geometry.positions.data(), geometry.positions.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, positionBuffer, positionBufferMemory);
+}
 
-    vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+void BufferManager::createMeshletBuffers(CommandPools* pcommandPools, const MeshGeometry& geometry) {
+    meshlets.assign(geometry.meshlets.begin(), geometry.meshlets.end());
+    if (meshlets.empty()) {
+        return;
+    }
+    createDeviceLocalBuffer(pcommandPools, geometry.meshlets.data(), geometry.meshlets.size_bytes(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletBuffer, meshletBufferMemory);
+    createDeviceLocalBuffer(pcommandPools, geometry.meshletVertices.data(), geometry.meshletVertices.size_bytes(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletVertexBuffer, meshletVertexBufferMemory);
+    createDeviceLocalBuffer(pcommandPools, geometry.meshletTriangles.data(), geometry.meshletTriangles.size_bytes(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshletTriangleBuffer, meshletTriangleBufferMemory);
 }
 
-void BufferManager::createIndexBuffer(CommandPools* pcommandPools) {
+// Upload data that never changes to a device local buffer through a staging buffer
+void BufferManager::createDeviceLocalBuffer(CommandPools* pcommandPools, const void* pdata, VkDeviceSize bufferSize, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
     VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
     // Create staging buffer
-    VkBuffer stagingBuffer; // For mapping and copying the vertex data.
+    VkBuffer stagingBuffer; // For mapping and copying the data.
     VkDeviceMemory stagingBufferMemory;
     createBuffer(
         RendererContext::getInstance().pdevice,
@@ -119,33 +209,33 @@ void BufferManager::createIndexBuffer(CommandPools* pcommandPools) {
         stagingBufferMemory
     );
 
-    // Copy the vertex data to the buffer.
+    // Copy the data to the buffer.
     void* data;
     // This is done by mapping the buffer memory into CPU accessible memory
     vkMapMemory(logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-    // Memcpy the vertex data to the mapped memory and unmap it again
-    memcpy(data, indices.data(), (size_t)bufferSize);
+    // Memcpy the data to the mapped memory and unmap it again
+    memcpy(data, pdata, (size_t)bufferSize);
     vkUnmapMemory(logicalDevice, stagingBufferMemory);
 
     createBuffer(
         RendererContext::getInstance().pdevice,
         bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, // Buffer can be used as destination in a memory transfer operation
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, // The vertexBuffer is now allocated from a memory type that is device local
-        indexBuffer,
-        indexBufferMemory
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, // Buffer can be used as destination in a memory transfer operation
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, // The buffer is now allocated from a memory type that is device local
+        buffer,
+        bufferMemory
     );
 
-    copyBuffer(RendererContext::getInstance().pdevice, pcommandPools->getTransferCommandPool(), stagingBuffer, indexBuffer, bufferSize);
+    copyBuffer(RendererContext::getInstance().pdevice, pcommandPools->getTransferCommandPool(), stagingBuffer, buffer, bufferSize);
 
-    vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+    vkDestroyBuffer(logicalDevice, stagingBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, stagingBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
 }
 
 void BufferManager::createUniformBuffer() {
     VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-    VkDeviceSize buffersize = sizeof(UniformBufferObject);
+    VkDeviceSize buffersize = sizeof(FrameUniformBufferObject);
 
     // We need to have as many uniform buffers as we have frames in flight
     uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
@@ -168,4 +258,57 @@ void BufferManager::createUniformBuffer() {
         // Not having to map the buffer every time we need to update it increases performances, as mapping is not free
         vkMapMemory(logicalDevice, uniformBuffersMemory[i], 0, buffersize, 0, &uniformBuffersMapped[i]);
     }
+}
+
+void BufferManager::createObjectBuffer() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    objectStride = alignUniformBufferSize(sizeof(ObjectUniformBufferObject));
+    VkDeviceSize buffersize = objectStride * MAX_OBJECTS;
+    objectUploads.initialize(MAX_OBJECTS);
+
+    // Like the frame UBO, the CPU writes it every frame: one persistently mapped buffer per frame in flight
+    objectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    objectBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    objectBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        createBuffer(
+            RendererContext::getInstance().pdevice,
+            buffersize,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            objectBuffers[i],
+            objectBuffersMemory[i]
+        );
+
+        vkMapMemory(logicalDevice, objectBuffersMemory[i], 0, buffersize, 0, &objectBuffersMapped[i]);
+    }
+}
+
+void BufferManager::createMaterialBuffer(const std::vector<Material>& materials) {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    // The table is bound whole, so entries are packed with the std140 array stride (no offset alignment needed)
+    VkDeviceSize buffersize = sizeof(MaterialUniformBufferObject) * MAX_MATERIALS;
+
+    // Small and written once, so a host visible buffer is enough (no staging copy)
+    createBuffer(
+        RendererContext::getInstance().pdevice,
+        buffersize,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        materialBuffer,
+        materialBufferMemory
+    );
+
+    void* data;
+    vkMapMemory(logicalDevice, materialBufferMemory, 0, buffersize, 0, &data);
+    for (size_t i = 0; i < materials.size(); i++) {
+        MaterialUniformBufferObject material{};
+        material.baseColor = materials[i].baseColor;
+        material.textureIndex = materials[i].textureIndex;
+        memcpy(static_cast<char*>(data) + i * sizeof(MaterialUniformBufferObject), &material, sizeof(material));
+    }
+    vkUnmapMemory(logicalDevice, materialBufferMemory);
 }
\ No newline at end of file
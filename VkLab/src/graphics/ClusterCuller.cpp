@@ -0,0 +1,366 @@
+#include "graphics/ClusterCuller.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void ClusterCuller::initialize(CommandPools* pcommandPools, DescriptorLayoutCache* playoutCache, DescriptorSet* pdescriptorSet, HiZPyramid* ppyramid, BufferManager* pbufferManager) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    this->ppyramid = ppyramid;
+    meshletBuffer = pbufferManager->getMeshletBuffer();
+    meshletCount = static_cast<uint32_t>(pbufferManager->getMeshlets().size());
+    positionDequantization = pbufferManager->getPositionDequantization();
+    meshShaders = pdevice->hasMeshShaders();
+
+    // Without mesh shaders, the meshlets of an object are drawn with one multi-draw, which reads its count from the GPU
+    bool multiDraw = pdevice->getEnabledFeatures().multiDrawIndirect && pdevice->hasDrawIndirectCount() && meshletCount <= pdevice->getProperties().limits.maxDrawIndirectCount;
+    supported = meshletCount > 0 && (meshShaders || multiDraw);
+    if (!supported) {
+        return;
+    }
+
+    objectSlots.assign(MAX_OBJECTS, NO_SLOT);
+    qualifying.assign(MAX_OBJECTS, 0);
+    slotObjects.fill(NO_ENTITY);
+
+    // Binding 0: Hi-Z pyramid, 1: input of the frame, 2: meshlets, 3: early draws, 4: late draws, 5: draw counts, 6: visibility
+    VkDescriptorSetLayoutBinding bindings[COMPUTE_BINDING_COUNT]{};
+    for (uint32_t i = 0; i < COMPUTE_BINDING_COUNT; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = COMPUTE_BINDING_COUNT;
+    layoutInfo.pBindings = bindings;
+    setLayout = playoutCache->createDescriptorLayout(&layoutInfo);
+
+    cullPipeline.initialize(readFile("shaders/cluster_cull.spv"), { setLayout });
+
+    createBuffers(pcommandPools);
+
+    descriptorAllocator.initialize(MAX_FRAMES_IN_FLIGHT * 2);
+    for (auto& descriptorSet : descriptorSets) {
+        descriptorSet = descriptorAllocator.allocate(setLayout);
+    }
+    writeDescriptorSets();
+
+    if (meshShaders) {
+        for (auto& descriptorSet : meshletDescriptorSets) {
+            descriptorSet = descriptorAllocator.allocate(pdescriptorSet->getMeshletSetLayout());
+        }
+        writeMeshletDescriptorSets(pbufferManager);
+    }
+}
+
+void ClusterCuller::cleanup() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vkDestroyBuffer(logicalDevice, inputBuffers[i], getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, inputBuffersMemory[i], getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+    vkDestroyBuffer(logicalDevice, earlyDrawBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, earlyDrawBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, lateDrawBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, lateDrawBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, drawCountBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, drawCountBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, visibilityBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, visibilityBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+    descriptorAllocator.cleanup();
+    cullPipeline.cleanup();
+}
+
+// Only the pyramid binding references the swap chain resources, the sets are not in use (the device is idle)
+void ClusterCuller::bindPyramid(HiZPyramid* ppyramid) {
+    this->ppyramid = ppyramid;
+    if (supported) {
+        writeDescriptorSets();
+    }
+}
+
+bool ClusterCuller::isSupported() {
+    return supported;
+}
+
+void ClusterCuller::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool ClusterCuller::isEnabled() const {
+    return enabled;
+}
+
+bool ClusterCuller::usesMeshShaders() const {
+    return meshShaders;
+}
+
+void ClusterCuller::createBuffers(CommandPools* pcommandPools) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    VkDevice logicalDevice = pdevice->getLogicalDevice();
+
+    VkDeviceSize inputSize = sizeof(ClusterFrameData) + sizeof(ClusterObject) * MAX_CLUSTER_OBJECTS;
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        createBuffer(pdevice, inputSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, inputBuffers[i], inputBuffersMemory[i]);
+        vkMapMemory(logicalDevice, inputBuffersMemory[i], 0, inputSize, 0, &inputBuffersMapped[i]);
+    }
+
+    // The mesh shaders only read the visibility, the command buffers are only bound
+    VkDeviceSize drawSize = VkDeviceSize(DRAW_COMMAND_STRIDE) * (meshShaders ? 1 : meshletCount * MAX_CLUSTER_OBJECTS);
+    VkBufferUsageFlags drawUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    createBuffer(pdevice, drawSize, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, earlyDrawBuffer, earlyDrawBufferMemory);
+    createBuffer(pdevice, drawSize, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, lateDrawBuffer, lateDrawBufferMemory);
+    createBuffer(pdevice, sizeof(uint32_t) * 2 * MAX_CLUSTER_OBJECTS, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawCountBuffer, drawCountBufferMemory);
+
+    VkDeviceSize visibilitySize = VkDeviceSize(sizeof(uint32_t)) * meshletCount * MAX_CLUSTER_OBJECTS;
+    createBuffer(pdevice, visibilitySize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visibilityBuffer, visibilityBufferMemory);
+
+    // As for the objects: nothing was visible before the first frame
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, pcommandPools->getDrawCommandPool());
+    vkCmdFillBuffer(commandBuffer, drawCountBuffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(commandBuffer, visibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+    endSingleTimeCommands(logicalDevice, pdevice->getGraphicsQueue(), pcommandPools->getDrawCommandPool(), commandBuffer);
+}
+
+void ClusterCuller::writeDescriptorSets() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkDescriptorImageInfo pyramidInfo{};
+        pyramidInfo.sampler = ppyramid->getSampler();
+        pyramidInfo.imageView = ppyramid->getImageView();
+        pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorBufferInfo bufferInfos[COMPUTE_BINDING_COUNT - 1]{};
+        bufferInfos[0] = { inputBuffers[i], 0, VK_WHOLE_SIZE };
+        bufferInfos[1] = { meshletBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[2] = { earlyDrawBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[3] = { lateDrawBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[4] = { drawCountBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[5] = { visibilityBuffer, 0, VK_WHOLE_SIZE };
+
+        VkWriteDescriptorSet descriptorWrites[COMPUTE_BINDING_COUNT]{};
+        for (uint32_t binding = 0; binding < COMPUTE_BINDING_COUNT; binding++) {
+            descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet = descriptorSets[i];
+            descriptorWrites[binding].dstBinding = binding;
+            descriptorWrites[binding].descriptorCount = 1;
+            if (binding == 0) {
+                descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorWrites[binding].pImageInfo = &pyramidInfo;
+            }
+            else {
+                descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorWrites[binding].pBufferInfo = &bufferInfos[binding - 1];
+            }
+        }
+
+        vkUpdateDescriptorSets(logicalDevice, COMPUTE_BINDING_COUNT, descriptorWrites, 0, nullptr);
+    }
+}
+
+// Binding 0: input of the frame, 1: meshlets, 2: meshlet vertices, 3: meshlet triangles, 4: vertices, 5: visibility
+void ClusterCuller::writeMeshletDescriptorSets(BufferManager* pbufferManager) {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkDescriptorBufferInfo bufferInfos[DescriptorSet::MESHLET_BINDING_COUNT]{};
+        bufferInfos[0] = { inputBuffers[i], 0, VK_WHOLE_SIZE };
+        bufferInfos[1] = { meshletBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[2] = { pbufferManager->getMeshletVertexBuffer(), 0, VK_WHOLE_SIZE };
+        bufferInfos[3] = { pbufferManager->getMeshletTriangleBuffer(), 0, VK_WHOLE_SIZE };
+        bufferInfos[4] = { pbufferManager->getVertexBuffer(), 0, VK_WHOLE_SIZE };
+        bufferInfos[5] = { visibilityBuffer, 0, VK_WHOLE_SIZE };
+
+        VkWriteDescriptorSet descriptorWrites[DescriptorSet::MESHLET_BINDING_COUNT]{};
+        for (uint32_t binding = 0; binding < DescriptorSet::MESHLET_BINDING_COUNT; binding++) {
+            descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet = meshletDescriptorSets[i];
+            descriptorWrites[binding].dstBinding = binding;
+            descriptorWrites[binding].descriptorCount = 1;
+            descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+        }
+
+        vkUpdateDescriptorSets(logicalDevice, DescriptorSet::MESHLET_BINDING_COUNT, descriptorWrites, 0, nullptr);
+    }
+}
+
+void ClusterCuller::update(uint32_t currentFrame, const EntityStore& entities, std::span<const uint32_t> visibleObjects, const LodSelector& lodSelector, const glm::mat4& view, const glm::mat4& proj) {
+    if (!supported) {
+        return;
+    }
+
+    // The objects keep their slot while they stay visible at LOD 0, so that the recorded command buffers stay valid
+    std::fill(qualifying.begin(), qualifying.end(), 0);
+    if (enabled) {
+        for (Entity entity : visibleObjects) {
+            qualifying[entity] = lodSelector.getObjectLodLevel(entity) == 0 ? 1 : 0;
+        }
+    }
+    for (uint32_t slot = 0; slot < slotEnd; slot++) {
+        Entity entity = slotObjects[slot];
+        if (entity != NO_ENTITY && (entity >= entities.size() || !qualifying[entity])) {
+            freeSlot(slot);
+        }
+    }
+
+    uint32_t freeSlotSearch = 0;
+    for (Entity entity : visibleObjects) {
+        if (!qualifying[entity] || objectSlots[entity] != NO_SLOT) {
+            continue;
+        }
+        while (freeSlotSearch < MAX_CLUSTER_OBJECTS && slotObjects[freeSlotSearch] != NO_ENTITY) {
+            freeSlotSearch++;
+        }
+        if (freeSlotSearch == MAX_CLUSTER_OBJECTS) {
+            break; // The remaining objects are drawn as a whole
+        }
+        slotObjects[freeSlotSearch] = entity;
+        objectSlots[entity] = freeSlotSearch;
+        slotEnd = std::max(slotEnd, freeSlotSearch + 1);
+        version++;
+    }
+    while (slotEnd > 0 && slotObjects[slotEnd - 1] == NO_ENTITY) {
+        slotEnd--;
+    }
+
+    auto pdata = static_cast<char*>(inputBuffersMapped[currentFrame]);
+
+    ClusterFrameData frame{};
+    frame.camera = CullCamera::fromView(view, proj, ppyramid);
+    frame.viewProjection = proj * view;
+    frame.positionDequantization = positionDequantization;
+    frame.meshletCount = meshletCount;
+    frame.drawCommands = meshShaders ? 0 : 1;
+    memcpy(pdata, &frame, sizeof(frame));
+
+    // Every slot of the frame is rewritten: the transforms of the objects may change every frame, and there are few slots
+    auto pobjects = reinterpret_cast<ClusterObject*>(pdata + sizeof(ClusterFrameData));
+    for (uint32_t slot = 0; slot < slotEnd; slot++) {
+        ClusterObject object{};
+        Entity entity = slotObjects[slot];
+        if (entity != NO_ENTITY) {
+            const glm::mat4& model = entities.getWorldTransform(entity);
+            glm::vec3 axisScales(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])));
+            float scale = std::max({ axisScales.x, axisScales.y, axisScales.z });
+            bool uniformScale = scale - std::min({ axisScales.x, axisScales.y, axisScales.z }) <= scale * 1e-3f;
+
+            object.model = model;
+            object.scale = scale;
+            object.active = 1;
+            object.coneCulling = uniformScale && glm::dot(glm::cross(glm::vec3(model[0]), glm::vec3(model[1])), glm::vec3(model[2])) > 0.0f ? 1 : 0;
+            object.materialIndex = entities.getMaterialIndex(entity);
+        }
+        pobjects[slot] = object;
+    }
+}
+
+void ClusterCuller::freeSlot(uint32_t slot) {
+    objectSlots[slotObjects[slot]] = NO_SLOT;
+    slotObjects[slot] = NO_ENTITY;
+    version++;
+}
+
+void ClusterCuller::cmdBeginFrame(VkCommandBuffer commandBuffer) {
+    // The OcclusionCuller orders the indirect reads after the culling of the previous frame, the task shaders read the visibility
+    if (!meshShaders) {
+        return;
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    RendererContext::getInstance().pdevice->getDispatch().vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr
+    );
+}
+
+void ClusterCuller::cmdCull(VkCommandBuffer commandBuffer, uint32_t currentFrame) {
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+    if (slotEnd == 0) {
+        return;
+    }
+    VkPipelineStageFlags drawStage = meshShaders ? VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT : VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+
+    if (meshShaders) {
+        // The early draws must have read the visibility before it is overwritten (execution dependency only)
+        vkd.vkCmdPipelineBarrier(commandBuffer, drawStage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+    }
+    else {
+        // The early draws must have read their commands and counts before the counts of the dispatched slots are cleared
+        vkd.vkCmdPipelineBarrier(commandBuffer, drawStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+        vkd.vkCmdFillBuffer(commandBuffer, drawCountBuffer, getDrawCountOffset(0, false), sizeof(uint32_t) * slotEnd, 0);
+        vkd.vkCmdFillBuffer(commandBuffer, drawCountBuffer, getDrawCountOffset(0, true), sizeof(uint32_t) * slotEnd, 0);
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    // One row of workgroups per slot
+    vkd.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.getPipeline());
+    vkd.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.getPipelineLayout(), 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+    vkd.vkCmdDispatch(commandBuffer, (meshletCount + GROUP_SIZE - 1) / GROUP_SIZE, slotEnd, 1);
+
+    // The late draws read the commands and the counts (or the visibility) that were just written
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = meshShaders ? VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, drawStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+uint32_t ClusterCuller::getObjectSlot(Entity entity) const {
+    return entity < objectSlots.size() ? objectSlots[entity] : NO_SLOT;
+}
+
+uint32_t ClusterCuller::getMeshletCount() const {
+    return meshletCount;
+}
+
+VkDeviceSize ClusterCuller::getDrawOffset(uint32_t slot) const {
+    return VkDeviceSize(slot) * meshletCount * DRAW_COMMAND_STRIDE;
+}
+
+VkDeviceSize ClusterCuller::getDrawCountOffset(uint32_t slot, bool latePhase) const {
+    return VkDeviceSize(latePhase ? MAX_CLUSTER_OBJECTS + slot : slot) * sizeof(uint32_t);
+}
+
+VkBuffer ClusterCuller::getEarlyDrawBuffer() {
+    return earlyDrawBuffer;
+}
+
+VkBuffer ClusterCuller::getLateDrawBuffer() {
+    return lateDrawBuffer;
+}
+
+VkBuffer ClusterCuller::getDrawCountBuffer() {
+    return drawCountBuffer;
+}
+
+VkDescriptorSet ClusterCuller::getMeshletDescriptorSet(uint32_t currentFrame) {
+    return meshletDescriptorSets[currentFrame];
+}
+
+uint32_t ClusterCuller::getTaskGroupCount() const {
+    return (meshletCount + TASK_GROUP_SIZE - 1) / TASK_GROUP_SIZE;
+}
+
+uint64_t ClusterCuller::getVersion() const {
+    return version;
+}
@@ -0,0 +1,68 @@
+#include "graphics/CommandBufferCache.h"
+
+void CommandBufferCache::initialize(CommandPools* pcommandPools, uint32_t swapchainImageCount) {
+    imageCount = swapchainImageCount;
+    entries.assign(MAX_FRAMES_IN_FLIGHT * imageCount, Entry{});
+
+    std::vector<VkCommandBuffer> commandBuffers(entries.size());
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = pcommandPools->getDrawCommandPool(); // Created with RESET_COMMAND_BUFFER_BIT, entries are re-recorded individually
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+    if (vkAllocateCommandBuffers(RendererContext::getInstance().pdevice->getLogicalDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffers!");
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].commandBuffer = commandBuffers[i];
+    }
+}
+
+// The device must be idle, the command buffers may otherwise still be pending
+void CommandBufferCache::cleanup(CommandPools* pcommandPools) {
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (const auto& entry : entries) {
+        commandBuffers.push_back(entry.commandBuffer);
+    }
+
+    if (!commandBuffers.empty()) {
+        vkFreeCommandBuffers(RendererContext::getInstance().pdevice->getLogicalDevice(), pcommandPools->getDrawCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+    entries.clear();
+    imageCount = 0;
+}
+
+VkCommandBuffer CommandBufferCache::getCommandBuffer(uint32_t frame, uint32_t imageIndex) {
+    return getEntry(frame, imageIndex).commandBuffer;
+}
+
+bool CommandBufferCache::isCurrent(uint32_t frame, uint32_t imageIndex, const RecordingVersion& version) {
+    const Entry& entry = getEntry(frame, imageIndex);
+    bool current = entry.recorded && entry.version == version;
+    if (current) {
+        reusedCount++;
+    }
+    return current;
+}
+
+void CommandBufferCache::markRecorded(uint32_t frame, uint32_t imageIndex, const RecordingVersion& version) {
+    Entry& entry = getEntry(frame, imageIndex);
+    entry.version = version;
+    entry.recorded = true;
+    recordedCount++;
+}
+
+uint64_t CommandBufferCache::getReusedCount() {
+    return reusedCount;
+}
+
+uint64_t CommandBufferCache::getRecordedCount() {
+    return recordedCount;
+}
+
+CommandBufferCache::Entry& CommandBufferCache::getEntry(uint32_t frame, uint32_t imageIndex) {
+    return entries[frame * imageCount + imageIndex];
+}
\ No newline at end of file
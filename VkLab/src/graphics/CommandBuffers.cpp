@@ -15,7 +15,7 @@ void CommandBuffers::initialize(CommandPools* pCommandPools) {
     }
 }
 
-std::vector<VkCommandBuffer> CommandBuffers::getCommandBuffers() {
+const std::vector<VkCommandBuffer>& CommandBuffers::getCommandBuffers() {
     return commandBuffers;
 }
 
@@ -35,41 +35,55 @@ void recordCommandBuffer(
     SwapChain* pSwapChain,
     RenderPass* pRenderPass,
     DescriptorSet* pDescriptorSet,
+    BindlessTextureSet* pBindlessTextureSet,
     Pipeline* pPipeline,
     FrameBuffers* pFrameBuffer,
-    BufferManager* pBufferManager
+    BufferManager* pBufferManager,
+    Scene* pScene,
+    DrawList* pDrawList,
+    const LodSelector* pLodSelector,
+    CommandRecorder* pRecorder,
+    Profiler* pProfiler,
+    bool depthPrepass,
+    OcclusionCuller* pOcclusionCuller,
+    ClusterCuller* pClusterCuller
 ) {
     
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    if (vkd.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
+    pProfiler->cmdBeginFrame(commandBuffer, currentFrame);
+    if (pOcclusionCuller) {
+        pOcclusionCuller->cmdBeginFrame(commandBuffer);
+    }
+    if (pClusterCuller) {
+        pClusterCuller->cmdBeginFrame(commandBuffer);
+    }
+
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = pRenderPass->getRenderPass();
+    renderPassInfo.renderPass = pOcclusionCuller ? pRenderPass->getEarlyRenderPass() : pRenderPass->getRenderPass();
     renderPassInfo.framebuffer = pFrameBuffer->getSwapChainFramebuffers()[imageIndex];
     renderPassInfo.renderArea.offset = { 0, 0 };
     renderPassInfo.renderArea.extent = pSwapChain->getSwapChainExtent();
 
-    VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
-
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // One clear value per attachment: black color, depth at the far plane
+    VkClearValue clearValues[2]{};
+    clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    renderPassInfo.clearValueCount = 2;
+    renderPassInfo.pClearValues = clearValues;
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getGraphicsPipeline());
+    vkd.vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    // Bind the vertex buffer
-    VkBuffer vertexBuffers[] = { pBufferManager->getVertexBuffer() };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets); // Bind vertex buffers to bindings
-
-    // Bind the index buffer
-    VkBuffer indexBuffers = pBufferManager->getIndexBuffer();
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffers, 0, VK_INDEX_TYPE_UINT16);
+    // Every state is set through the recorder, which drops the calls that don't change anything
+    pRecorder->begin(commandBuffer);
 
     VkViewport viewport{};
     viewport.x = 0.0f;
@@ -78,22 +92,140 @@ void recordCommandBuffer(
     viewport.height = static_cast<float>(pSwapChain->getSwapChainExtent().height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
     VkRect2D scissor{};
     scissor.offset = { 0, 0 };
     scissor.extent = pSwapChain->getSwapChainExtent();
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-    // Bind Descriptor Sets
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipelineLayout(), 0, 1, pDescriptorSet->getDescriptorSetPtr(currentFrame), 0, nullptr);
 
-    //vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0); // Without indexes
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    auto pipelineLayout = pPipeline->getPipelineLayout();
+    const EntityStore& entities = pScene->getEntities();
+    VkDescriptorSet objectSet = *pDescriptorSet->getObjectDescriptorSetPtr(currentFrame);
+
+    // Indirect commands of a phase written by the GPU: one per object, and one per meshlet of the objects split by the
+    // cluster culling. VK_NULL_HANDLE without culling
+    struct PhaseDraws {
+        VkBuffer objectCommands = VK_NULL_HANDLE;
+        VkBuffer meshletCommands = VK_NULL_HANDLE;
+        VkDescriptorSet meshletSet = VK_NULL_HANDLE; // Mesh shader path only
+        bool late = false;
+    };
+
+    // The draws are sorted by state (see DrawList), so most of the state below is only forwarded on the first draw of a bucket
+    // With occlusion culling, the parameters of each draw are read from its indirect command, written by the GPU (see OcclusionCuller)
+    auto recordDraws = [&](VkPipeline pipeline, VkPipeline meshletPipeline, VkBuffer vertexBuffer, const PhaseDraws& phase) {
+        for (const auto& command : pDrawList->getCommands()) {
+            uint32_t slot = pClusterCuller ? pClusterCuller->getObjectSlot(command.objectIndex) : ClusterCuller::NO_SLOT;
+            if (slot != ClusterCuller::NO_SLOT && pClusterCuller->usesMeshShaders()) {
+                // The task shader launches the visible meshlets of the slot, the transform and the material are read from
+                // the cluster input. The mesh shader layout is not compatible with the other one, the recorder rebinds the sets
+                VkPipelineLayout meshletPipelineLayout = pPipeline->getMeshletPipelineLayout();
+                pRecorder->bindPipeline(meshletPipeline);
+                pRecorder->setViewport(viewport);
+                pRecorder->setScissor(scissor);
+                pRecorder->bindDescriptorSet(meshletPipelineLayout, MATERIAL_SET, *pDescriptorSet->getMaterialDescriptorSetPtr());
+                pRecorder->bindDescriptorSet(meshletPipelineLayout, BINDLESS_SET, *pBindlessTextureSet->getDescriptorSetPtr());
+                pRecorder->bindDescriptorSet(meshletPipelineLayout, MESHLET_SET, phase.meshletSet);
+
+                MeshletPushConstants pushConstants{ slot, phase.late ? 1u : 0u };
+                pRecorder->pushConstants(meshletPipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0, sizeof(pushConstants), &pushConstants);
+                pRecorder->drawMeshTasks(pClusterCuller->getTaskGroupCount(), 1, 1);
+                continue;
+            }
+
+            pRecorder->bindPipeline(pipeline);
+            pRecorder->bindVertexBuffer(vertexBuffer, 0);
+            pRecorder->bindIndexBuffer(pBufferManager->getIndexBuffer(), 0, pBufferManager->getIndexType());
+            pRecorder->setViewport(viewport);
+            pRecorder->setScissor(scissor);
+
+            // The view data of this frame, the material table and the bindless texture table don't change during the frame
+            // They stay bound while the per-draw data changes, since every pipeline shares the same set layouts
+            pRecorder->bindDescriptorSet(pipelineLayout, FRAME_SET, *pDescriptorSet->getDescriptorSetPtr(currentFrame));
+            pRecorder->bindDescriptorSet(pipelineLayout, MATERIAL_SET, *pDescriptorSet->getMaterialDescriptorSetPtr());
+            pRecorder->bindDescriptorSet(pipelineLayout, BINDLESS_SET, *pBindlessTextureSet->getDescriptorSetPtr());
+
+            if (pPipeline->usesPushConstants()) {
+                // The per-draw data is written directly in the command buffer, no descriptor and no buffer write
+                ObjectUniformBufferObject pushConstants{};
+                pushConstants.model = entities.getWorldTransform(command.objectIndex) * pBufferManager->getPositionDequantization();
+                pushConstants.materialIndex = entities.getMaterialIndex(command.objectIndex);
+                pushConstants.instanceOffset = 0;
+                pRecorder->pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+            }
+            else {
+                // Each object reads its own slot of the per-object buffer through the dynamic offset
+                uint32_t dynamicOffset = static_cast<uint32_t>(command.objectIndex * pBufferManager->getObjectStride());
+                pRecorder->bindDescriptorSet(pipelineLayout, OBJECT_SET, objectSet, 1, &dynamicOffset);
+            }
+
+            //vkd.vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0); // Without indexes
+            if (slot != ClusterCuller::NO_SLOT) {
+                // The commands of the visible meshlets of the slot, their count is written by the GPU too
+                pRecorder->drawIndexedIndirectCount(phase.meshletCommands, pClusterCuller->getDrawOffset(slot), pClusterCuller->getDrawCountBuffer(), pClusterCuller->getDrawCountOffset(slot, phase.late), pClusterCuller->getMeshletCount(), ClusterCuller::DRAW_COMMAND_STRIDE);
+            }
+            else if (phase.objectCommands != VK_NULL_HANDLE) {
+                VkDeviceSize offset = VkDeviceSize(command.objectIndex) * OcclusionCuller::DRAW_COMMAND_STRIDE;
+                pRecorder->drawIndexedIndirect(phase.objectCommands, offset, 1, OcclusionCuller::DRAW_COMMAND_STRIDE);
+            }
+            else {
+                const MeshLod& lod = pLodSelector->getObjectLod(command.objectIndex);
+                pRecorder->drawIndexed(lod.indexCount, 1, lod.firstIndex, 0, 0);
+            }
+        }
+    };
+
+    auto recordPhase = [&](const PhaseDraws& phase) {
+        if (depthPrepass) {
+            // Fill the depth buffer first with the cheap depth-only pipeline, then shade each visible pixel once.
+            // Both passes share the pipeline layout, so the descriptor sets and push constants stay compatible
+            recordDraws(pPipeline->getDepthPrepassPipeline(), pPipeline->getMeshletDepthPrepassPipeline(), pBufferManager->getPositionBuffer(), phase);
+            recordDraws(pPipeline->getDepthEqualPipeline(), pPipeline->getMeshletDepthEqualPipeline(), pBufferManager->getVertexBuffer(), phase);
+        }
+        else {
+            recordDraws(pPipeline->getGraphicsPipeline(), pPipeline->getMeshletGraphicsPipeline(), pBufferManager->getVertexBuffer(), phase);
+        }
+    };
+
+    if (!pOcclusionCuller) {
+        recordPhase(PhaseDraws{});
+        vkd.vkCmdEndRenderPass(commandBuffer);
+    }
+    else {
+        // Early phase: the objects visible in the previous frame, their depth is kept for the Hi-Z pyramid
+        PhaseDraws earlyPhase{ pOcclusionCuller->getEarlyDrawBuffer() };
+        PhaseDraws latePhase{ pOcclusionCuller->getLateDrawBuffer() };
+        latePhase.late = true;
+        if (pClusterCuller) {
+            earlyPhase.meshletCommands = pClusterCuller->getEarlyDrawBuffer();
+            earlyPhase.meshletSet = pClusterCuller->getMeshletDescriptorSet(currentFrame);
+            latePhase.meshletCommands = pClusterCuller->getLateDrawBuffer();
+            latePhase.meshletSet = pClusterCuller->getMeshletDescriptorSet(currentFrame);
+        }
+
+        recordPhase(earlyPhase);
+        vkd.vkCmdEndRenderPass(commandBuffer);
+
+        // The meshlets are tested against the same pyramid as the objects
+        pOcclusionCuller->cmdCull(commandBuffer, currentFrame, entities.size());
+        if (pClusterCuller) {
+            pClusterCuller->cmdCull(commandBuffer, currentFrame);
+        }
+
+        // Late phase: the objects that became visible, on top of the early phase (nothing is cleared)
+        renderPassInfo.renderPass = pRenderPass->getLateRenderPass();
+        renderPassInfo.clearValueCount = 0;
+        renderPassInfo.pClearValues = nullptr;
+        vkd.vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        // The compute dispatches may have disturbed the push constants, everything is set again
+        pRecorder->begin(commandBuffer);
+        recordPhase(latePhase);
+        vkd.vkCmdEndRenderPass(commandBuffer);
+    }
 
-    vkCmdEndRenderPass(commandBuffer);
+    pProfiler->cmdEndFrame(commandBuffer, currentFrame);
 
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    if (vkd.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
     }
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 void CommandPools::initialize() {
 	VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
-	QueueFamilyIndices queueFamilyIndices = findQueueFamilies(RendererContext::getInstance().pdevice->getPhysicalDevice());
+	const QueueFamilyIndices& queueFamilyIndices = RendererContext::getInstance().pdevice->getQueueFamilyIndices();
 
 	// Drawing command pool create info
 	VkCommandPoolCreateInfo drawPoolInfo{};
@@ -17,12 +17,12 @@ void CommandPools::initialize() {
 	transferPoolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily.value();
 
 	// Create drawing command pool
-	if (vkCreateCommandPool(logicalDevice, &drawPoolInfo, nullptr, &drawCommandPool) != VK_SUCCESS) {
+	if (vkCreateCommandPool(logicalDevice, &drawPoolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_COMMAND_POOL), &drawCommandPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create draw command pool!");
 	}
 
 	// Create transfer command pool
-	if (vkCreateCommandPool(logicalDevice, &transferPoolInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+	if (vkCreateCommandPool(logicalDevice, &transferPoolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_COMMAND_POOL), &transferCommandPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create transfer command pool!");
 	}
 }
@@ -30,8 +30,8 @@ void CommandPools::initialize() {
 void CommandPools::cleanup() {
 	VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-	vkDestroyCommandPool(logicalDevice, drawCommandPool, nullptr);
-	vkDestroyCommandPool(logicalDevice, transferCommandPool, nullptr);
+	vkDestroyCommandPool(logicalDevice, drawCommandPool, getAllocationCallbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+	vkDestroyCommandPool(logicalDevice, transferCommandPool, getAllocationCallbacks(VK_OBJECT_TYPE_COMMAND_POOL));
 }
 
 VkCommandPool CommandPools::getDrawCommandPool() {
@@ -40,4 +40,4 @@ VkCommandPool CommandPools::getDrawCommandPool() {
 
 VkCommandPool CommandPools::getTransferCommandPool() {
 	return transferCommandPool;
-}
\ No newline at end of file
+}
@@ -0,0 +1,157 @@
+#include "graphics/CommandRecorder.h"
+#include "core/RendererContext.h"
+
+void CommandRecorder::begin(VkCommandBuffer commandBuffer) {
+    this->commandBuffer = commandBuffer;
+    pdispatch = &RendererContext::getInstance().pdevice->getDispatch();
+
+    pipeline = VK_NULL_HANDLE;
+    vertexBuffer = VK_NULL_HANDLE;
+    indexBuffer = VK_NULL_HANDLE;
+    viewportSet = false;
+    scissorSet = false;
+    descriptorLayout = VK_NULL_HANDLE;
+    descriptorSets.fill(VK_NULL_HANDLE);
+    pushConstantLayout = VK_NULL_HANDLE;
+    pushConstantSize = 0;
+}
+
+void CommandRecorder::bindPipeline(VkPipeline pipeline) {
+    if (pipeline == this->pipeline) {
+        stats.elided++;
+        return;
+    }
+
+    // Descriptor sets stay bound across pipeline switches as long as the pipeline layouts are compatible,
+    // which is the case for every pipeline of the renderer but the mesh shader ones (see DescriptorSetIndex)
+    pdispatch->vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    this->pipeline = pipeline;
+    stats.issued++;
+}
+
+void CommandRecorder::bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset) {
+    if (buffer == vertexBuffer && offset == vertexBufferOffset) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+    vertexBuffer = buffer;
+    vertexBufferOffset = offset;
+    stats.issued++;
+}
+
+void CommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+    if (buffer == indexBuffer && offset == indexBufferOffset && indexType == this->indexType) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+    indexBuffer = buffer;
+    indexBufferOffset = offset;
+    this->indexType = indexType;
+    stats.issued++;
+}
+
+void CommandRecorder::setViewport(const VkViewport& viewport) {
+    if (viewportSet && memcmp(&viewport, &this->viewport, sizeof(VkViewport)) == 0) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    this->viewport = viewport;
+    viewportSet = true;
+    stats.issued++;
+}
+
+void CommandRecorder::setScissor(const VkRect2D& scissor) {
+    if (scissorSet && memcmp(&scissor, &this->scissor, sizeof(VkRect2D)) == 0) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    this->scissor = scissor;
+    scissorSet = true;
+    stats.issued++;
+}
+
+void CommandRecorder::bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet, uint32_t dynamicOffsetCount, const uint32_t* pdynamicOffsets) {
+    // Only sets with at most one dynamic offset are shadowed, anything else is always forwarded
+    bool shadowed = set < MAX_SHADOWED_SETS && dynamicOffsetCount <= 1;
+    uint32_t dynamicOffset = dynamicOffsetCount == 1 ? pdynamicOffsets[0] : 0;
+
+    if (shadowed && layout == descriptorLayout && descriptorSets[set] == descriptorSet && dynamicOffsets[set] == dynamicOffset) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptorSet, dynamicOffsetCount, pdynamicOffsets);
+    stats.issued++;
+
+    // A different layout may disturb the other sets, forget all of them
+    if (layout != descriptorLayout) {
+        descriptorSets.fill(VK_NULL_HANDLE);
+        descriptorLayout = layout;
+    }
+    if (shadowed) {
+        descriptorSets[set] = descriptorSet;
+        dynamicOffsets[set] = dynamicOffset;
+    }
+    else if (set < MAX_SHADOWED_SETS) {
+        descriptorSets[set] = VK_NULL_HANDLE;
+    }
+}
+
+void CommandRecorder::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* pvalues) {
+    // Only the common case of a block pushed whole from offset 0 is shadowed
+    bool shadowed = offset == 0 && size <= MAX_PUSH_CONSTANT_BYTES;
+
+    if (shadowed && layout == pushConstantLayout && size == pushConstantSize && memcmp(pvalues, pushConstantData.data(), size) == 0) {
+        stats.elided++;
+        return;
+    }
+
+    pdispatch->vkCmdPushConstants(commandBuffer, layout, stages, offset, size, pvalues);
+    stats.issued++;
+
+    if (shadowed) {
+        memcpy(pushConstantData.data(), pvalues, size);
+        pushConstantLayout = layout;
+        pushConstantSize = size;
+    }
+    else {
+        pushConstantSize = 0;
+    }
+}
+
+// Draws are never redundant, they are only counted
+void CommandRecorder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    pdispatch->vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    stats.issued++;
+}
+
+void CommandRecorder::drawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) {
+    pdispatch->vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
+    stats.issued++;
+}
+
+void CommandRecorder::drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride) {
+    pdispatch->vkCmdDrawIndexedIndirectCountKHR(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+    stats.issued++;
+}
+
+void CommandRecorder::drawMeshTasks(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    pdispatch->vkCmdDrawMeshTasksEXT(commandBuffer, groupCountX, groupCountY, groupCountZ);
+    stats.issued++;
+}
+
+const CommandRecorder::Stats& CommandRecorder::getStats() const {
+    return stats;
+}
+
+void CommandRecorder::resetStats() {
+    stats = Stats{};
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "graphics/ComputePipeline.h"
+
+void ComputePipeline::initialize(const std::vector<char>& shaderCode, const std::vector<VkDescriptorSetLayout>& setLayouts, uint32_t pushConstantSize) {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    VkShaderModule shaderModule = createShaderModule(shaderCode, &logicalDevice);
+
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageInfo.module = shaderModule;
+    shaderStageInfo.pName = "main";
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantSize > 0 ? &pushConstantRange : nullptr;
+
+    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline layout!");
+    }
+
+    // No fixed-function state: the shader stage and the layout are the whole pipeline
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = shaderStageInfo;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE), &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+
+    vkDestroyShaderModule(logicalDevice, shaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+}
+
+void ComputePipeline::cleanup() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    if (pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(logicalDevice, pipeline, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE));
+        pipeline = VK_NULL_HANDLE;
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(logicalDevice, pipelineLayout, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        pipelineLayout = VK_NULL_HANDLE;
+    }
+}
+
+VkPipelineLayout ComputePipeline::getPipelineLayout() {
+    return pipelineLayout;
+}
+
+VkPipeline ComputePipeline::getPipeline() {
+    return pipeline;
+}
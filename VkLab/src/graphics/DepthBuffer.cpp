@@ -0,0 +1,69 @@
+#include "graphics/DepthBuffer.h"
+
+void DepthBuffer::initialize(SwapChain* pswapchain) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    extent = pswapchain->getSwapChainExtent();
+    format = findDepthFormat();
+
+    createImage(
+        pdevice,
+        extent.width,
+        extent.height,
+        format,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, // Sampled to build the Hi-Z pyramid
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        image,
+        imageMemory
+    );
+
+    // The render pass transitions the image from UNDEFINED when it begins, no explicit layout transition is needed
+    imageView = createImageView(pdevice, image, format, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
+
+void DepthBuffer::cleanup() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    if (imageView != VK_NULL_HANDLE) {
+        vkDestroyImageView(logicalDevice, imageView, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(logicalDevice, image, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE));
+        vkFreeMemory(logicalDevice, imageMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        imageView = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        imageMemory = VK_NULL_HANDLE;
+    }
+}
+
+VkImage DepthBuffer::getImage() {
+    return image;
+}
+
+VkImageView DepthBuffer::getImageView() {
+    return imageView;
+}
+
+VkFormat DepthBuffer::getFormat() {
+    return format;
+}
+
+VkExtent2D DepthBuffer::getExtent() {
+    return extent;
+}
+
+// Ordered by preference: no stencil is used, so the pure 32 bit float format comes first
+// The format must also be sampled by a compute shader for the occlusion culling (see HiZPyramid)
+VkFormat DepthBuffer::findDepthFormat() {
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+    VkPhysicalDevice physicalDevice = RendererContext::getInstance().pdevice->getPhysicalDevice();
+
+    for (VkFormat candidate : candidates) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, candidate, &properties);
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        if ((properties.optimalTilingFeatures & required) == required) {
+            return candidate;
+        }
+    }
+
+    throw std::runtime_error("failed to find supported depth format!");
+}
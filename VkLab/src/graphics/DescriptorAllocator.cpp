@@ -0,0 +1,105 @@
+#include "graphics/DescriptorAllocator.h"
+
+#include <algorithm>
+
+void DescriptorAllocator::initialize(uint32_t setsPerPool) {
+    this->setsPerPool = setsPerPool;
+}
+
+void DescriptorAllocator::cleanup() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (auto pool : usedPools) {
+        vkDestroyDescriptorPool(logicalDevice, pool, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    }
+    for (auto pool : freePools) {
+        vkDestroyDescriptorPool(logicalDevice, pool, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    }
+    usedPools.clear();
+    freePools.clear();
+    currentPool = VK_NULL_HANDLE;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    if (currentPool == VK_NULL_HANDLE) {
+        currentPool = grabPool();
+        usedPools.push_back(currentPool);
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = currentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkResult result = vkAllocateDescriptorSets(logicalDevice, &allocInfo, &descriptorSet);
+
+    // The current pool is full: move to a new one and try again
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        currentPool = grabPool();
+        usedPools.push_back(currentPool);
+
+        allocInfo.descriptorPool = currentPool;
+        result = vkAllocateDescriptorSets(logicalDevice, &allocInfo, &descriptorSet);
+    }
+
+    // A brand new pool can't fit the set, something is seriously wrong with the layout
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor set!");
+    }
+
+    return descriptorSet;
+}
+
+void DescriptorAllocator::resetPools() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    // Resetting a pool frees all of its sets at once
+    for (auto pool : usedPools) {
+        RendererContext::getInstance().pdevice->getDispatch().vkResetDescriptorPool(logicalDevice, pool, 0);
+        freePools.push_back(pool);
+    }
+    usedPools.clear();
+    currentPool = VK_NULL_HANDLE;
+}
+
+VkDescriptorPool DescriptorAllocator::grabPool() {
+    // Reuse a pool that was reset if there is one
+    if (!freePools.empty()) {
+        VkDescriptorPool pool = freePools.back();
+        freePools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = createPool(setsPerPool);
+    setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL); // Grow so that a busy allocator needs fewer pools
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t setCount) {
+    // Describe which descriptor types our descriptor sets are going to contain
+    std::vector<VkDescriptorPoolSize> sizes;
+    sizes.reserve(poolSizes.size());
+    for (const auto& poolSize : poolSizes) {
+        sizes.push_back({ poolSize.first, std::max(1u, static_cast<uint32_t>(poolSize.second * setCount)) });
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = 0; // No FREE_DESCRIPTOR_SET_BIT: sets are only released by resetting the whole pool
+    poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+    // Aside from the maximum number of individual descriptors that are available,
+    // we also need to specify the maximum number of descriptor sets that may be allocated
+    poolInfo.maxSets = setCount;
+
+    VkDescriptorPool descriptorPool;
+    if (vkCreateDescriptorPool(RendererContext::getInstance().pdevice->getLogicalDevice(), &poolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    return descriptorPool;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "graphics/DescriptorLayoutCache.h"
+
+#include <algorithm>
+#include <functional>
+
+void DescriptorLayoutCache::cleanup() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (const auto& pair : layoutCache) {
+        vkDestroyDescriptorSetLayout(logicalDevice, pair.second, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    }
+    layoutCache.clear();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo* pcreateInfo) {
+    DescriptorLayoutInfo layoutInfo;
+    layoutInfo.flags = pcreateInfo->flags;
+    layoutInfo.bindings.assign(pcreateInfo->pBindings, pcreateInfo->pBindings + pcreateInfo->bindingCount);
+
+    // Binding flags (descriptor indexing) are chained through pNext, they are part of the layout identity
+    layoutInfo.bindingFlags.assign(pcreateInfo->bindingCount, 0);
+    auto pnext = static_cast<const VkBaseInStructure*>(pcreateInfo->pNext);
+    while (pnext != nullptr) {
+        if (pnext->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT) {
+            auto pbindingFlags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT*>(pnext);
+            layoutInfo.bindingFlags.assign(pbindingFlags->pBindingFlags, pbindingFlags->pBindingFlags + pbindingFlags->bindingCount);
+        }
+        pnext = pnext->pNext;
+    }
+
+    // Sort the bindings (and their flags) so that the same set described in another order hits the cache
+    std::vector<size_t> order(layoutInfo.bindings.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return layoutInfo.bindings[a].binding < layoutInfo.bindings[b].binding;
+    });
+
+    DescriptorLayoutInfo sortedInfo;
+    sortedInfo.flags = layoutInfo.flags;
+    for (size_t i : order) {
+        sortedInfo.bindings.push_back(layoutInfo.bindings[i]);
+        sortedInfo.bindingFlags.push_back(layoutInfo.bindingFlags[i]);
+    }
+
+    auto it = layoutCache.find(sortedInfo);
+    if (it != layoutCache.end()) {
+        return it->second;
+    }
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(RendererContext::getInstance().pdevice->getLogicalDevice(), pcreateInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    layoutCache[sortedInfo] = layout;
+    return layout;
+}
+
+bool DescriptorLayoutCache::DescriptorLayoutInfo::operator==(const DescriptorLayoutInfo& other) const {
+    if (flags != other.flags || bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags) {
+        return false;
+    }
+
+    // Bindings are sorted, compare them one by one (immutable samplers are not used by this renderer)
+    for (size_t i = 0; i < bindings.size(); i++) {
+        if (bindings[i].binding != other.bindings[i].binding ||
+            bindings[i].descriptorType != other.bindings[i].descriptorType ||
+            bindings[i].descriptorCount != other.bindings[i].descriptorCount ||
+            bindings[i].stageFlags != other.bindings[i].stageFlags) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t DescriptorLayoutCache::DescriptorLayoutInfo::hash() const {
+    size_t result = std::hash<size_t>()(bindings.size()) ^ std::hash<uint32_t>()(flags);
+
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const auto& b = bindings[i];
+        // Pack the binding description in 64 bits, then mix it with the previous value
+        uint64_t packed = static_cast<uint64_t>(b.binding) |
+            static_cast<uint64_t>(b.descriptorType) << 8 |
+            static_cast<uint64_t>(b.descriptorCount) << 16 |
+            static_cast<uint64_t>(b.stageFlags) << 40 |
+            static_cast<uint64_t>(bindingFlags[i]) << 56;
+        result ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (result << 6) + (result >> 2);
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -1,74 +1,140 @@
 #include "graphics/DescriptorSet.h"
 
-void DescriptorSet::initialize() {
-    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-    uboLayoutBinding.binding = 0;  // Specify the binding used in the shader
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.descriptorCount = 1; // This could be used to specify a transformation for each of the bones in a skeleton for skeletal animation, for example.
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Used in vertex shader
-    uboLayoutBinding.pImmutableSamplers = nullptr; // Optional - Only relevent for image sampling
+void DescriptorSet::initialize(DescriptorLayoutCache* playoutCache) {
+    // Each set holds a single uniform buffer at binding 0, what changes is how often it is rebound
+    frameSetLayout = createLayout(playoutCache, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    materialSetLayout = createLayout(playoutCache, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    // A dynamic uniform buffer takes its offset at bind time: one set serves every object of the frame
+    objectSetLayout = createLayout(playoutCache, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT);
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &uboLayoutBinding;
+    // The storage buffers of the mesh shaders (see meshlet_bindings.glsl), the pipeline needs the layout before the buffers exist
+    if (RendererContext::getInstance().pdevice->hasMeshShaders()) {
+        VkDescriptorSetLayoutBinding bindings[MESHLET_BINDING_COUNT]{};
+        for (uint32_t i = 0; i < MESHLET_BINDING_COUNT; i++) {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+        }
 
-    if (vkCreateDescriptorSetLayout(RendererContext::getInstance().pdevice->getLogicalDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor set layout!");
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = MESHLET_BINDING_COUNT;
+        layoutInfo.pBindings = bindings;
+        meshletSetLayout = playoutCache->createDescriptorLayout(&layoutInfo);
     }
+
+    frameUpdateTemplate = createUpdateTemplate(frameSetLayout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    materialUpdateTemplate = createUpdateTemplate(materialSetLayout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    objectUpdateTemplate = createUpdateTemplate(objectSetLayout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 }
 
 void DescriptorSet::cleanup() {
-    vkDestroyDescriptorSetLayout(RendererContext::getInstance().pdevice->getLogicalDevice(), descriptorSetLayout, nullptr);
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    // The layouts are destroyed by the layout cache and the sets are released with the allocator pools
+    vkDestroyDescriptorUpdateTemplate(logicalDevice, frameUpdateTemplate, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE));
+    vkDestroyDescriptorUpdateTemplate(logicalDevice, materialUpdateTemplate, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE));
+    vkDestroyDescriptorUpdateTemplate(logicalDevice, objectUpdateTemplate, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE));
 }
 
 // Allocate all descriptor Sets
-void DescriptorSet::allocate(DescriptorPool* descriptorPool, BufferManager* bufferManager) {
+void DescriptorSet::allocate(DescriptorAllocator* pdescriptorAllocator, BufferManager* bufferManager) {
     auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
-
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool->getDescriptorPool();
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT); // One descriptor set for each frame in flight
-    allocInfo.pSetLayouts = layouts.data();
+    const auto& uniformBuffers = bufferManager->getUniformBuffers();
+    const auto& objectBuffers = bufferManager->getObjectBuffers();
 
     descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+    objectDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
 
-    if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-
-    // Configure and populate every descriptor
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        // Descriptors are configured with a VkDescriptorBufferInfo
+        // One descriptor set for each frame in flight
+        descriptorSets[i] = pdescriptorAllocator->allocate(frameSetLayout);
+        objectDescriptorSets[i] = pdescriptorAllocator->allocate(objectSetLayout);
+
+        // Descriptors are configured with a VkDescriptorBufferInfo, laid out as described by the update template
         VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = bufferManager->getUniformBuffers()[i];
+        bufferInfo.buffer = uniformBuffers[i];
         bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(UniformBufferObject);
-
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet = descriptorSets[i];
-        descriptorWrite.dstBinding = 0;
-        descriptorWrite.dstArrayElement = 0; // Remember that descriptors can be arrays, so we also need to specify the index
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrite.descriptorCount = 1;
-        // The last field references an array with descriptorCount structs that actually configure the descriptors.
-        // It depends on the type of descriptor which one of the three you actually need to use.
-        descriptorWrite.pBufferInfo = &bufferInfo;
-        descriptorWrite.pImageInfo = nullptr; // Optional
-        descriptorWrite.pTexelBufferView = nullptr; // Optional
-
-        vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
+        bufferInfo.range = sizeof(FrameUniformBufferObject);
+        vkUpdateDescriptorSetWithTemplate(logicalDevice, descriptorSets[i], frameUpdateTemplate, &bufferInfo);
+
+        // The range covers a single object, the dynamic offset selects which one
+        VkDescriptorBufferInfo objectBufferInfo{};
+        objectBufferInfo.buffer = objectBuffers[i];
+        objectBufferInfo.offset = 0;
+        objectBufferInfo.range = sizeof(ObjectUniformBufferObject);
+        vkUpdateDescriptorSetWithTemplate(logicalDevice, objectDescriptorSets[i], objectUpdateTemplate, &objectBufferInfo);
     }
+
+    materialDescriptorSet = pdescriptorAllocator->allocate(materialSetLayout);
+
+    // The whole table is visible, the shaders index it with the material index of the draw
+    VkDescriptorBufferInfo materialBufferInfo{};
+    materialBufferInfo.buffer = bufferManager->getMaterialBuffer();
+    materialBufferInfo.offset = 0;
+    materialBufferInfo.range = sizeof(MaterialUniformBufferObject) * MAX_MATERIALS;
+    vkUpdateDescriptorSetWithTemplate(logicalDevice, materialDescriptorSet, materialUpdateTemplate, &materialBufferInfo);
 }
 
-VkDescriptorSetLayout* DescriptorSet::getDescriptorSetLayoutPtr() {
-    return &descriptorSetLayout;
+std::array<VkDescriptorSetLayout, 3> DescriptorSet::getDescriptorSetLayouts() {
+    return { frameSetLayout, materialSetLayout, objectSetLayout };
+}
+
+VkDescriptorSetLayout DescriptorSet::getMeshletSetLayout() {
+    return meshletSetLayout;
 }
 
 VkDescriptorSet* DescriptorSet::getDescriptorSetPtr(uint32_t index) {
     return &descriptorSets[index];
+}
+
+VkDescriptorSet* DescriptorSet::getMaterialDescriptorSetPtr() {
+    return &materialDescriptorSet;
+}
+
+VkDescriptorSet* DescriptorSet::getObjectDescriptorSetPtr(uint32_t index) {
+    return &objectDescriptorSets[index];
+}
+
+VkDescriptorSetLayout DescriptorSet::createLayout(DescriptorLayoutCache* playoutCache, VkDescriptorType type, VkShaderStageFlags stages) {
+    VkDescriptorSetLayoutBinding uboLayoutBinding{};
+    uboLayoutBinding.binding = 0;  // Specify the binding used in the shader
+    uboLayoutBinding.descriptorType = type;
+    uboLayoutBinding.descriptorCount = 1; // This could be used to specify a transformation for each of the bones in a skeleton for skeletal animation, for example.
+    uboLayoutBinding.stageFlags = stages;
+    uboLayoutBinding.pImmutableSamplers = nullptr; // Optional - Only relevent for image sampling
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &uboLayoutBinding;
+
+    return playoutCache->createDescriptorLayout(&layoutInfo);
+}
+
+// An update template describes once where the descriptors are read from in a host structure,
+// writing a set is then a single call without building VkWriteDescriptorSet structures
+VkDescriptorUpdateTemplate DescriptorSet::createUpdateTemplate(VkDescriptorSetLayout layout, VkDescriptorType type) {
+    VkDescriptorUpdateTemplateEntry templateEntry{};
+    templateEntry.dstBinding = 0;
+    templateEntry.dstArrayElement = 0;
+    templateEntry.descriptorCount = 1;
+    templateEntry.descriptorType = type;
+    templateEntry.offset = 0; // The data is a single VkDescriptorBufferInfo
+    templateEntry.stride = sizeof(VkDescriptorBufferInfo);
+
+    VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+    templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    templateInfo.descriptorUpdateEntryCount = 1;
+    templateInfo.pDescriptorUpdateEntries = &templateEntry;
+    templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    templateInfo.descriptorSetLayout = layout;
+
+    VkDescriptorUpdateTemplate updateTemplate;
+    if (vkCreateDescriptorUpdateTemplate(RendererContext::getInstance().pdevice->getLogicalDevice(), &templateInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE), &updateTemplate) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor update template!");
+    }
+
+    return updateTemplate;
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "graphics/DrawList.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+uint64_t DrawList::makeKey(uint32_t pipelineId, uint32_t materialIndex, uint32_t vertexBufferId, float depth) {
+    // The bit pattern of a positive float grows with its value, so it can be sorted as an integer
+    depth = std::max(depth, 0.0f);
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return static_cast<uint64_t>(pipelineId & 0xFF) << 56 |
+        static_cast<uint64_t>(materialIndex & 0xFFFF) << 40 |
+        static_cast<uint64_t>(vertexBufferId & 0xFF) << 32 |
+        static_cast<uint64_t>(depthBits);
+}
+
+void DrawList::clear() {
+    commands.clear();
+}
+
+void DrawList::add(uint64_t key, uint32_t objectIndex) {
+    commands.push_back({ key, objectIndex });
+}
+
+// LSD radix sort, one byte of the key per pass: linear in the number of draws and stable
+void DrawList::sort(LinearAllocator* pframeArena) {
+    if (commands.empty()) {
+        return;
+    }
+
+    // Each pass scatters from one buffer to the other
+    DrawCommand* psource = commands.data();
+    DrawCommand* pdestination = pframeArena->allocateArray<DrawCommand>(commands.size());
+
+    for (uint32_t pass = 0; pass < 8; pass++) {
+        uint32_t shift = pass * 8;
+
+        std::array<uint32_t, 256> histogram{};
+        for (size_t i = 0; i < commands.size(); i++) {
+            histogram[(psource[i].key >> shift) & 0xFF]++;
+        }
+
+        // Every key has the same byte: this pass would not move anything (common for the pipeline and vertex buffer bytes)
+        if (histogram[(psource[0].key >> shift) & 0xFF] == commands.size()) {
+            continue;
+        }
+
+        // Turn the counts into the first output position of each bucket
+        uint32_t offset = 0;
+        for (auto& count : histogram) {
+            uint32_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        for (size_t i = 0; i < commands.size(); i++) {
+            pdestination[histogram[(psource[i].key >> shift) & 0xFF]++] = psource[i];
+        }
+        std::swap(psource, pdestination);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (psource != commands.data()) {
+        std::copy(psource, psource + commands.size(), commands.data());
+    }
+}
+
+const std::vector<DrawCommand>& DrawList::getCommands() const {
+    return commands;
+}
\ No newline at end of file
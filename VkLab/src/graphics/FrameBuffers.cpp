@@ -1,6 +1,6 @@
 #include "graphics/FrameBuffers.h"
 
-void FrameBuffers::initialize(SwapChain* pSwapChain, ImageViews* pImageViews, RenderPass* pRenderPass) {
+void FrameBuffers::initialize(SwapChain* pSwapChain, ImageViews* pImageViews, DepthBuffer* pDepthBuffer, RenderPass* pRenderPass) {
     size_t swapChainImageViewsSize = pImageViews->getSwapChainImageViews().size();
     VkExtent2D swapChainExtent = pSwapChain->getSwapChainExtent();
 
@@ -8,20 +8,22 @@ void FrameBuffers::initialize(SwapChain* pSwapChain, ImageViews* pImageViews, Re
 
     // Iterate through the image views and create framebuffers from them
     for (size_t i = 0; i < swapChainImageViewsSize; i++) {
+        // Every framebuffer uses the same depth image
         VkImageView attachments[] = {
-            pImageViews->getSwapChainImageViews()[i]
+            pImageViews->getSwapChainImageViews()[i],
+            pDepthBuffer->getImageView()
         };
 
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = pRenderPass->getRenderPass(); // they use the same number and type of attachments.
-        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.attachmentCount = 2;
         framebufferInfo.pAttachments = attachments;
         framebufferInfo.width = swapChainExtent.width;
         framebufferInfo.height = swapChainExtent.height;
         framebufferInfo.layers = 1; // Our swap chain images are single images, so the number of layers is 1
 
-        if (vkCreateFramebuffer(RendererContext::getInstance().pdevice->getLogicalDevice(), &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
+        if (vkCreateFramebuffer(RendererContext::getInstance().pdevice->getLogicalDevice(), &framebufferInfo, getAllocationCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER), &swapChainFramebuffers[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create framebuffer!");
         }
     }
@@ -29,10 +31,10 @@ void FrameBuffers::initialize(SwapChain* pSwapChain, ImageViews* pImageViews, Re
 
 void FrameBuffers::cleanup() {
     for (auto framebuffer : swapChainFramebuffers) {
-        vkDestroyFramebuffer(RendererContext::getInstance().pdevice->getLogicalDevice(), framebuffer, nullptr);
+        vkDestroyFramebuffer(RendererContext::getInstance().pdevice->getLogicalDevice(), framebuffer, getAllocationCallbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
     }
 }
 
-const std::vector<VkFramebuffer> FrameBuffers::getSwapChainFramebuffers() {
+const std::vector<VkFramebuffer>& FrameBuffers::getSwapChainFramebuffers() {
     return swapChainFramebuffers;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "graphics/FrameUploadTracker.h"
+
+void FrameUploadTracker::initialize(uint32_t capacity) {
+    staleFrames.assign(capacity, 0);
+    staleObjects.reserve(capacity);
+    frameObjects.reserve(capacity);
+}
+
+void FrameUploadTracker::markChanged(std::span<const uint32_t> changedObjects) {
+    for (uint32_t object : changedObjects) {
+        if (staleFrames[object] == 0) {
+            staleObjects.push_back(object);
+        }
+        staleFrames[object] = ALL_FRAMES;
+    }
+}
+
+std::span<const uint32_t> FrameUploadTracker::takeStaleObjects(uint32_t currentFrame) {
+    uint8_t frameBit = static_cast<uint8_t>(1u << currentFrame);
+    frameObjects.clear();
+
+    // Objects up to date in every copy leave the list
+    uint32_t keptCount = 0;
+    for (uint32_t object : staleObjects) {
+        if (staleFrames[object] & frameBit) {
+            frameObjects.push_back(object);
+            staleFrames[object] &= ~frameBit;
+        }
+        if (staleFrames[object] != 0) {
+            staleObjects[keptCount++] = object;
+        }
+    }
+    staleObjects.resize(keptCount);
+
+    return frameObjects;
+}
@@ -0,0 +1,200 @@
+#include "graphics/HiZPyramid.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void HiZPyramid::initialize(DescriptorLayoutCache* playoutCache, DepthBuffer* pdepthBuffer) {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    // Binding 0: depth buffer or previous level, binding 1: level written by the dispatch
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+    setLayout = playoutCache->createDescriptorLayout(&layoutInfo);
+
+    buildPipeline.initialize(readFile("shaders/hiz.spv"), { setLayout }, sizeof(BuildConstants));
+    descriptorAllocator.initialize(16);
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(logicalDevice, &samplerInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER), &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create Hi-Z sampler!");
+    }
+
+    createPyramid(pdepthBuffer);
+}
+
+void HiZPyramid::cleanup() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    cleanupPyramid();
+    vkDestroySampler(logicalDevice, sampler, getAllocationCallbacks(VK_OBJECT_TYPE_SAMPLER));
+    sampler = VK_NULL_HANDLE;
+    descriptorAllocator.cleanup();
+    buildPipeline.cleanup();
+}
+
+void HiZPyramid::createPyramid(DepthBuffer* pdepthBuffer) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    auto logicalDevice = pdevice->getLogicalDevice();
+
+    // Level 0 texels cover 2x2 depth pixels, the sizes are rounded up so that the last row and column are covered too
+    depthExtent = pdepthBuffer->getExtent();
+    VkExtent2D extent = depthExtent;
+    levelExtents.clear();
+    do {
+        extent = { std::max((extent.width + 1) / 2, 1u), std::max((extent.height + 1) / 2, 1u) };
+        levelExtents.push_back(extent);
+    } while (extent.width > 1 || extent.height > 1);
+    uint32_t levelCount = static_cast<uint32_t>(levelExtents.size());
+
+    createImage(
+        pdevice,
+        levelExtents[0].width,
+        levelExtents[0].height,
+        VK_FORMAT_R32_SFLOAT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        image,
+        imageMemory,
+        levelCount
+    );
+    imageView = createImageView(pdevice, image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount);
+
+    levelViews.resize(levelCount);
+    levelSets.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++) {
+        levelViews[level] = createImageView(pdevice, image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1);
+        levelSets[level] = descriptorAllocator.allocate(setLayout);
+
+        VkDescriptorImageInfo inputInfo{};
+        inputInfo.sampler = sampler;
+        if (level == 0) {
+            inputInfo.imageView = pdepthBuffer->getImageView();
+            inputInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL; // Left by the early render pass
+        }
+        else {
+            inputInfo.imageView = levelViews[level - 1];
+            inputInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+
+        VkDescriptorImageInfo outputInfo{};
+        outputInfo.imageView = levelViews[level];
+        outputInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet descriptorWrites[2]{};
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = levelSets[level];
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pImageInfo = &inputInfo;
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = levelSets[level];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pImageInfo = &outputInfo;
+
+        vkUpdateDescriptorSets(logicalDevice, 2, descriptorWrites, 0, nullptr);
+    }
+}
+
+void HiZPyramid::cleanupPyramid() {
+    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (VkImageView levelView : levelViews) {
+        vkDestroyImageView(logicalDevice, levelView, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    levelViews.clear();
+    levelSets.clear();
+    descriptorAllocator.resetPools();
+
+    if (imageView != VK_NULL_HANDLE) {
+        vkDestroyImageView(logicalDevice, imageView, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(logicalDevice, image, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE));
+        vkFreeMemory(logicalDevice, imageMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        imageView = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        imageMemory = VK_NULL_HANDLE;
+    }
+}
+
+void HiZPyramid::cmdBuild(VkCommandBuffer commandBuffer) {
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+    uint32_t levelCount = static_cast<uint32_t>(levelExtents.size());
+
+    // The previous content is not needed, every level is rewritten. The barrier also waits for the culling of the
+    // previous frame, which still reads the pyramid
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+    vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkd.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, buildPipeline.getPipeline());
+
+    VkExtent2D inputExtent = depthExtent;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        VkExtent2D outputExtent = levelExtents[level];
+        BuildConstants constants{ inputExtent.width, inputExtent.height, outputExtent.width, outputExtent.height };
+
+        vkd.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, buildPipeline.getPipelineLayout(), 0, 1, &levelSets[level], 0, nullptr);
+        vkd.vkCmdPushConstants(commandBuffer, buildPipeline.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkd.vkCmdDispatch(commandBuffer, (outputExtent.width + GROUP_SIZE - 1) / GROUP_SIZE, (outputExtent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+        // The next dispatch (or the culling, after the last level) reads the level that was just written
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+        vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        inputExtent = outputExtent;
+    }
+}
+
+VkImageView HiZPyramid::getImageView() {
+    return imageView;
+}
+
+VkSampler HiZPyramid::getSampler() {
+    return sampler;
+}
+
+VkExtent2D HiZPyramid::getDepthExtent() {
+    return depthExtent;
+}
+
+uint32_t HiZPyramid::getLevelCount() {
+    return static_cast<uint32_t>(levelExtents.size());
+}
@@ -2,7 +2,7 @@
 
 // Create an image view for each swapchainImages
 void ImageViews::initialize(SwapChain* swapchain) {
-	std::vector<VkImage> swapchainImages = swapchain->getSwapChainImages();
+	const std::vector<VkImage>& swapchainImages = swapchain->getSwapChainImages();
 	swapChainImageViews.resize(swapchainImages.size());
 
 	for (size_t i = 0; i < swapchainImages.size(); i++) {
@@ -28,7 +28,7 @@ void ImageViews::initialize(SwapChain* swapchain) {
 		createInfo.subresourceRange.baseArrayLayer = 0;
 		createInfo.subresourceRange.layerCount = 1;
 
-		if (vkCreateImageView(RendererContext::getInstance().pdevice->getLogicalDevice(), &createInfo, nullptr, &swapChainImageViews[i]) != VK_SUCCESS) {
+		if (vkCreateImageView(RendererContext::getInstance().pdevice->getLogicalDevice(), &createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW), &swapChainImageViews[i]) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image views!");
 		}
 	}
@@ -37,10 +37,10 @@ void ImageViews::initialize(SwapChain* swapchain) {
 // Destroy every image views
 void ImageViews::cleanup() {
 	for (auto imageView : swapChainImageViews) {
-		vkDestroyImageView(RendererContext::getInstance().pdevice->getLogicalDevice(), imageView, nullptr);
+		vkDestroyImageView(RendererContext::getInstance().pdevice->getLogicalDevice(), imageView, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
 	}
 }
 
-std::vector<VkImageView> ImageViews::getSwapChainImageViews() {
+const std::vector<VkImageView>& ImageViews::getSwapChainImageViews() {
 	return swapChainImageViews;
 }
\ No newline at end of file
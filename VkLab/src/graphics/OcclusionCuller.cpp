@@ -0,0 +1,201 @@
+#include "graphics/OcclusionCuller.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+CullCamera CullCamera::fromView(const glm::mat4& view, const glm::mat4& proj, HiZPyramid* ppyramid) {
+    CullCamera camera{};
+    camera.view = view;
+    camera.projection = glm::vec4(proj[0][0], proj[1][1], proj[2][2], proj[3][2]);
+    VkExtent2D depthExtent = ppyramid->getDepthExtent();
+    camera.depthExtent = glm::uvec2(depthExtent.width, depthExtent.height);
+    camera.nearPlane = CAMERA_NEAR_PLANE;
+    camera.pyramidLevelCount = ppyramid->getLevelCount();
+    return camera;
+}
+
+void OcclusionCuller::initialize(CommandPools* pcommandPools, DescriptorLayoutCache* playoutCache, HiZPyramid* ppyramid, BufferManager* pbufferManager) {
+    this->ppyramid = ppyramid;
+
+    // Binding 0: Hi-Z pyramid, 1: input of the frame, 2: early draws, 3: late draws
+    VkDescriptorSetLayoutBinding bindings[4]{};
+    for (uint32_t i = 0; i < 4; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 4;
+    layoutInfo.pBindings = bindings;
+    setLayout = playoutCache->createDescriptorLayout(&layoutInfo);
+
+    cullPipeline.initialize(readFile("shaders/cull.spv"), { setLayout });
+
+    // Bounding sphere of the mesh around its origin, scaled per object by its transform: it reaches the corner of the
+    // mesh bounds that is farthest from the origin
+    glm::vec3 farthestCorner = glm::max(glm::abs(pbufferManager->getMeshBoundsMin()), glm::abs(pbufferManager->getMeshBoundsMax()));
+    meshRadius = glm::length(farthestCorner);
+
+    createBuffers(pcommandPools);
+
+    descriptorAllocator.initialize(MAX_FRAMES_IN_FLIGHT);
+    for (auto& descriptorSet : descriptorSets) {
+        descriptorSet = descriptorAllocator.allocate(setLayout);
+    }
+    writeDescriptorSets();
+}
+
+void OcclusionCuller::cleanup() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vkDestroyBuffer(logicalDevice, inputBuffers[i], getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, inputBuffersMemory[i], getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+    vkDestroyBuffer(logicalDevice, earlyDrawBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, earlyDrawBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, lateDrawBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, lateDrawBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+    descriptorAllocator.cleanup();
+    cullPipeline.cleanup();
+}
+
+// Only the pyramid binding references the swap chain resources, the sets are not in use (the device is idle)
+void OcclusionCuller::bindPyramid(HiZPyramid* ppyramid) {
+    this->ppyramid = ppyramid;
+    writeDescriptorSets();
+}
+
+void OcclusionCuller::createBuffers(CommandPools* pcommandPools) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    VkDevice logicalDevice = pdevice->getLogicalDevice();
+
+    VkDeviceSize inputSize = sizeof(CullFrameData) + sizeof(CullObject) * MAX_OBJECTS;
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        createBuffer(pdevice, inputSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, inputBuffers[i], inputBuffersMemory[i]);
+        vkMapMemory(logicalDevice, inputBuffersMemory[i], 0, inputSize, 0, &inputBuffersMapped[i]);
+    }
+    sphereUploads.initialize(MAX_OBJECTS);
+
+    VkDeviceSize drawSize = VkDeviceSize(DRAW_COMMAND_STRIDE) * MAX_OBJECTS;
+    VkBufferUsageFlags drawUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    createBuffer(pdevice, drawSize, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, earlyDrawBuffer, earlyDrawBufferMemory);
+    createBuffer(pdevice, drawSize, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, lateDrawBuffer, lateDrawBufferMemory);
+
+    // Nothing was visible before the first frame: its early phase draws nothing and the late phase draws what it finds visible
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, pcommandPools->getDrawCommandPool());
+    vkCmdFillBuffer(commandBuffer, earlyDrawBuffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(commandBuffer, lateDrawBuffer, 0, VK_WHOLE_SIZE, 0);
+    endSingleTimeCommands(logicalDevice, pdevice->getGraphicsQueue(), pcommandPools->getDrawCommandPool(), commandBuffer);
+}
+
+void OcclusionCuller::writeDescriptorSets() {
+    VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkDescriptorImageInfo pyramidInfo{};
+        pyramidInfo.sampler = ppyramid->getSampler();
+        pyramidInfo.imageView = ppyramid->getImageView();
+        pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorBufferInfo bufferInfos[3]{};
+        bufferInfos[0] = { inputBuffers[i], 0, VK_WHOLE_SIZE };
+        bufferInfos[1] = { earlyDrawBuffer, 0, VK_WHOLE_SIZE };
+        bufferInfos[2] = { lateDrawBuffer, 0, VK_WHOLE_SIZE };
+
+        VkWriteDescriptorSet descriptorWrites[4]{};
+        for (uint32_t binding = 0; binding < 4; binding++) {
+            descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[binding].dstSet = descriptorSets[i];
+            descriptorWrites[binding].dstBinding = binding;
+            descriptorWrites[binding].descriptorCount = 1;
+            if (binding == 0) {
+                descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorWrites[binding].pImageInfo = &pyramidInfo;
+            }
+            else {
+                descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorWrites[binding].pBufferInfo = &bufferInfos[binding - 1];
+            }
+        }
+
+        vkUpdateDescriptorSets(logicalDevice, 4, descriptorWrites, 0, nullptr);
+    }
+}
+
+void OcclusionCuller::update(uint32_t currentFrame, const EntityStore& entities, const LodSelector& lodSelector, const glm::mat4& view, const glm::mat4& proj) {
+    auto pdata = static_cast<char*>(inputBuffersMapped[currentFrame]);
+    uint32_t objectCount = std::min(entities.size(), MAX_OBJECTS);
+
+    CullFrameData frame{};
+    frame.camera = CullCamera::fromView(view, proj, ppyramid);
+    frame.objectCount = objectCount;
+    memcpy(pdata, &frame, sizeof(frame));
+
+    auto pobjects = reinterpret_cast<CullObject*>(pdata + sizeof(CullFrameData));
+    sphereUploads.markChanged(entities.getChangedEntities());
+    sphereUploads.markChanged(lodSelector.getChangedObjects());
+    for (Entity i : sphereUploads.takeStaleObjects(currentFrame)) {
+        const glm::mat4& model = entities.getWorldTransform(i);
+        // The largest axis scale keeps the sphere conservative under non-uniform scaling
+        float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+
+        CullObject object{};
+        object.sphere = glm::vec4(glm::vec3(model[3]), meshRadius * scale);
+        const MeshLod& lod = lodSelector.getObjectLod(i);
+        object.indexCount = lod.indexCount;
+        object.firstIndex = lod.firstIndex;
+        object.vertexOffset = 0;
+        pobjects[i] = object;
+    }
+}
+
+void OcclusionCuller::cmdBeginFrame(VkCommandBuffer commandBuffer) {
+    // The early draws were written by the culling of the previous frame, the culling of this frame reads and rewrites them
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    RendererContext::getInstance().pdevice->getDispatch().vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr
+    );
+}
+
+void OcclusionCuller::cmdCull(VkCommandBuffer commandBuffer, uint32_t currentFrame, uint32_t objectCount) {
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+
+    ppyramid->cmdBuild(commandBuffer);
+
+    // The early draws must have read their indirect commands before they are overwritten (execution dependency only)
+    vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    vkd.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.getPipeline());
+    vkd.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline.getPipelineLayout(), 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+    vkd.vkCmdDispatch(commandBuffer, (std::min(objectCount, MAX_OBJECTS) + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    // The late draws read the commands that were just written
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkd.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+VkBuffer OcclusionCuller::getEarlyDrawBuffer() {
+    return earlyDrawBuffer;
+}
+
+VkBuffer OcclusionCuller::getLateDrawBuffer() {
+    return lateDrawBuffer;
+}
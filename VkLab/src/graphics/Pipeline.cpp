@@ -1,17 +1,46 @@
 #include "graphics/Pipeline.h"
+#include "core/Constant.h"
+#include "graphics/BindlessTextureSet.h"
+#include "graphics/DescriptorSet.h"
 
-void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset) {
-    auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+#include <type_traits>
+
+// Plain file reads, they don't need the device and run while the instance and the device are created
+PipelineShaderCode PipelineShaderCode::load() {
+    PipelineShaderCode shaderCode;
+    shaderCode.vertex = readFile("shaders/vert.spv");
+    shaderCode.vertexObjectUbo = readFile("shaders/vert_ubo.spv");
+    shaderCode.fragment = readFile("shaders/frag.spv");
+    shaderCode.depthVertex = readFile("shaders/depth.spv");
+    shaderCode.depthVertexObjectUbo = readFile("shaders/depth_ubo.spv");
+    // Disabled, the mesh shader path needs neither its SPIR-V nor a compiler that targets it
+    if (USE_MESH_SHADERS) {
+        shaderCode.meshletTask = readFile("shaders/meshlet_task.spv");
+        shaderCode.meshletMesh = readFile("shaders/meshlet_mesh.spv");
+    }
+    return shaderCode;
+}
+
+void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset, BindlessTextureSet* pbindlessTextureSet, const PipelineShaderCode& shaderCode, bool allowPushConstants) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    auto logicalDevice = pdevice->getLogicalDevice();
+
+    // Push constants are the fastest way to send small per-draw data, but their size is limited by the device
+    // (at least 128 bytes is guaranteed). Fall back to the dynamic UBO path if the block doesn't fit
+    // or if the caller needs the per-draw data outside of the command buffer (reused command buffers)
+    pushConstantsEnabled = allowPushConstants && sizeof(ObjectUniformBufferObject) <= pdevice->getProperties().limits.maxPushConstantsSize;
 
-    // Load shaders
-	auto vertShaderCode = readFile("shaders/vert.spv");
-	auto fragShaderCode = readFile("shaders/frag.spv");
+    // Shaders were loaded beforehand (vert_ubo.spv is the same shader compiled with OBJECT_UBO defined)
+	const auto& vertShaderCode = pushConstantsEnabled ? shaderCode.vertex : shaderCode.vertexObjectUbo;
+	const auto& fragShaderCode = shaderCode.fragment;
+	const auto& depthShaderCode = pushConstantsEnabled ? shaderCode.depthVertex : shaderCode.depthVertexObjectUbo;
 	std::cout << "vertShader size: " << vertShaderCode.size() << " octets" << std::endl; // Debug
 	std::cout << "fragShader size: " << fragShaderCode.size() << " octets" << std::endl; // Debug
 
     // Shader modules are just a thin wrapper around the shader bytecode that weve previously loaded
 	VkShaderModule vertShaderModule = createShaderModule(vertShaderCode, &logicalDevice);
 	VkShaderModule fragShaderModule = createShaderModule(fragShaderCode, &logicalDevice);
+	VkShaderModule depthShaderModule = createShaderModule(depthShaderCode, &logicalDevice);
 
     // To actually use the shaders well need to assign them to a specific pipeline stage
     // through VkPipelineShaderStageCreateInfo structures as part of the actual pipeline creation process
@@ -30,9 +59,13 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     // Define pipeline shader stages
     VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-    // Pass all Vertex descriptions into the VkPipelineVertexInputStateCreateInfo
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescription = Vertex::getAttributeDescriptions();
+    // The depth pre-pass only has a vertex shader: without a fragment shader, the fragments only go through the depth test
+    VkPipelineShaderStageCreateInfo depthShaderStageInfo = vertShaderStageInfo;
+    depthShaderStageInfo.module = depthShaderModule;
+
+    // Pass all vertex descriptions into the VkPipelineVertexInputStateCreateInfo, they are generated from the layout of the vertex buffer
+    auto bindingDescription = MeshVertexLayout::getBindingDescription();
+    auto attributeDescription = MeshVertexLayout::getAttributeDescriptions();
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{}; 
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -41,6 +74,17 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescription.data();
 
+    // The pre-pass reads a separate, tightly packed position stream: less memory to fetch per vertex
+    auto positionBindingDescription = PositionVertexLayout::getBindingDescription();
+    auto positionAttributeDescriptions = PositionVertexLayout::getAttributeDescriptions();
+
+    VkPipelineVertexInputStateCreateInfo positionInputInfo{};
+    positionInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    positionInputInfo.vertexBindingDescriptionCount = 1;
+    positionInputInfo.pVertexBindingDescriptions = &positionBindingDescription;
+    positionInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(positionAttributeDescriptions.size());
+    positionInputInfo.pVertexAttributeDescriptions = positionAttributeDescriptions.data();
+
     // Describes two things: 1) what kind of geometry will be drawn from the vertices 2) if primitive restart should be enabled.
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -93,6 +137,10 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
     colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
 
+    // The pre-pass doesn't write any color
+    VkPipelineColorBlendAttachmentState depthOnlyBlendAttachment = colorBlendAttachment;
+    depthOnlyBlendAttachment.colorWriteMask = 0;
+
     // References the array of structures for all of the framebuffers and allows you to set blend constants
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -105,6 +153,27 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     colorBlending.blendConstants[2] = 0.0f; // Optional
     colorBlending.blendConstants[3] = 0.0f; // Optional
 
+    VkPipelineColorBlendStateCreateInfo depthOnlyBlending = colorBlending;
+    depthOnlyBlending.pAttachments = &depthOnlyBlendAttachment;
+
+    // Depth test of the three variants of the pipeline:
+    // - without pre-pass, the usual test: keep the closest fragment and write its depth
+    // - in the pre-pass, the same test, but only the depth is written
+    // - after the pre-pass, the depth buffer already holds the closest depth of every pixel: only the fragment with exactly
+    //   that depth passes (EQUAL, no write), so the full fragment shader runs once per pixel whatever the draw order
+    // EQUAL only works because both vertex shaders compute the same position (invariant gl_Position)
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS; // Lower depth = closer
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    VkPipelineDepthStencilStateCreateInfo depthEqualStencil = depthStencil;
+    depthEqualStencil.depthWriteEnable = VK_FALSE;
+    depthEqualStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
     // States that can change at draw time (dynamic VIEWPORT and SCISSOR)
     std::vector<VkDynamicState> dynamicStates = {
         VK_DYNAMIC_STATE_VIEWPORT,
@@ -115,15 +184,31 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
     
+    // Sets ordered by update frequency (see DescriptorSetIndex), identical for every pipeline so they stay compatible
+    auto descriptorSetLayouts = pdescriptorset->getDescriptorSetLayouts();
+    VkDescriptorSetLayout setLayouts[] = {
+        descriptorSetLayouts[FRAME_SET],
+        descriptorSetLayouts[MATERIAL_SET],
+        descriptorSetLayouts[OBJECT_SET],
+        *pbindlessTextureSet->getDescriptorSetLayoutPtr() // BINDLESS_SET
+    };
+
+    // Per-draw block, only read by the vertex shader (the material index is forwarded to the fragment shader)
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ObjectUniformBufferObject);
+
     // To push uniform values in shaders
+    // Set 2 stays in the layout even on the push constant path, so the set numbering is the same for every pipeline
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1; // Optional - Used for UBOs
-    pipelineLayoutInfo.pSetLayouts = pdescriptorset->getDescriptorSetLayoutPtr(); // Optional - Used for UBOs
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+    pipelineLayoutInfo.setLayoutCount = 4; // Used for UBOs and textures
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = pushConstantsEnabled ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantsEnabled ? &pushConstantRange : nullptr;
 
-    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
 
@@ -139,7 +224,7 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
     pipelineInfo.pDynamicState = &dynamicState;
 
@@ -151,22 +236,98 @@ void Pipeline::initialize(RenderPass* prenderpass, DescriptorSet* pdescriptorset
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional Vulkan allows you to create a new graphics pipeline by deriving from an existing pipeline.
     pipelineInfo.basePipelineIndex = -1; // Optional
 
-    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    VkGraphicsPipelineCreateInfo depthEqualPipelineInfo = pipelineInfo;
+    depthEqualPipelineInfo.pDepthStencilState = &depthEqualStencil;
+
+    VkGraphicsPipelineCreateInfo depthPrepassPipelineInfo = pipelineInfo;
+    depthPrepassPipelineInfo.stageCount = 1;
+    depthPrepassPipelineInfo.pStages = &depthShaderStageInfo;
+    depthPrepassPipelineInfo.pVertexInputState = &positionInputInfo;
+    depthPrepassPipelineInfo.pColorBlendState = &depthOnlyBlending;
+
+    // Created in a single call, the driver may compile them in parallel
+    VkGraphicsPipelineCreateInfo pipelineInfos[] = { pipelineInfo, depthEqualPipelineInfo, depthPrepassPipelineInfo };
+    VkPipeline pipelines[3];
+    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 3, pipelineInfos, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE), pipelines) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
+    graphicsPipeline = pipelines[0];
+    depthEqualPipeline = pipelines[1];
+    depthPrepassPipeline = pipelines[2];
+
+    // Mesh shader variants: the task and mesh shaders replace the vertex input, the input assembly and the vertex shader,
+    // the fixed function states and the fragment shader stay the same
+    VkDescriptorSetLayout meshletSetLayout = pdescriptorset->getMeshletSetLayout();
+    if (meshletSetLayout != VK_NULL_HANDLE) {
+        // meshlet.mesh fetches the vertices from a storage buffer, 5 words in this order
+        static_assert(std::is_same_v<MeshVertexLayout, VertexLayout<PositionSnorm16, NormalOctahedral16, TexCoordHalf, ColorUnorm8>>, "meshlet.mesh decodes another vertex layout");
+
+        VkDescriptorSetLayout meshletSetLayouts[] = { setLayouts[FRAME_SET], setLayouts[MATERIAL_SET], setLayouts[OBJECT_SET], setLayouts[BINDLESS_SET], meshletSetLayout };
+
+        VkPushConstantRange meshletPushConstantRange{};
+        meshletPushConstantRange.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+        meshletPushConstantRange.offset = 0;
+        meshletPushConstantRange.size = sizeof(MeshletPushConstants);
+
+        VkPipelineLayoutCreateInfo meshletLayoutInfo = pipelineLayoutInfo;
+        meshletLayoutInfo.setLayoutCount = 5;
+        meshletLayoutInfo.pSetLayouts = meshletSetLayouts;
+        meshletLayoutInfo.pushConstantRangeCount = 1;
+        meshletLayoutInfo.pPushConstantRanges = &meshletPushConstantRange;
+
+        if (vkCreatePipelineLayout(logicalDevice, &meshletLayoutInfo, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &meshletPipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create meshlet pipeline layout!");
+        }
+
+        VkShaderModule taskShaderModule = createShaderModule(shaderCode.meshletTask, &logicalDevice);
+        VkShaderModule meshShaderModule = createShaderModule(shaderCode.meshletMesh, &logicalDevice);
+
+        VkPipelineShaderStageCreateInfo meshletShaderStages[3] = { vertShaderStageInfo, vertShaderStageInfo, fragShaderStageInfo };
+        meshletShaderStages[0].stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+        meshletShaderStages[0].module = taskShaderModule;
+        meshletShaderStages[1].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+        meshletShaderStages[1].module = meshShaderModule;
+
+        VkGraphicsPipelineCreateInfo meshletPipelineInfos[] = { pipelineInfo, depthEqualPipelineInfo, depthPrepassPipelineInfo };
+        for (auto& meshletPipelineInfo : meshletPipelineInfos) {
+            meshletPipelineInfo.stageCount = &meshletPipelineInfo == &meshletPipelineInfos[2] ? 2 : 3; // The pre-pass has no fragment shader
+            meshletPipelineInfo.pStages = meshletShaderStages;
+            meshletPipelineInfo.pVertexInputState = nullptr;
+            meshletPipelineInfo.pInputAssemblyState = nullptr;
+            meshletPipelineInfo.layout = meshletPipelineLayout;
+        }
+
+        VkPipeline meshletPipelines[3];
+        if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 3, meshletPipelineInfos, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE), meshletPipelines) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create meshlet graphics pipeline!");
+        }
+        meshletGraphicsPipeline = meshletPipelines[0];
+        meshletDepthEqualPipeline = meshletPipelines[1];
+        meshletDepthPrepassPipeline = meshletPipelines[2];
+
+        vkDestroyShaderModule(logicalDevice, meshShaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+        vkDestroyShaderModule(logicalDevice, taskShaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+    }
 
-    vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
-    vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+    vkDestroyShaderModule(logicalDevice, depthShaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(logicalDevice, fragShaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(logicalDevice, vertShaderModule, getAllocationCallbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+
+    generation++;
 }
 
 void Pipeline::cleanup() {
     auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-    if (graphicsPipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
+    for (VkPipeline pipeline : { graphicsPipeline, depthEqualPipeline, depthPrepassPipeline, meshletGraphicsPipeline, meshletDepthEqualPipeline, meshletDepthPrepassPipeline }) {
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(logicalDevice, pipeline, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE));
+        }
     }
-    if (pipelineLayout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+    for (VkPipelineLayout layout : { pipelineLayout, meshletPipelineLayout }) {
+        if (layout != VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(logicalDevice, layout, getAllocationCallbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        }
     }
 }
 
@@ -176,4 +337,35 @@ VkPipelineLayout Pipeline::getPipelineLayout() {
 
 VkPipeline Pipeline::getGraphicsPipeline() {
     return graphicsPipeline;
-}
\ No newline at end of file
+}
+
+VkPipeline Pipeline::getDepthEqualPipeline() {
+    return depthEqualPipeline;
+}
+
+VkPipeline Pipeline::getDepthPrepassPipeline() {
+    return depthPrepassPipeline;
+}
+
+bool Pipeline::usesPushConstants() {
+    return pushConstantsEnabled;
+}
+
+uint64_t Pipeline::getGeneration() {
+    return generation;
+}
+VkPipelineLayout Pipeline::getMeshletPipelineLayout() {
+    return meshletPipelineLayout;
+}
+
+VkPipeline Pipeline::getMeshletGraphicsPipeline() {
+    return meshletGraphicsPipeline;
+}
+
+VkPipeline Pipeline::getMeshletDepthEqualPipeline() {
+    return meshletDepthEqualPipeline;
+}
+
+VkPipeline Pipeline::getMeshletDepthPrepassPipeline() {
+    return meshletDepthPrepassPipeline;
+}
@@ -1,15 +1,25 @@
 #include "graphics/RenderPass.h"
 
-void RenderPass::initialize(SwapChain* pswapchain) {
+void RenderPass::initialize(SwapChain* pswapchain, VkFormat depthFormat) {
+	VkFormat colorFormat = pswapchain->getSwapChainImageFormat();
+
+	renderPass = createRenderPass(colorFormat, depthFormat, true, true);
+	earlyRenderPass = createRenderPass(colorFormat, depthFormat, true, false);
+	lateRenderPass = createRenderPass(colorFormat, depthFormat, false, true);
+}
+
+// The first pass of a frame clears the attachments, the last one hands the image to the presentation engine.
+// Between two passes the color stays an attachment and the depth is stored to be read by the compute shaders
+VkRenderPass RenderPass::createRenderPass(VkFormat colorFormat, VkFormat depthFormat, bool firstPass, bool lastPass) {
 	// Attachments are images or buffers that serve as inputs and outputs during rendering
 	// They include color attachments (e.g., the images you render to) and depth/stencil attachments (used for depth and stencil testing)
 	// Each attachment is described by its format, sample count, and the actions to perform at the beginning and end of the render pass,
 	// such as clearing or preserving their contents.
 	
 	VkAttachmentDescription colorAttachment{}; // Single color attachement for now
-	colorAttachment.format = pswapchain->getSwapChainImageFormat();
+	colorAttachment.format = colorFormat;
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; // Clear the values to a constant at the start
+	colorAttachment.loadOp = firstPass ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD; // Clear the values to a constant at the start
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Rendered contents will be stored in memory and can be read later
 
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // Our application wont do anything with the stencil buffer
@@ -17,53 +27,108 @@ void RenderPass::initialize(SwapChain* pswapchain) {
 
 	// Images need to be transitioned to specific layouts that are suitable for the operation that theyre going to be involved in next.
 	// InitialLayout specifies which layout the image will have before the render pass begins.
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.initialLayout = firstPass ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	// FinalLayout specifies the layout to automatically transition to when the render pass finishes.
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // Images to be presented in the swap chain
+	colorAttachment.finalLayout = lastPass ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // Images to be presented in the swap chain
+
+	// The depth attachment is cleared to the far plane at the start, its content is only needed after the render pass
+	// when another pass follows: it is then left in a read-only layout that the compute shaders can sample
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = firstPass ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = lastPass ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = firstPass ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthAttachment.finalLayout = lastPass ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
 	VkAttachmentReference colorAttachmentRef{};
 	colorAttachmentRef.attachment = 0; // Index 0 refers to our single colorAttachment
 	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // We intend to use the attachment to function as a color buffer
 
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 	VkSubpassDescription subpass{};
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS; // We have to be explicit about this being a graphics subpass
 	subpass.colorAttachmentCount = 1;
 	subpass.pColorAttachments = &colorAttachmentRef; // Directly referenced from the fragment shader with the layout(location = 0) out vec4 outColor directive
+	subpass.pDepthStencilAttachment = &depthAttachmentRef; // A subpass has at most one depth attachment
 
 	// Create Subpass dependencies for synchronization
-	VkSubpassDependency dependency{};
+	VkSubpassDependency dependencies[2]{};
+	VkSubpassDependency& dependency = dependencies[0];
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL; // Refers to the implicit subpass before or after the render pass depending on whether it is specified in srcSubpass or dstSubpass
 	dependency.dstSubpass = 0;
 
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // Specify the operations to wait on and the stages in which these operations occur.
+	// The depth image is shared by every frame: the depth tests of this frame also wait for the ones of the previous frame
+	// A pass following the compute work also waits for the compute shaders that sampled the depth before writing it again
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT; // Specify the operations to wait on and the stages in which these operations occur.
+	if (!firstPass) {
+		dependency.srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	}
 	// We need to wait for the swap chain to finish reading from the image before we can access it.
 	// This can be accomplished by waiting on the color attachment output stage itself.
-	dependency.srcAccessMask = 0;
+	dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | (firstPass ? 0 : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
 
 	// The operations that should wait on this are in the color attachment stage and involve the writing of the color attachment.
 	// These settings will prevent the transition from happening until its actually necessary (and allowed): when we want to start writing colors to it.
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	if (!firstPass) {
+		dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT; // Loaded contents
+	}
+
+	// When the depth is kept, the compute shaders sampling it wait for the depth writes and the layout transition at the end
+	uint32_t dependencyCount = 1;
+	if (!lastPass) {
+		VkSubpassDependency& exitDependency = dependencies[dependencyCount++];
+		exitDependency.srcSubpass = 0;
+		exitDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		exitDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		exitDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		exitDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		exitDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	}
 
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = 1;
-	renderPassInfo.pAttachments = &colorAttachment;
+	VkAttachmentDescription attachments[] = { colorAttachment, depthAttachment };
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
 	// Add our Subpass dependencies
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = dependencyCount;
+	renderPassInfo.pDependencies = dependencies;
 
-	if (vkCreateRenderPass(RendererContext::getInstance().pdevice->getLogicalDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+	VkRenderPass createdRenderPass;
+	if (vkCreateRenderPass(RendererContext::getInstance().pdevice->getLogicalDevice(), &renderPassInfo, getAllocationCallbacks(VK_OBJECT_TYPE_RENDER_PASS), &createdRenderPass) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create render pass!");
 	}
+
+	return createdRenderPass;
 }
 
 void RenderPass::cleanup() {
-	vkDestroyRenderPass(RendererContext::getInstance().pdevice->getLogicalDevice(), renderPass, nullptr);
+	VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
+
+	for (VkRenderPass* prenderPass : { &renderPass, &earlyRenderPass, &lateRenderPass }) {
+		vkDestroyRenderPass(logicalDevice, *prenderPass, getAllocationCallbacks(VK_OBJECT_TYPE_RENDER_PASS));
+		*prenderPass = VK_NULL_HANDLE;
+	}
 }
 
 VkRenderPass RenderPass::getRenderPass() {
 	return renderPass;
-}
\ No newline at end of file
+}
+
+VkRenderPass RenderPass::getEarlyRenderPass() {
+	return earlyRenderPass;
+}
+
+VkRenderPass RenderPass::getLateRenderPass() {
+	return lateRenderPass;
+}
@@ -1,6 +1,6 @@
 #include "graphics/SwapChain.h"
 
-void SwapChain::initialize(GLFWwindow* pwindow) {
+void SwapChain::initialize(GLFWwindow* pwindow, const std::vector<VkPresentModeKHR>& presentModePreference) {
     VkPhysicalDevice physicalDevice = RendererContext::getInstance().pdevice->getPhysicalDevice();
     VkDevice logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
     VkSurfaceKHR surface = RendererContext::getInstance().surface;
@@ -10,7 +10,7 @@ void SwapChain::initialize(GLFWwindow* pwindow) {
     // Select surface format
     VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
     // Select present mode
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, presentModePreference);
     // Select the resolution of swap chain images
     VkExtent2D extent = chooseSwapExtent(pwindow, swapChainSupport.capabilities);
 
@@ -35,7 +35,7 @@ void SwapChain::initialize(GLFWwindow* pwindow) {
 
     // Specify how to handle swap chain images that will be used across multiple queue families
     // (if graphicsFamily and presentFamily are not the same)
-    QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+    const QueueFamilyIndices& indices = RendererContext::getInstance().pdevice->getQueueFamilyIndices();
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
     if (indices.graphicsFamily != indices.presentFamily) {
@@ -53,7 +53,7 @@ void SwapChain::initialize(GLFWwindow* pwindow) {
     createInfo.clipped = VK_TRUE; // Means that we dont care about the color of pixels that are obscured
     createInfo.oldSwapchain = VK_NULL_HANDLE; // We assume that well only ever create one swap chain
 
-    if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
+    if (vkCreateSwapchainKHR(logicalDevice, &createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR), &swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
     }
 
@@ -68,7 +68,7 @@ void SwapChain::initialize(GLFWwindow* pwindow) {
 
 void SwapChain::cleanup() {
     if (swapChain != VK_NULL_HANDLE) {
-        vkDestroySwapchainKHR(RendererContext::getInstance().pdevice->getLogicalDevice(), swapChain, nullptr);
+        vkDestroySwapchainKHR(RendererContext::getInstance().pdevice->getLogicalDevice(), swapChain, getAllocationCallbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
     }
 }
 
@@ -76,7 +76,7 @@ const VkSwapchainKHR SwapChain::getSwapChain() {
     return swapChain;
 }
 
-const std::vector<VkImage> SwapChain::getSwapChainImages() {
+const std::vector<VkImage>& SwapChain::getSwapChainImages() {
     return swapChainImages;
 }
 
@@ -99,15 +99,15 @@ VkSurfaceFormatKHR SwapChain::chooseSwapSurfaceFormat(const std::vector<VkSurfac
     return availableFormats[0];
 }
 
-// Select VK_PRESENT_MODE_MAILBOX_KHR if available 
-VkPresentModeKHR SwapChain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return availablePresentMode;
+// Select the first available present mode of the preference list (decided by the frame pacing mode)
+VkPresentModeKHR SwapChain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, const std::vector<VkPresentModeKHR>& presentModePreference) {
+    for (const auto& presentMode : presentModePreference) {
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end()) {
+            return presentMode;
         }
     }
 
-    return VK_PRESENT_MODE_FIFO_KHR;
+    return VK_PRESENT_MODE_FIFO_KHR; // Only mode guaranteed to be available
 }
 
 // Select the resolution of swap chain images
@@ -7,20 +7,32 @@
 // and add a flushSetupCommands to execute the commands that have been recorded so far.Its best to do this after the texture mapping works
 // to check if the texture resources are still set up correctly.
 
-void TextureImage::initialize(CommandPools commandPools) {
+void DecodedImage::PixelsDeleter::operator()(unsigned char* pixels) const {
+    stbi_image_free(pixels);
+}
+
+// Loading the image with stb_image library (forced to 4 channels)
+DecodedImage DecodedImage::load(const char* filename) {
+    DecodedImage image;
+    int channels;
+    image.pixels.reset(stbi_load(filename, &image.width, &image.height, &channels, STBI_rgb_alpha));
+
+    if (!image.pixels) {
+        throw std::runtime_error("failed to load texture image!");
+    }
+
+    return image;
+}
+
+void TextureImage::initialize(CommandPools commandPools, BindlessTextureSet* pbindlessTextureSet, const DecodedImage& image) {
     auto pdevice = RendererContext::getInstance().pdevice;
     auto logicalDevice = pdevice->getLogicalDevice();
     auto transferCommandPool = commandPools.getTransferCommandPool();
     auto drawCommandPool = commandPools.getDrawCommandPool();
 
-    // Loading the image with stb_image library
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load("textures/statue.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
-    }
+    int texWidth = image.width;
+    int texHeight = image.height;
+    VkDeviceSize imageSize = static_cast<VkDeviceSize>(texWidth) * texHeight * 4;
 
     // Create staging buffer to copy the pixels to it
     VkBuffer stagingBuffer;
@@ -38,11 +50,9 @@ void TextureImage::initialize(CommandPools commandPools) {
     // Copy the pixel values that we got from the image loading library to the buffer
     void* data;
     vkMapMemory(logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    memcpy(data, image.pixels.get(), static_cast<size_t>(imageSize));
     vkUnmapMemory(logicalDevice, stagingBufferMemory);
 
-    stbi_image_free(pixels);
-
     createImage(
         pdevice,
         texWidth,
@@ -64,22 +74,31 @@ void TextureImage::initialize(CommandPools commandPools) {
     // Transition the texture image to start sampling in the shader (for shader access)
     transitionImageLayout(drawCommandPool, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-    vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+    vkDestroyBuffer(logicalDevice, stagingBuffer, getAllocationCallbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, stagingBufferMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+
+    // Write the texture once in the global bindless table, the shaders then only need its index
+    textureImageView = createImageView(pdevice, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+    textureIndex = pbindlessTextureSet->registerTexture(textureImageView);
 }
 
 void TextureImage::cleanup() {
     auto logicalDevice = RendererContext::getInstance().pdevice->getLogicalDevice();
 
-    vkDestroyImage(logicalDevice, textureImage, nullptr);
-    vkFreeMemory(logicalDevice, textureImageMemory, nullptr);
+    vkDestroyImageView(logicalDevice, textureImageView, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    vkDestroyImage(logicalDevice, textureImage, getAllocationCallbacks(VK_OBJECT_TYPE_IMAGE));
+    vkFreeMemory(logicalDevice, textureImageMemory, getAllocationCallbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+}
+
+uint32_t TextureImage::getTextureIndex() {
+    return textureIndex;
 }
 
 // Handle layout transitions (vkCmdCopyBufferToImage needs the image to be in the right layout first)
 void transitionImageLayout(VkCommandPool commandPool, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
     auto pdevice = RendererContext::getInstance().pdevice;
     auto logicalDevice = pdevice->getLogicalDevice();
-    uint32_t graphicsQueueFamily = findQueueFamilies(pdevice->getPhysicalDevice()).graphicsFamily.value();
+    uint32_t graphicsQueueFamily = pdevice->getQueueFamilyIndices().graphicsFamily.value();
 
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, commandPool);
 
@@ -0,0 +1,81 @@
+#include "graphics/VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The VERTEX_INPUT lines the shaders include as GLSL declarations are read here as tables of the inputs, so that a
+// layout change without the matching shader change doesn't compile
+#define VERTEX_INPUT(LOCATION, TYPE, NAME) ShaderVertexInput{ LOCATION, #TYPE, #NAME },
+constexpr ShaderVertexInput MESH_VERTEX_INPUTS[] = {
+#include "../../shaders/mesh_vertex_inputs.glsl"
+};
+constexpr ShaderVertexInput POSITION_VERTEX_INPUTS[] = {
+#include "../../shaders/position_vertex_inputs.glsl"
+};
+#undef VERTEX_INPUT
+
+static_assert(MeshVertexLayout::matchesShaderInputs(MESH_VERTEX_INPUTS), "shaders/mesh_vertex_inputs.glsl doesn't match MeshVertexLayout");
+static_assert(PositionVertexLayout::matchesShaderInputs(POSITION_VERTEX_INPUTS), "shaders/position_vertex_inputs.glsl doesn't match PositionVertexLayout");
+
+VertexQuantization VertexQuantization::fromBounds(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    VertexQuantization quantization;
+    quantization.positionOffset = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+    quantization.positionScale = std::max({ halfExtent.x, halfExtent.y, halfExtent.z });
+    if (quantization.positionScale <= 0.0f) {
+        quantization.positionScale = 1.0f; // A single point, any scale works
+    }
+    return quantization;
+}
+
+glm::mat4 VertexQuantization::getDequantization() const {
+    glm::mat4 dequantization(positionScale);
+    dequantization[3] = glm::vec4(positionOffset, 1.0f);
+    return dequantization;
+}
+
+PositionFloat::Storage PositionFloat::encode(const Vertex& vertex) {
+    return vertex.pos;
+}
+
+PositionSnorm16::Storage PositionSnorm16::encode(const Vertex& vertex, const VertexQuantization& quantization) {
+    glm::vec3 normalized = (vertex.pos - quantization.positionOffset) / quantization.positionScale;
+    Storage storage{};
+    for (int i = 0; i < 3; i++) {
+        storage[i] = static_cast<int16_t>(std::lround(std::clamp(normalized[i], -1.0f, 1.0f) * 32767.0f));
+    }
+    storage[3] = 32767;
+    return storage;
+}
+
+NormalFloat::Storage NormalFloat::encode(const Vertex& vertex) {
+    return vertex.normal;
+}
+
+NormalOctahedral16::Storage NormalOctahedral16::encode(const Vertex& vertex) {
+    // Project on the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals of the square
+    const glm::vec3& n = vertex.normal;
+    float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    glm::vec2 octahedral = sum > 0.0f ? glm::vec2(n.x, n.y) / sum : glm::vec2(0.0f);
+    if (n.z < 0.0f) {
+        octahedral = glm::vec2((1.0f - std::abs(octahedral.y)) * (octahedral.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(octahedral.x)) * (octahedral.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return glm::packSnorm2x16(octahedral);
+}
+
+TexCoordFloat::Storage TexCoordFloat::encode(const Vertex& vertex) {
+    return vertex.texCoord;
+}
+
+TexCoordHalf::Storage TexCoordHalf::encode(const Vertex& vertex) {
+    return glm::packHalf2x16(vertex.texCoord);
+}
+
+ColorFloat::Storage ColorFloat::encode(const Vertex& vertex) {
+    return vertex.color;
+}
+
+ColorUnorm8::Storage ColorUnorm8::encode(const Vertex& vertex) {
+    return glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f));
+}
@@ -0,0 +1,420 @@
+#include "scene/BVH.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // Half the surface area of a box: proportional to the probability that a random ray or small query hits it
+    float halfArea(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+        glm::vec3 size = boundsMax - boundsMin;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    // Slab test: distance along the ray where it enters the box, infinity if it misses it before maxDistance
+    float intersectRay(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance) {
+        glm::vec3 t1 = (boundsMin - origin) * inverseDirection;
+        glm::vec3 t2 = (boundsMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t1, t2);
+        glm::vec3 tFar = glm::max(t1, t2);
+        float enter = std::max({ tNear.x, tNear.y, tNear.z, 0.0f });
+        float exit = std::min({ tFar.x, tFar.y, tFar.z, maxDistance });
+        return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+    }
+
+    bool overlaps(const BVHNode& node, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+        return node.boundsMin.x <= boundsMax.x && node.boundsMax.x >= boundsMin.x
+            && node.boundsMin.y <= boundsMax.y && node.boundsMax.y >= boundsMin.y
+            && node.boundsMin.z <= boundsMax.z && node.boundsMax.z >= boundsMin.z;
+    }
+}
+
+void BVH::initialize(const ObjectStore* pobjectStore, uint32_t capacity) {
+    this->pobjectStore = pobjectStore;
+
+    // A binary tree with at most one object per leaf has 2n - 1 nodes
+    nodes.reserve(2 * capacity);
+    parents.reserve(2 * capacity);
+    objectIndices.reserve(capacity);
+    objectLeaves.reserve(capacity);
+}
+
+void BVH::build() {
+    objectCount = pobjectStore->size();
+    nodes.resize(std::max(1u, 2 * objectCount));
+    parents.resize(nodes.size());
+    objectIndices.resize(objectCount);
+    objectLeaves.resize(objectCount);
+
+    for (uint32_t i = 0; i < objectCount; i++) {
+        objectIndices[i] = i;
+    }
+
+    nodeCount = 0;
+    if (objectCount > 0) {
+        nodeCount = 1;
+        nodes[0].leftFirst = 0;
+        nodes[0].count = objectCount;
+        parents[0] = NO_HIT;
+        updateLeafBounds(0);
+        subdivide(0, 0);
+    }
+
+    computeCostSum();
+    builtCost = getCost();
+}
+
+// Split a leaf in two with the binned surface area heuristic, then recurse in both halves
+void BVH::subdivide(uint32_t nodeIndex, uint32_t depth) {
+    BVHNode& node = nodes[nodeIndex];
+    uint32_t first = node.leftFirst;
+    uint32_t count = node.count;
+
+    auto makeLeaf = [&] {
+        for (uint32_t i = first; i < first + count; i++) {
+            objectLeaves[objectIndices[i]] = nodeIndex;
+        }
+    };
+
+    if (count <= MAX_LEAF_SIZE || depth + 1 >= MAX_DEPTH) {
+        makeLeaf();
+        return;
+    }
+
+    // The split planes are chosen on the bounds of the object centers, not of the objects
+    auto centroid = [&](uint32_t object) {
+        return (pobjectStore->getBoundsMin(object) + pobjectStore->getBoundsMax(object)) * 0.5f;
+    };
+    glm::vec3 centroidMin(std::numeric_limits<float>::max());
+    glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = first; i < first + count; i++) {
+        glm::vec3 center = centroid(objectIndices[i]);
+        centroidMin = glm::min(centroidMin, center);
+        centroidMax = glm::max(centroidMax, center);
+    }
+
+    // Each axis is cut in BIN_COUNT slabs, the objects are counted per slab and the cost of the BIN_COUNT - 1 planes
+    // between them is evaluated with a sweep from both sides
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    uint32_t bestSplit = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+        float scale = BIN_COUNT / extent;
+
+        struct Bin {
+            glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+            uint32_t count = 0;
+        } bins[BIN_COUNT];
+
+        for (uint32_t i = first; i < first + count; i++) {
+            uint32_t object = objectIndices[i];
+            uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroid(object)[axis] - centroidMin[axis]) * scale));
+            bins[bin].boundsMin = glm::min(bins[bin].boundsMin, pobjectStore->getBoundsMin(object));
+            bins[bin].boundsMax = glm::max(bins[bin].boundsMax, pobjectStore->getBoundsMax(object));
+            bins[bin].count++;
+        }
+
+        // leftArea[i] and leftCount[i] describe the bins 0..i, the right side the bins i + 1..BIN_COUNT - 1
+        float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+        uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+        Bin left, right;
+        for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+            left.boundsMin = glm::min(left.boundsMin, bins[i].boundsMin);
+            left.boundsMax = glm::max(left.boundsMax, bins[i].boundsMax);
+            left.count += bins[i].count;
+            leftCount[i] = left.count;
+            leftArea[i] = left.count > 0 ? halfArea(left.boundsMin, left.boundsMax) : 0.0f;
+
+            uint32_t j = BIN_COUNT - 1 - i;
+            right.boundsMin = glm::min(right.boundsMin, bins[j].boundsMin);
+            right.boundsMax = glm::max(right.boundsMax, bins[j].boundsMax);
+            right.count += bins[j].count;
+            rightCount[j - 1] = right.count;
+            rightArea[j - 1] = right.count > 0 ? halfArea(right.boundsMin, right.boundsMax) : 0.0f;
+        }
+
+        for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) {
+                continue;
+            }
+            float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    uint32_t leftCount;
+    if (bestAxis >= 0) {
+        // Splitting pays off when a visit of the node and of the two children is cheaper than testing every object
+        float area = halfArea(node.boundsMin, node.boundsMax);
+        if (area > 0.0f && TRAVERSAL_COST * area + bestCost >= count * area) {
+            makeLeaf();
+            return;
+        }
+
+        float scale = BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        auto middle = std::partition(objectIndices.begin() + first, objectIndices.begin() + first + count, [&](uint32_t object) {
+            uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroid(object)[bestAxis] - centroidMin[bestAxis]) * scale));
+            return bin <= bestSplit;
+        });
+        leftCount = static_cast<uint32_t>(middle - objectIndices.begin()) - first;
+    }
+    else {
+        // All the centers are at the same place, no plane separates them: cut the list in two halves
+        leftCount = count / 2;
+    }
+
+    uint32_t leftChild = nodeCount;
+    nodeCount += 2;
+
+    nodes[leftChild].leftFirst = first;
+    nodes[leftChild].count = leftCount;
+    nodes[leftChild + 1].leftFirst = first + leftCount;
+    nodes[leftChild + 1].count = count - leftCount;
+    parents[leftChild] = nodeIndex;
+    parents[leftChild + 1] = nodeIndex;
+    updateLeafBounds(leftChild);
+    updateLeafBounds(leftChild + 1);
+
+    node.leftFirst = leftChild;
+    node.count = 0;
+
+    subdivide(leftChild, depth + 1);
+    subdivide(leftChild + 1, depth + 1);
+}
+
+void BVH::updateLeafBounds(uint32_t nodeIndex) {
+    BVHNode& node = nodes[nodeIndex];
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++) {
+        node.boundsMin = glm::min(node.boundsMin, pobjectStore->getBoundsMin(objectIndices[i]));
+        node.boundsMax = glm::max(node.boundsMax, pobjectStore->getBoundsMax(objectIndices[i]));
+    }
+}
+
+void BVH::updateInteriorBounds(uint32_t nodeIndex) {
+    BVHNode& node = nodes[nodeIndex];
+    const BVHNode& left = nodes[node.leftFirst];
+    const BVHNode& right = nodes[node.leftFirst + 1];
+    node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+    node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+}
+
+void BVH::refit() {
+    // The children are always stored after their parent: a reverse sweep updates them first
+    for (uint32_t i = nodeCount; i-- > 0;) {
+        if (nodes[i].count > 0) {
+            updateLeafBounds(i);
+        }
+        else {
+            updateInteriorBounds(i);
+        }
+    }
+
+    computeCostSum();
+}
+
+// The cost sum follows the nodes whose bounds change, so that checking the degradation every frame costs nothing
+void BVH::refit(std::span<const uint32_t> movedObjects) {
+    for (uint32_t object : movedObjects) {
+        uint32_t nodeIndex = objectLeaves[object];
+        costSum -= getNodeCost(nodeIndex);
+        updateLeafBounds(nodeIndex);
+        costSum += getNodeCost(nodeIndex);
+
+        // Walk up while the bounds change, the ancestors of a node whose bounds stayed the same are already right
+        for (nodeIndex = parents[nodeIndex]; nodeIndex != NO_HIT; nodeIndex = parents[nodeIndex]) {
+            BVHNode previous = nodes[nodeIndex];
+            updateInteriorBounds(nodeIndex);
+            if (previous.boundsMin == nodes[nodeIndex].boundsMin && previous.boundsMax == nodes[nodeIndex].boundsMax) {
+                break;
+            }
+            costSum += getNodeCost(nodeIndex) - TRAVERSAL_COST * halfArea(previous.boundsMin, previous.boundsMax);
+        }
+    }
+}
+
+bool BVH::isDegraded() const {
+    return getCost() > REBUILD_COST_RATIO * builtCost;
+}
+
+double BVH::getNodeCost(uint32_t nodeIndex) const {
+    const BVHNode& node = nodes[nodeIndex];
+    double area = halfArea(node.boundsMin, node.boundsMax);
+    return node.count > 0 ? node.count * area : TRAVERSAL_COST * area;
+}
+
+// In double: the refits add and subtract the areas of the changed nodes for as long as the tree is not rebuilt
+void BVH::computeCostSum() {
+    costSum = 0.0;
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        costSum += getNodeCost(i);
+    }
+}
+
+uint32_t BVH::cull(const Frustum& frustum, uint32_t* pvisibleIndices) const {
+    if (nodeCount == 0) {
+        return 0;
+    }
+
+    // Each stack entry carries the planes its node still has to be tested against: a node entirely inside a plane
+    // clears its bit for the whole subtree, and a subtree inside all of them is accepted without any more test
+    struct Entry {
+        uint32_t nodeIndex;
+        uint32_t planeMask;
+    };
+    Entry stack[2 * MAX_DEPTH];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, (1u << 6) - 1 };
+
+    uint32_t visibleCount = 0;
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        const BVHNode& node = nodes[entry.nodeIndex];
+
+        glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+        glm::vec3 extents = (node.boundsMax - node.boundsMin) * 0.5f;
+        bool outside = false;
+        for (uint32_t p = 0; p < 6 && !outside; p++) {
+            if ((entry.planeMask & (1u << p)) == 0) {
+                continue;
+            }
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            float boxRadius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+            if (distance <= -boxRadius) {
+                outside = true; // The objects inside can't pass ObjectStore::isVisible either
+            }
+            else if (distance > boxRadius) {
+                entry.planeMask &= ~(1u << p);
+            }
+        }
+        if (outside) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++) {
+                uint32_t object = objectIndices[i];
+                if (entry.planeMask == 0 || pobjectStore->isVisible(frustum, object)) {
+                    pvisibleIndices[visibleCount++] = object;
+                }
+            }
+        }
+        else {
+            stack[stackSize++] = { node.leftFirst + 1, entry.planeMask };
+            stack[stackSize++] = { node.leftFirst, entry.planeMask };
+        }
+    }
+    return visibleCount;
+}
+
+uint32_t BVH::query(glm::vec3 boundsMin, glm::vec3 boundsMax, uint32_t* pindices, uint32_t capacity) const {
+    if (nodeCount == 0) {
+        return 0;
+    }
+
+    uint32_t stack[2 * MAX_DEPTH];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    uint32_t foundCount = 0;
+    while (stackSize > 0 && foundCount < capacity) {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        if (!overlaps(node, boundsMin, boundsMax)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count && foundCount < capacity; i++) {
+                uint32_t object = objectIndices[i];
+                glm::vec3 objectMin = pobjectStore->getBoundsMin(object);
+                glm::vec3 objectMax = pobjectStore->getBoundsMax(object);
+                if (objectMin.x <= boundsMax.x && objectMax.x >= boundsMin.x
+                    && objectMin.y <= boundsMax.y && objectMax.y >= boundsMin.y
+                    && objectMin.z <= boundsMax.z && objectMax.z >= boundsMin.z) {
+                    pindices[foundCount++] = object;
+                }
+            }
+        }
+        else {
+            stack[stackSize++] = node.leftFirst + 1;
+            stack[stackSize++] = node.leftFirst;
+        }
+    }
+    return foundCount;
+}
+
+uint32_t BVH::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, float& hitDistance) const {
+    hitDistance = maxDistance;
+    if (nodeCount == 0) {
+        return NO_HIT;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / direction; // Infinite for the axes the ray is parallel to, the slabs still work
+    uint32_t hitObject = NO_HIT;
+
+    uint32_t stack[2 * MAX_DEPTH];
+    uint32_t stackSize = 0;
+    if (intersectRay(nodes[0].boundsMin, nodes[0].boundsMax, origin, inverseDirection, hitDistance) <= hitDistance) {
+        stack[stackSize++] = 0;
+    }
+
+    while (stackSize > 0) {
+        const BVHNode& node = nodes[stack[--stackSize]];
+
+        if (node.count > 0) {
+            for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++) {
+                uint32_t object = objectIndices[i];
+                float distance = intersectRay(pobjectStore->getBoundsMin(object), pobjectStore->getBoundsMax(object), origin, inverseDirection, hitDistance);
+                if (distance < hitDistance) {
+                    hitDistance = distance;
+                    hitObject = object;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearest child first, the other one is often pruned by the hit found in it
+        uint32_t nearChild = node.leftFirst;
+        uint32_t farChild = node.leftFirst + 1;
+        float nearDistance = intersectRay(nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, origin, inverseDirection, hitDistance);
+        float farDistance = intersectRay(nodes[farChild].boundsMin, nodes[farChild].boundsMax, origin, inverseDirection, hitDistance);
+        if (farDistance < nearDistance) {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance, farDistance);
+        }
+        if (farDistance <= hitDistance) {
+            stack[stackSize++] = farChild;
+        }
+        if (nearDistance <= hitDistance) {
+            stack[stackSize++] = nearChild;
+        }
+    }
+    return hitObject;
+}
+
+uint32_t BVH::getNodeCount() const {
+    return nodeCount;
+}
+
+float BVH::getCost() const {
+    if (nodeCount == 0) {
+        return 0.0f;
+    }
+
+    float rootArea = halfArea(nodes[0].boundsMin, nodes[0].boundsMax);
+    if (rootArea <= 0.0f) {
+        return static_cast<float>(objectCount);
+    }
+    return static_cast<float>(costSum / rootArea);
+}
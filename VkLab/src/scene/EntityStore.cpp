@@ -0,0 +1,238 @@
+#include "scene/EntityStore.h"
+#include "utils/CpuFeatures.h"
+
+#include <immintrin.h>
+#include <stdexcept>
+
+namespace {
+    // result = parent * local, glm matrices are 16 contiguous floats in column-major order.
+    // Column j of the result is the sum of the columns of parent weighted by the components of column j of local
+    AVX2_FUNCTION inline void multiplyTransformAvx2(const glm::mat4& parent, const glm::mat4& local, glm::mat4& result) {
+        const float* pparent = &parent[0][0];
+        const float* plocal = &local[0][0];
+        float* presult = &result[0][0];
+
+        // Two result columns per register: the columns of parent are repeated in both halves
+        __m256 parent0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pparent));
+        __m256 parent1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pparent + 4));
+        __m256 parent2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pparent + 8));
+        __m256 parent3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pparent + 12));
+
+        for (int column = 0; column < 4; column += 2) {
+            __m256 weights = _mm256_loadu_ps(plocal + 4 * column);
+            __m256 sum = _mm256_mul_ps(parent0, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(parent1, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(parent2, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(parent3, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm256_storeu_ps(presult + 4 * column, sum);
+        }
+    }
+
+    inline void multiplyTransformSse(const glm::mat4& parent, const glm::mat4& local, glm::mat4& result) {
+        const float* pparent = &parent[0][0];
+        const float* plocal = &local[0][0];
+        float* presult = &result[0][0];
+
+        __m128 parent0 = _mm_loadu_ps(pparent);
+        __m128 parent1 = _mm_loadu_ps(pparent + 4);
+        __m128 parent2 = _mm_loadu_ps(pparent + 8);
+        __m128 parent3 = _mm_loadu_ps(pparent + 12);
+
+        for (int column = 0; column < 4; column++) {
+            __m128 weights = _mm_loadu_ps(plocal + 4 * column);
+            __m128 sum = _mm_mul_ps(parent0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(parent1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(parent2, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm_add_ps(sum, _mm_mul_ps(parent3, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(presult + 4 * column, sum);
+        }
+    }
+
+    // A run of the update queue in which no entity is the parent of another: the products are independent, so the loop
+    // overlaps them instead of waiting for each store. Storing a matrix per lane (8 entities per register) would need 32
+    // gathers and a transposition of the results for 8 products, more than the broadcasts of the kernels above
+    struct TransformRun {
+        const Entity* pentities;
+        size_t count;
+        const Entity* pparents;
+        const glm::mat4* plocalTransforms;
+        glm::mat4* pworldTransforms;
+    };
+
+    AVX2_FUNCTION void multiplyTransformsAvx2(const TransformRun& run) {
+        for (size_t i = 0; i < run.count; i++) {
+            Entity entity = run.pentities[i];
+            Entity parent = run.pparents[entity];
+            if (parent == NO_ENTITY) {
+                run.pworldTransforms[entity] = run.plocalTransforms[entity];
+            }
+            else {
+                multiplyTransformAvx2(run.pworldTransforms[parent], run.plocalTransforms[entity], run.pworldTransforms[entity]);
+            }
+        }
+    }
+
+    void multiplyTransformsSse(const TransformRun& run) {
+        for (size_t i = 0; i < run.count; i++) {
+            Entity entity = run.pentities[i];
+            Entity parent = run.pparents[entity];
+            if (parent == NO_ENTITY) {
+                run.pworldTransforms[entity] = run.plocalTransforms[entity];
+            }
+            else {
+                multiplyTransformSse(run.pworldTransforms[parent], run.plocalTransforms[entity], run.pworldTransforms[entity]);
+            }
+        }
+    }
+}
+
+void EntityStore::initialize(uint32_t capacity) {
+    localTransforms.reserve(capacity);
+    worldTransforms.reserve(capacity);
+    materialIndices.reserve(capacity);
+    parents.reserve(capacity);
+    firstChildren.reserve(capacity);
+    nextSiblings.reserve(capacity);
+    flags.reserve(capacity);
+    pendingEntities.reserve(capacity);
+    updateQueue.reserve(capacity);
+    changedEntities.reserve(capacity);
+}
+
+Entity EntityStore::create(const glm::mat4& localTransform, uint32_t materialIndex, Entity parent) {
+    Entity entity = static_cast<Entity>(localTransforms.size());
+    if (parent != NO_ENTITY && parent >= entity) {
+        throw std::runtime_error("failed to create entity, its parent doesn't exist!");
+    }
+
+    localTransforms.push_back(localTransform);
+    worldTransforms.push_back(localTransform); // Recomputed by the next update
+    materialIndices.push_back(materialIndex);
+    parents.push_back(parent);
+    firstChildren.push_back(NO_ENTITY);
+    nextSiblings.push_back(NO_ENTITY);
+    flags.push_back(0);
+
+    if (parent != NO_ENTITY) {
+        nextSiblings[entity] = firstChildren[parent];
+        firstChildren[parent] = entity;
+    }
+
+    // A new entity is reported as changed by the next update, like a moved one
+    setLocalTransform(entity, localTransform);
+    return entity;
+}
+
+void EntityStore::setLocalTransform(Entity entity, const glm::mat4& localTransform) {
+    localTransforms[entity] = localTransform;
+    flags[entity] |= DIRTY;
+    markPending(entity);
+}
+
+void EntityStore::setMaterial(Entity entity, uint32_t materialIndex) {
+    materialIndices[entity] = materialIndex;
+    markPending(entity);
+}
+
+void EntityStore::markPending(Entity entity) {
+    if ((flags[entity] & PENDING) == 0) {
+        flags[entity] |= PENDING;
+        pendingEntities.push_back(entity);
+    }
+}
+
+void EntityStore::markChanged(Entity entity) {
+    if ((flags[entity] & CHANGED) == 0) {
+        flags[entity] |= CHANGED;
+        changedEntities.push_back(entity);
+    }
+}
+
+bool EntityStore::hasDirtyAncestor(Entity entity) const {
+    for (Entity ancestor = parents[entity]; ancestor != NO_ENTITY; ancestor = parents[ancestor]) {
+        if (flags[ancestor] & DIRTY) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EntityStore::update() {
+    for (Entity entity : changedEntities) {
+        flags[entity] &= ~CHANGED;
+    }
+    changedEntities.clear();
+
+    // The subtree of a dirty entity that has a dirty ancestor is already part of the subtree of that ancestor
+    updateQueue.clear();
+    for (Entity entity : pendingEntities) {
+        if ((flags[entity] & DIRTY) && !hasDirtyAncestor(entity)) {
+            flags[entity] |= QUEUED;
+            updateQueue.push_back(entity);
+        }
+        markChanged(entity); // Also the entities whose material alone changed
+    }
+
+    // Breadth-first expansion: the queue grows while it is read, every entity comes after its parent
+    for (size_t i = 0; i < updateQueue.size(); i++) {
+        for (Entity child = firstChildren[updateQueue[i]]; child != NO_ENTITY; child = nextSiblings[child]) {
+            if ((flags[child] & QUEUED) == 0) {
+                flags[child] |= QUEUED;
+                updateQueue.push_back(child);
+            }
+        }
+    }
+
+    // The queue is cut in runs of independent products: a run ends before the first entity whose parent is still queued,
+    // which can only be a parent of the same run. The parents of the roots of the subtrees are clean
+    auto multiplyTransforms = hasAvx2() ? &multiplyTransformsAvx2 : &multiplyTransformsSse;
+    size_t runStart = 0;
+    for (size_t i = 0; i <= updateQueue.size(); i++) {
+        if (i < updateQueue.size()) {
+            Entity parent = parents[updateQueue[i]];
+            if (parent == NO_ENTITY || (flags[parent] & QUEUED) == 0) {
+                continue;
+            }
+        }
+
+        multiplyTransforms({ updateQueue.data() + runStart, i - runStart, parents.data(), localTransforms.data(), worldTransforms.data() });
+        for (size_t j = runStart; j < i; j++) {
+            flags[updateQueue[j]] &= ~(DIRTY | QUEUED);
+            markChanged(updateQueue[j]);
+        }
+        runStart = i;
+    }
+
+    for (Entity entity : pendingEntities) {
+        flags[entity] &= ~PENDING;
+    }
+    pendingEntities.clear();
+}
+
+std::span<const Entity> EntityStore::getChangedEntities() const {
+    return changedEntities;
+}
+
+uint32_t EntityStore::size() const {
+    return static_cast<uint32_t>(localTransforms.size());
+}
+
+Entity EntityStore::getParent(Entity entity) const {
+    return parents[entity];
+}
+
+const glm::mat4& EntityStore::getLocalTransform(Entity entity) const {
+    return localTransforms[entity];
+}
+
+const glm::mat4& EntityStore::getWorldTransform(Entity entity) const {
+    return worldTransforms[entity];
+}
+
+uint32_t EntityStore::getMaterialIndex(Entity entity) const {
+    return materialIndices[entity];
+}
+
+std::span<const glm::mat4> EntityStore::getWorldTransforms() const {
+    return worldTransforms;
+}
@@ -0,0 +1,96 @@
+#include "scene/LodSelector.h"
+#include "core/Constant.h"
+
+#include <algorithm>
+#include <cmath>
+
+void LodSelector::initialize(uint32_t capacity, std::span<const MeshLod> lods, float meshRadius) {
+    this->lods.assign(lods.begin(), lods.end());
+    this->meshRadius = meshRadius;
+    objectLods.reserve(capacity);
+    changedObjects.reserve(capacity);
+}
+
+void LodSelector::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool LodSelector::isEnabled() const {
+    return enabled;
+}
+
+void LodSelector::update(const EntityStore& entities, std::span<const uint32_t> visibleObjects, const glm::mat4& view, const glm::mat4& proj, float viewportHeight) {
+    changedObjects.clear();
+    submittedTriangleCount = 0;
+    fullDetailTriangleCount = 0;
+    if (objectLods.size() < entities.size()) {
+        objectLods.resize(entities.size(), 0);
+    }
+
+    // Pixels covered by one world unit at a distance of 1, along the vertical axis
+    float pixelsPerUnitAtOne = std::abs(proj[1][1]) * viewportHeight * 0.5f;
+    uint32_t lastLod = static_cast<uint32_t>(lods.size() - 1);
+
+    for (Entity entity : visibleObjects) {
+        uint32_t lod = objectLods[entity];
+        if (!enabled) {
+            lod = 0;
+        }
+        else {
+            const glm::mat4& model = entities.getWorldTransform(entity);
+            // The largest axis scale, as for the bounding spheres of the culling. It also scales the object space errors
+            float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+            float centerDistance = glm::length(glm::vec3(view * model[3]));
+            float distance = std::max(centerDistance - meshRadius * scale, CAMERA_NEAR_PLANE);
+            float pixelsPerUnit = pixelsPerUnitAtOne * scale / distance;
+
+            float refineThreshold = LOD_ERROR_THRESHOLD_PIXELS * (1.0f + LOD_HYSTERESIS);
+            float coarsenThreshold = LOD_ERROR_THRESHOLD_PIXELS * (1.0f - LOD_HYSTERESIS);
+            while (lod > 0 && getScreenError(lod, pixelsPerUnit) > refineThreshold) {
+                lod--;
+            }
+            while (lod < lastLod && getScreenError(lod + 1, pixelsPerUnit) < coarsenThreshold) {
+                lod++;
+            }
+        }
+
+        if (lod != objectLods[entity]) {
+            objectLods[entity] = static_cast<uint8_t>(lod);
+            changedObjects.push_back(entity);
+        }
+        submittedTriangleCount += lods[lod].indexCount / 3;
+        fullDetailTriangleCount += lods[0].indexCount / 3;
+    }
+
+    if (!changedObjects.empty()) {
+        version++;
+    }
+}
+
+const MeshLod& LodSelector::getObjectLod(Entity entity) const {
+    return entity < objectLods.size() ? lods[objectLods[entity]] : lods[0];
+}
+
+uint32_t LodSelector::getObjectLodLevel(Entity entity) const {
+    return entity < objectLods.size() ? objectLods[entity] : 0;
+}
+
+std::span<const Entity> LodSelector::getChangedObjects() const {
+    return changedObjects;
+}
+
+uint64_t LodSelector::getVersion() const {
+    return version;
+}
+
+uint64_t LodSelector::getSubmittedTriangleCount() const {
+    return submittedTriangleCount;
+}
+
+uint64_t LodSelector::getFullDetailTriangleCount() const {
+    return fullDetailTriangleCount;
+}
+
+float LodSelector::getScreenError(uint32_t lod, float pixelsPerUnit) const {
+    return lods[lod].error * pixelsPerUnit;
+}
@@ -0,0 +1,42 @@
+#include "scene/Mesh.h"
+
+#include <limits>
+
+MeshData MeshData::createQuad() {
+    MeshData mesh;
+    mesh.vertices = {
+        {{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{0.5f, -0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}}
+    };
+    mesh.indices = {
+        0, 1, 2, 2, 3, 0
+    };
+    mesh.computeBounds();
+    return mesh;
+}
+
+void MeshData::computeBounds() {
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (const Vertex& vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.pos);
+        boundsMax = glm::max(boundsMax, vertex.pos);
+    }
+    if (vertices.empty()) {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+    }
+}
+
+std::vector<MeshLod> MeshData::getLods() const {
+    if (lods.empty()) {
+        return { { 0, static_cast<uint32_t>(indices.size()), 0.0f } };
+    }
+    return lods;
+}
+
+VkIndexType MeshData::getIndexType() const {
+    // 0xFFFF stays unused: it is the primitive restart value of 16-bit indices
+    return vertices.size() < UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
@@ -0,0 +1,305 @@
+#include "scene/MeshCache.h"
+#include "core/Constant.h"
+#include "graphics/VertexLayout.h"
+#include "scene/MeshImporter.h"
+#include "scene/MeshletBuilder.h"
+#include "scene/MeshOptimizer.h"
+#include "scene/MeshSimplifier.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+    // Sections of a cache file, in file order
+    enum Section : uint32_t {
+        VERTICES_SECTION,
+        POSITIONS_SECTION,
+        INDICES_SECTION,
+        LODS_SECTION,
+        MESHLETS_SECTION,
+        MESHLET_VERTICES_SECTION,
+        MESHLET_TRIANGLES_SECTION,
+        SECTION_COUNT
+    };
+
+    struct SectionRange {
+        uint64_t offset; // From the start of the file, a multiple of SECTION_ALIGNMENT
+        uint64_t size;
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t vertexStride; // Of the layouts the file was written with
+        uint32_t positionStride;
+        uint32_t indexSize; // 2 or 4 bytes
+        uint32_t padding;
+        glm::vec4 boundsMin; // w unused
+        glm::vec4 boundsMax;
+        SectionRange sections[SECTION_COUNT];
+    };
+    static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<MeshLod> && std::is_trivially_copyable_v<Meshlet>, "the cache sections are copied as they are");
+
+    // The mapping starts on a page, the arrays of the sections are read in place
+    constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+    // FNV-1a, a word at a time
+    uint64_t hashBytes(uint64_t hash, std::span<const char> bytes) {
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, bytes.data() + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+        for (; i < bytes.size(); i++) {
+            hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // Every setting is a 32-bit word, the struct has no padding to hash
+    struct ProcessingSettings {
+        uint32_t optimizeMeshes;
+        uint32_t generateLods;
+        uint32_t vertexCacheSize; // MeshOptimizer
+        float overdrawThreshold;
+        uint32_t maxLodCount; // MeshSimplifier
+        float lodReduction;
+        uint32_t minLodTriangles;
+        float minNormalCosine;
+        uint32_t maxMeshletVertices; // MeshletBuilder
+        uint32_t maxMeshletTriangles;
+        uint32_t minMeshletMeshTriangles;
+        float minConeCosine;
+    };
+
+    template <typename T>
+    std::span<const char> asBytes(const std::vector<T>& values) {
+        return { reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T) };
+    }
+
+    template <typename T>
+    std::span<const T> asArray(std::span<const char> data, const SectionRange& section) {
+        return { reinterpret_cast<const T*>(data.data() + section.offset), static_cast<size_t>(section.size / sizeof(T)) };
+    }
+}
+
+std::string MeshCache::getCachePath(const std::string& sourceFilename) {
+    std::filesystem::path sourcePath(sourceFilename);
+    std::string fullPath = std::filesystem::absolute(sourcePath).lexically_normal().string();
+    uint64_t pathHash = hashBytes(0xcbf29ce484222325ull, { fullPath.data(), fullPath.size() });
+
+    std::ostringstream name;
+    name << sourcePath.filename().string() << "." << std::hex << std::setw(16) << std::setfill('0') << pathHash << ".vkmesh";
+    return (std::filesystem::path(MESH_CACHE_DIRECTORY) / name.str()).string();
+}
+
+bool MeshCache::computeSourceHash(const std::string& sourceFilename, uint64_t& hash) {
+    MappedFile source;
+    if (!source.open(sourceFilename)) {
+        return false;
+    }
+    hash = hashBytes(0xcbf29ce484222325ull, source.getData());
+
+    // The external buffers of a glTF file, a malformed file is left to the import which reports it
+    std::vector<std::string> externalFiles;
+    try {
+        externalFiles = MeshImporter::getExternalFiles(sourceFilename, source.getData());
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    for (const std::string& externalFilename : externalFiles) {
+        MappedFile externalFile;
+        if (!externalFile.open(externalFilename)) {
+            return false;
+        }
+        hash = hashBytes(hash, externalFile.getData());
+    }
+
+    // The settings of the processing and the vertex layouts, a change rebuilds the cache
+    ProcessingSettings settings = {
+        OPTIMIZE_MESHES, GENERATE_LODS,
+        MeshOptimizer::VERTEX_CACHE_SIZE, MeshOptimizer::OVERDRAW_THRESHOLD,
+        MeshSimplifier::MAX_LOD_COUNT, MeshSimplifier::LOD_REDUCTION, MeshSimplifier::MIN_LOD_TRIANGLES, MeshSimplifier::MIN_NORMAL_COSINE,
+        MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES, MeshletBuilder::MIN_MESH_TRIANGLES, MeshletBuilder::MIN_CONE_COSINE
+    };
+    static_assert(sizeof(ProcessingSettings) == 12 * sizeof(uint32_t), "the settings are hashed as they are");
+    hash = hashBytes(hash, { reinterpret_cast<const char*>(&settings), sizeof(settings) });
+    auto meshAttributes = MeshVertexLayout::getAttributeDescriptions();
+    auto positionAttributes = PositionVertexLayout::getAttributeDescriptions();
+    hash = hashBytes(hash, { reinterpret_cast<const char*>(meshAttributes.data()), sizeof(meshAttributes) });
+    hash = hashBytes(hash, { reinterpret_cast<const char*>(positionAttributes.data()), sizeof(positionAttributes) });
+    return true;
+}
+
+std::vector<char> MeshCache::serialize(const MeshData& mesh, uint64_t sourceHash) {
+    VertexQuantization quantization = VertexQuantization::fromBounds(mesh.boundsMin, mesh.boundsMax);
+    auto vertices = MeshVertexLayout::encode(mesh.vertices, quantization);
+    auto positions = PositionVertexLayout::encode(mesh.vertices, quantization);
+    std::vector<MeshLod> lods = mesh.getLods();
+
+    VkIndexType indexType = mesh.getIndexType();
+    std::vector<uint16_t> shortIndices;
+    if (indexType == VK_INDEX_TYPE_UINT16) {
+        shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+    }
+
+    std::span<const char> sections[SECTION_COUNT] = {
+        asBytes(vertices),
+        asBytes(positions),
+        indexType == VK_INDEX_TYPE_UINT16 ? asBytes(shortIndices) : asBytes(mesh.indices),
+        asBytes(lods),
+        asBytes(mesh.meshlets),
+        asBytes(mesh.meshletVertices),
+        asBytes(mesh.meshletTriangles)
+    };
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.vertexStride = MeshVertexLayout::STRIDE;
+    header.positionStride = PositionVertexLayout::STRIDE;
+    header.indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.boundsMin = glm::vec4(mesh.boundsMin, 0.0f);
+    header.boundsMax = glm::vec4(mesh.boundsMax, 0.0f);
+
+    uint64_t offset = sizeof(Header);
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+        offset = (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+        header.sections[i] = { offset, sections[i].size() };
+        offset += sections[i].size();
+    }
+
+    std::vector<char> data(offset, 0);
+    memcpy(data.data(), &header, sizeof(header));
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+        if (!sections[i].empty()) {
+            memcpy(data.data() + header.sections[i].offset, sections[i].data(), sections[i].size());
+        }
+    }
+    return data;
+}
+
+// Written to a temporary file first: an interrupted write never leaves a truncated cache file behind
+bool MeshCache::write(const std::string& filename, std::span<const char> data) {
+    std::error_code error;
+    std::filesystem::path path(filename);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::string temporaryFilename = filename + ".tmp";
+    {
+        std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryFilename, filename, error);
+    if (error) {
+        std::filesystem::remove(temporaryFilename, error);
+        return false;
+    }
+    return true;
+}
+
+// Only the header and the ranges are checked, the content of the sections is trusted
+bool MeshCache::parse(std::span<const char> data, uint64_t sourceHash, MeshGeometry& geometry) {
+    Header header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash) {
+        return false;
+    }
+    if (header.vertexStride != MeshVertexLayout::STRIDE || header.positionStride != PositionVertexLayout::STRIDE) {
+        return false;
+    }
+    if (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) {
+        return false;
+    }
+
+    uint32_t elementSizes[SECTION_COUNT] = { header.vertexStride, header.positionStride, header.indexSize, sizeof(MeshLod), sizeof(Meshlet), sizeof(uint32_t), sizeof(uint32_t) };
+    for (uint32_t i = 0; i < SECTION_COUNT; i++) {
+        const SectionRange& section = header.sections[i];
+        if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > data.size() || section.size > data.size() - section.offset || section.size % elementSizes[i] != 0) {
+            return false;
+        }
+    }
+
+    const SectionRange* sections = header.sections;
+    uint64_t vertexCount = sections[VERTICES_SECTION].size / header.vertexStride;
+    uint64_t indexCount = sections[INDICES_SECTION].size / header.indexSize;
+    if (vertexCount == 0 || sections[POSITIONS_SECTION].size / header.positionStride != vertexCount) {
+        return false;
+    }
+
+    geometry.vertices = data.subspan(sections[VERTICES_SECTION].offset, sections[VERTICES_SECTION].size);
+    geometry.positions = data.subspan(sections[POSITIONS_SECTION].offset, sections[POSITIONS_SECTION].size);
+    geometry.indices = data.subspan(sections[INDICES_SECTION].offset, sections[INDICES_SECTION].size);
+    geometry.indexType = header.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    geometry.boundsMin = glm::vec3(header.boundsMin);
+    geometry.boundsMax = glm::vec3(header.boundsMax);
+    geometry.lods = asArray<MeshLod>(data, sections[LODS_SECTION]);
+    geometry.meshlets = asArray<Meshlet>(data, sections[MESHLETS_SECTION]);
+    geometry.meshletVertices = asArray<uint32_t>(data, sections[MESHLET_VERTICES_SECTION]);
+    geometry.meshletTriangles = asArray<uint32_t>(data, sections[MESHLET_TRIANGLES_SECTION]);
+
+    // The draws and the mesh shaders index with these ranges, they must stay within the buffers
+    if (geometry.lods.empty()) {
+        return false;
+    }
+    for (const MeshLod& lod : geometry.lods) {
+        if (uint64_t(lod.firstIndex) + lod.indexCount > indexCount) {
+            return false;
+        }
+    }
+    for (const Meshlet& meshlet : geometry.meshlets) {
+        if (uint64_t(meshlet.firstIndex) + uint64_t(meshlet.triangleCount) * 3 > indexCount
+            || uint64_t(meshlet.firstIndex) / 3 + meshlet.triangleCount > geometry.meshletTriangles.size()
+            || uint64_t(meshlet.firstVertex) + meshlet.vertexCount > geometry.meshletVertices.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CachedMesh::map(const std::string& filename, uint64_t sourceHash) {
+    release();
+    if (!file.open(filename)) {
+        return false;
+    }
+    if (!MeshCache::parse(file.getData(), sourceHash, geometry)) {
+        release();
+        return false;
+    }
+    return true;
+}
+
+void CachedMesh::assign(std::vector<char> data, uint64_t sourceHash) {
+    release();
+    this->data = std::move(data);
+    if (!MeshCache::parse(this->data, sourceHash, geometry)) {
+        throw std::runtime_error("failed to serialize mesh!");
+    }
+}
+
+void CachedMesh::release() {
+    file.close();
+    data.clear();
+    data.shrink_to_fit();
+    geometry = MeshGeometry{};
+}
+
+const MeshGeometry& CachedMesh::getGeometry() const {
+    return geometry;
+}
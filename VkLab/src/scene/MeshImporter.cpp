@@ -0,0 +1,833 @@
+#include "scene/MeshImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t OBJ_CHUNK_SIZE = 1 << 20; // Bytes of OBJ text per parsing job
+    constexpr uint32_t GLTF_TRIANGLES_PER_JOB = 1 << 16;
+    constexpr uint32_t DEDUPLICATION_BATCH_SIZE = 1 << 14; // Vertices per hashing job
+
+    // Runs the job on the pool when there is one, inline otherwise
+    void runParallel(ThreadPool* pthreadPool, uint32_t count, uint32_t minBatchSize, ThreadPool::Job job, void* pcontext) {
+        if (pthreadPool != nullptr) {
+            pthreadPool->parallelFor(count, minBatchSize, job, pcontext);
+        }
+        else if (count > 0) {
+            job(pcontext, 0, count);
+        }
+    }
+
+    std::vector<char> readBinaryFile(const std::string& filename) {
+        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open model file " + filename + "!");
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        std::vector<char> buffer(fileSize);
+        file.seekg(0);
+        file.read(buffer.data(), fileSize);
+        return buffer;
+    }
+
+    std::string getExtension(const std::string& filename) {
+        size_t dot = filename.find_last_of('.');
+        std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return extension;
+    }
+
+    // The normal of a triangle, used for the vertices of the files without normals
+    glm::vec3 faceNormal(const Vertex& a, const Vertex& b, const Vertex& c) {
+        glm::vec3 normal = glm::cross(b.pos - a.pos, c.pos - a.pos);
+        float length = glm::length(normal);
+        return length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    // ---- OBJ ----
+
+    constexpr int32_t OBJ_MISSING = INT32_MIN;
+
+    // One corner of a face, with 0-based indices. The negative (relative) indices of the file are stored relative to the
+    // start of the chunk, since the chunks don't know how many elements the previous ones declared
+    struct ObjCorner {
+        int32_t position;
+        int32_t texCoord;
+        int32_t normal;
+        uint8_t relativeMask; // Bit 0: position, 1: texture coordinate, 2: normal
+    };
+
+    struct ObjChunk {
+        const char* begin;
+        const char* end;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> colors; // Same size as positions, the OBJ extension "v x y z r g b [a]"
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+        std::vector<ObjCorner> corners; // Three per triangle, the polygons are split in fans
+        bool parseError = false;
+
+        // Elements declared by the previous chunks, known once they are all parsed
+        int32_t positionBase = 0;
+        int32_t texCoordBase = 0;
+        int32_t normalBase = 0;
+        size_t firstVertex = 0; // Offset of the triangles of the chunk in the output
+    };
+
+    struct ObjParseJob {
+        std::vector<ObjChunk>* pchunks;
+    };
+
+    struct ObjAssembleJob {
+        std::vector<ObjChunk>* pchunks;
+        const std::vector<glm::vec3>* ppositions;
+        const std::vector<glm::vec3>* pcolors;
+        const std::vector<glm::vec2>* ptexCoords;
+        const std::vector<glm::vec3>* pnormals;
+        Vertex* pvertices;
+        std::atomic<bool>* pindexError;
+    };
+
+    const char* skipBlanks(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        return p;
+    }
+
+    // Reads up to count floats of the line, returns how many were read
+    int parseFloats(const char*& p, const char* end, float* pvalues, int count) {
+        int read = 0;
+        while (read < count) {
+            p = skipBlanks(p, end);
+            auto result = std::from_chars(p, end, pvalues[read]);
+            if (result.ec != std::errc()) {
+                break;
+            }
+            p = result.ptr;
+            read++;
+        }
+        return read;
+    }
+
+    // "v", "v/vt", "v//vn" or "v/vt/vn"
+    bool parseCorner(const char*& p, const char* end, const ObjChunk& chunk, ObjCorner& corner) {
+        int32_t values[3] = { 0, 0, 0 };
+        for (int i = 0; i < 3; i++) {
+            if (i > 0) {
+                if (p >= end || *p != '/') {
+                    break;
+                }
+                p++;
+            }
+            auto result = std::from_chars(p, end, values[i]);
+            if (result.ec == std::errc()) {
+                p = result.ptr;
+            }
+            else if (i == 0) {
+                return false;
+            }
+        }
+
+        int32_t localCounts[3] = { static_cast<int32_t>(chunk.positions.size()), static_cast<int32_t>(chunk.texCoords.size()), static_cast<int32_t>(chunk.normals.size()) };
+        int32_t* pindices[3] = { &corner.position, &corner.texCoord, &corner.normal };
+        corner.relativeMask = 0;
+        for (int i = 0; i < 3; i++) {
+            if (values[i] > 0) {
+                *pindices[i] = values[i] - 1;
+            }
+            else if (values[i] < 0) {
+                *pindices[i] = localCounts[i] + values[i];
+                corner.relativeMask |= 1 << i;
+            }
+            else {
+                *pindices[i] = OBJ_MISSING;
+            }
+        }
+        return true;
+    }
+
+    void parseObjChunks(void* pcontext, uint32_t beginChunk, uint32_t endChunk) {
+        auto pjob = static_cast<ObjParseJob*>(pcontext);
+
+        for (uint32_t c = beginChunk; c < endChunk; c++) {
+            ObjChunk& chunk = (*pjob->pchunks)[c];
+            const char* p = chunk.begin;
+
+            while (p < chunk.end) {
+                const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+                if (lineEnd == nullptr) {
+                    lineEnd = chunk.end;
+                }
+                p = skipBlanks(p, lineEnd);
+
+                if (lineEnd - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+                    p += 2;
+                    // "v x y z w" is a rational position (w is ignored), only 6 or 7 values carry a color
+                    float values[7] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+                    int read = parseFloats(p, lineEnd, values, 7);
+                    chunk.parseError |= read < 3;
+                    chunk.positions.emplace_back(values[0], values[1], values[2]);
+                    chunk.colors.push_back(read >= 6 ? glm::vec3(values[3], values[4], values[5]) : glm::vec3(1.0f));
+                }
+                else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')) {
+                    p += 3;
+                    float values[2] = { 0.0f, 0.0f };
+                    parseFloats(p, lineEnd, values, 2);
+                    // OBJ puts the origin of the texture at the bottom left, Vulkan samples from the top left
+                    chunk.texCoords.emplace_back(values[0], 1.0f - values[1]);
+                }
+                else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')) {
+                    p += 3;
+                    float values[3] = { 0.0f, 0.0f, 1.0f };
+                    chunk.parseError |= parseFloats(p, lineEnd, values, 3) < 3;
+                    chunk.normals.emplace_back(values[0], values[1], values[2]);
+                }
+                else if (lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+                    p += 2;
+                    ObjCorner first{}, previous{}, corner{};
+                    int cornerCount = 0;
+                    while (true) {
+                        p = skipBlanks(p, lineEnd);
+                        if (p >= lineEnd || *p == '\r' || !parseCorner(p, lineEnd, chunk, corner)) {
+                            break;
+                        }
+                        if (cornerCount == 0) {
+                            first = corner;
+                        }
+                        else if (cornerCount >= 2) {
+                            chunk.corners.push_back(first);
+                            chunk.corners.push_back(previous);
+                            chunk.corners.push_back(corner);
+                        }
+                        previous = corner;
+                        cornerCount++;
+                    }
+                    chunk.parseError |= cornerCount < 3;
+                }
+                // Comments, groups, smoothing groups and materials are ignored
+
+                p = lineEnd + 1;
+            }
+        }
+    }
+
+    void assembleObjChunks(void* pcontext, uint32_t beginChunk, uint32_t endChunk) {
+        auto pjob = static_cast<ObjAssembleJob*>(pcontext);
+        const auto& positions = *pjob->ppositions;
+        const auto& colors = *pjob->pcolors;
+        const auto& texCoords = *pjob->ptexCoords;
+        const auto& normals = *pjob->pnormals;
+
+        for (uint32_t c = beginChunk; c < endChunk; c++) {
+            const ObjChunk& chunk = (*pjob->pchunks)[c];
+            Vertex* pvertex = pjob->pvertices + chunk.firstVertex;
+
+            for (size_t t = 0; t < chunk.corners.size(); t += 3) {
+                bool hasNormals = true;
+                for (size_t k = 0; k < 3; k++) {
+                    const ObjCorner& corner = chunk.corners[t + k];
+                    int32_t position = corner.position + ((corner.relativeMask & 1) ? chunk.positionBase : 0);
+                    int32_t texCoord = corner.texCoord + ((corner.relativeMask & 2) ? chunk.texCoordBase : 0);
+                    int32_t normal = corner.normal + ((corner.relativeMask & 4) ? chunk.normalBase : 0);
+
+                    Vertex& vertex = pvertex[t + k];
+                    if (position < 0 || position >= static_cast<int32_t>(positions.size())) {
+                        pjob->pindexError->store(true, std::memory_order_relaxed);
+                        position = 0;
+                    }
+                    vertex.pos = positions[position];
+                    vertex.color = colors[position];
+
+                    bool validTexCoord = corner.texCoord != OBJ_MISSING && texCoord >= 0 && texCoord < static_cast<int32_t>(texCoords.size());
+                    vertex.texCoord = validTexCoord ? texCoords[texCoord] : glm::vec2(0.0f);
+
+                    bool validNormal = corner.normal != OBJ_MISSING && normal >= 0 && normal < static_cast<int32_t>(normals.size());
+                    vertex.normal = validNormal ? normals[normal] : glm::vec3(0.0f);
+                    hasNormals &= validNormal;
+                }
+
+                if (!hasNormals) {
+                    glm::vec3 normal = faceNormal(pvertex[t], pvertex[t + 1], pvertex[t + 2]);
+                    pvertex[t].normal = pvertex[t + 1].normal = pvertex[t + 2].normal = normal;
+                }
+            }
+        }
+    }
+
+    // ---- glTF ----
+
+    // Component types of the accessors
+    constexpr uint32_t GLTF_BYTE = 5120;
+    constexpr uint32_t GLTF_UNSIGNED_BYTE = 5121;
+    constexpr uint32_t GLTF_SHORT = 5122;
+    constexpr uint32_t GLTF_UNSIGNED_SHORT = 5123;
+    constexpr uint32_t GLTF_UNSIGNED_INT = 5125;
+    constexpr uint32_t GLTF_FLOAT = 5126;
+    constexpr uint32_t GLTF_TRIANGLES = 4;
+
+    uint32_t componentSize(uint32_t componentType) {
+        switch (componentType) {
+        case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+        default: throw std::runtime_error("failed to import glTF, unknown accessor component type!");
+        }
+    }
+
+    uint32_t componentCount(const std::string& type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        throw std::runtime_error("failed to import glTF, unsupported accessor type " + type + "!");
+    }
+
+    // Validated view of an accessor, so that the decoding jobs can't read out of bounds and never throw
+    struct GltfAccessor {
+        const unsigned char* pdata = nullptr;
+        uint32_t count = 0;
+        uint32_t stride = 0;
+        uint32_t componentType = 0;
+        uint32_t components = 0;
+        bool normalized = false;
+
+        bool isValid() const {
+            return pdata != nullptr;
+        }
+
+        float readComponent(uint32_t index, uint32_t component) const {
+            const unsigned char* p = pdata + size_t(index) * stride + component * componentSize(componentType);
+            switch (componentType) {
+            case GLTF_FLOAT: { float value; memcpy(&value, p, 4); return value; }
+            case GLTF_UNSIGNED_BYTE: return normalized ? *p / 255.0f : *p;
+            case GLTF_BYTE: { int8_t value; memcpy(&value, p, 1); return normalized ? std::max(value / 127.0f, -1.0f) : value; }
+            case GLTF_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, p, 2); return normalized ? value / 65535.0f : value; }
+            case GLTF_SHORT: { int16_t value; memcpy(&value, p, 2); return normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+            default: { uint32_t value; memcpy(&value, p, 4); return static_cast<float>(value); }
+            }
+        }
+
+        glm::vec4 read(uint32_t index, glm::vec4 value) const {
+            for (uint32_t c = 0; c < components && c < 4; c++) {
+                value[c] = readComponent(index, c);
+            }
+            return value;
+        }
+
+        uint32_t readIndex(uint32_t index) const {
+            const unsigned char* p = pdata + size_t(index) * stride;
+            switch (componentType) {
+            case GLTF_UNSIGNED_BYTE: return *p;
+            case GLTF_UNSIGNED_SHORT: { uint16_t value; memcpy(&value, p, 2); return value; }
+            default: { uint32_t value; memcpy(&value, p, 4); return value; }
+            }
+        }
+    };
+
+    GltfAccessor getAccessor(const JsonValue& document, const std::vector<std::vector<char>>& buffers, const JsonValue& accessorIndex) {
+        GltfAccessor accessor;
+        if (accessorIndex.isNull()) {
+            return accessor;
+        }
+
+        const JsonValue& json = document["accessors"][accessorIndex.getUint()];
+        if (json.isNull() || json.contains("sparse") || !json.contains("bufferView")) {
+            throw std::runtime_error("failed to import glTF, sparse or empty accessors are not supported!");
+        }
+        const JsonValue& view = document["bufferViews"][json["bufferView"].getUint()];
+        uint32_t bufferIndex = view["buffer"].getUint(UINT32_MAX);
+        if (view.isNull() || bufferIndex >= buffers.size()) {
+            throw std::runtime_error("failed to import glTF, invalid buffer view!");
+        }
+
+        accessor.count = json["count"].getUint();
+        accessor.componentType = json["componentType"].getUint();
+        accessor.components = componentCount(json["type"].getString());
+        accessor.normalized = json["normalized"].getBool();
+        uint32_t elementSize = componentSize(accessor.componentType) * accessor.components;
+        accessor.stride = view["byteStride"].getUint(elementSize);
+
+        size_t offset = size_t(view["byteOffset"].getUint()) + json["byteOffset"].getUint();
+        size_t viewEnd = size_t(view["byteOffset"].getUint()) + view["byteLength"].getUint();
+        size_t lastByte = offset + (accessor.count > 0 ? size_t(accessor.count - 1) * accessor.stride + elementSize : 0);
+        if (lastByte > viewEnd || viewEnd > buffers[bufferIndex].size()) {
+            throw std::runtime_error("failed to import glTF, accessor out of the bounds of its buffer!");
+        }
+
+        accessor.pdata = reinterpret_cast<const unsigned char*>(buffers[bufferIndex].data()) + offset;
+        return accessor;
+    }
+
+    // Primitive drawn by a node: its accessors and the transform of the node
+    struct GltfDraw {
+        GltfAccessor positions;
+        GltfAccessor normals;
+        GltfAccessor texCoords;
+        GltfAccessor colors;
+        GltfAccessor indices;
+        glm::mat4 transform;
+        glm::mat3 normalTransform;
+        bool flipWinding; // The transform mirrors the mesh
+        size_t firstVertex; // Offset of the triangles of the draw in the output
+    };
+
+    // Range of triangles of a draw decoded by one job
+    struct GltfWorkItem {
+        uint32_t drawIndex;
+        uint32_t firstTriangle;
+        uint32_t triangleCount;
+    };
+
+    struct GltfDecodeJob {
+        const std::vector<GltfDraw>* pdraws;
+        const std::vector<GltfWorkItem>* pitems;
+        Vertex* pvertices;
+        std::atomic<bool>* pindexError;
+    };
+
+    void decodeGltfItems(void* pcontext, uint32_t beginItem, uint32_t endItem) {
+        auto pjob = static_cast<GltfDecodeJob*>(pcontext);
+
+        for (uint32_t i = beginItem; i < endItem; i++) {
+            const GltfWorkItem& item = (*pjob->pitems)[i];
+            const GltfDraw& draw = (*pjob->pdraws)[item.drawIndex];
+            Vertex* pvertex = pjob->pvertices + draw.firstVertex + size_t(item.firstTriangle) * 3;
+
+            for (uint32_t t = 0; t < item.triangleCount; t++) {
+                for (uint32_t k = 0; k < 3; k++) {
+                    uint32_t corner = (item.firstTriangle + t) * 3 + (draw.flipWinding ? (3 - k) % 3 : k);
+                    uint32_t index = draw.indices.isValid() ? draw.indices.readIndex(corner) : corner;
+                    if (index >= draw.positions.count) {
+                        pjob->pindexError->store(true, std::memory_order_relaxed);
+                        index = 0;
+                    }
+
+                    Vertex& vertex = pvertex[t * 3 + k];
+                    vertex.pos = glm::vec3(draw.transform * glm::vec4(glm::vec3(draw.positions.read(index, glm::vec4(0.0f))), 1.0f));
+                    vertex.normal = draw.normals.isValid() ? glm::vec3(draw.normals.read(index, glm::vec4(0.0f))) : glm::vec3(0.0f);
+                    vertex.texCoord = draw.texCoords.isValid() ? glm::vec2(draw.texCoords.read(index, glm::vec4(0.0f))) : glm::vec2(0.0f);
+                    vertex.color = draw.colors.isValid() ? glm::vec3(draw.colors.read(index, glm::vec4(1.0f))) : glm::vec3(1.0f);
+
+                    if (draw.normals.isValid()) {
+                        glm::vec3 normal = draw.normalTransform * vertex.normal;
+                        float length = glm::length(normal);
+                        vertex.normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                    }
+                }
+
+                if (!draw.normals.isValid()) {
+                    glm::vec3 normal = faceNormal(pvertex[t * 3], pvertex[t * 3 + 1], pvertex[t * 3 + 2]);
+                    pvertex[t * 3].normal = pvertex[t * 3 + 1].normal = pvertex[t * 3 + 2].normal = normal;
+                }
+            }
+        }
+    }
+
+    // Local transform of a node: a matrix, or translation, rotation (quaternion) and scale
+    glm::mat4 getNodeTransform(const JsonValue& node) {
+        glm::mat4 transform(1.0f);
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.size() == 16) {
+            for (int i = 0; i < 16; i++) {
+                transform[i / 4][i % 4] = static_cast<float>(matrix[i].getNumber()); // Column-major like glm
+            }
+            return transform;
+        }
+
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        float x = static_cast<float>(r[0].getNumber(0.0)), y = static_cast<float>(r[1].getNumber(0.0));
+        float z = static_cast<float>(r[2].getNumber(0.0)), w = static_cast<float>(r[3].getNumber(1.0));
+
+        // Rotation matrix of the unit quaternion, each column scaled, then the translation
+        transform[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * static_cast<float>(s[0].getNumber(1.0));
+        transform[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * static_cast<float>(s[1].getNumber(1.0));
+        transform[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * static_cast<float>(s[2].getNumber(1.0));
+        transform[3] = glm::vec4(static_cast<float>(t[0].getNumber()), static_cast<float>(t[1].getNumber()), static_cast<float>(t[2].getNumber()), 1.0f);
+        return transform;
+    }
+
+    struct GltfTraversal {
+        const JsonValue& document;
+        const std::vector<std::vector<char>>& buffers;
+        std::vector<GltfDraw>& draws;
+
+        void addMesh(uint32_t meshIndex, const glm::mat4& transform) {
+            const JsonValue& primitives = document["meshes"][meshIndex]["primitives"];
+
+            // Normals go through the cofactor matrix (the inverse transpose up to a scale), which keeps them
+            // perpendicular to the surface under non-uniform scaling
+            glm::vec3 a(transform[0]), b(transform[1]), c(transform[2]);
+            glm::mat3 normalTransform;
+            normalTransform[0] = glm::cross(b, c);
+            normalTransform[1] = glm::cross(c, a);
+            normalTransform[2] = glm::cross(a, b);
+            bool mirrored = glm::dot(a, glm::cross(b, c)) < 0.0f;
+
+            for (size_t p = 0; p < primitives.size(); p++) {
+                const JsonValue& primitive = primitives[p];
+                if (primitive["mode"].getUint(GLTF_TRIANGLES) != GLTF_TRIANGLES) {
+                    continue; // Points, lines and strips are not drawn
+                }
+
+                const JsonValue& attributes = primitive["attributes"];
+                GltfDraw draw{};
+                draw.positions = getAccessor(document, buffers, attributes["POSITION"]);
+                if (!draw.positions.isValid()) {
+                    continue;
+                }
+                draw.normals = getAccessor(document, buffers, attributes["NORMAL"]);
+                draw.texCoords = getAccessor(document, buffers, attributes["TEXCOORD_0"]);
+                draw.colors = getAccessor(document, buffers, attributes["COLOR_0"]);
+                draw.indices = getAccessor(document, buffers, primitive["indices"]);
+                draw.transform = transform;
+                draw.normalTransform = normalTransform;
+                draw.flipWinding = mirrored;
+                draws.push_back(draw);
+            }
+        }
+
+        void visitNode(uint32_t nodeIndex, const glm::mat4& parentTransform, int depth) {
+            const JsonValue& node = document["nodes"][nodeIndex];
+            if (node.isNull() || depth > 64) {
+                throw std::runtime_error("failed to import glTF, invalid node hierarchy!");
+            }
+
+            glm::mat4 transform = parentTransform * getNodeTransform(node);
+            if (node.contains("mesh")) {
+                addMesh(node["mesh"].getUint(), transform);
+            }
+            const JsonValue& children = node["children"];
+            for (size_t i = 0; i < children.size(); i++) {
+                visitNode(children[i].getUint(), transform, depth + 1);
+            }
+        }
+    };
+
+    std::vector<char> decodeBase64(const std::string& text, size_t begin) {
+        auto decodeChar = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+
+        std::vector<char> data;
+        data.reserve((text.size() - begin) * 3 / 4);
+        uint32_t bits = 0;
+        int bitCount = 0;
+        for (size_t i = begin; i < text.size(); i++) {
+            int value = decodeChar(text[i]);
+            if (value < 0) {
+                break; // Padding
+            }
+            bits = (bits << 6) | static_cast<uint32_t>(value);
+            bitCount += 6;
+            if (bitCount >= 8) {
+                bitCount -= 8;
+                data.push_back(static_cast<char>((bits >> bitCount) & 0xFF));
+            }
+        }
+        return data;
+    }
+
+    // Percent-encoded octets of a relative URI reference ("my%20mesh.bin"), the other characters are kept
+    std::string decodeUri(const std::string& uri) {
+        auto decodeHex = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+
+        std::string path;
+        path.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); i++) {
+            if (uri[i] == '%' && i + 2 < uri.size() && decodeHex(uri[i + 1]) >= 0 && decodeHex(uri[i + 2]) >= 0) {
+                path += static_cast<char>(decodeHex(uri[i + 1]) * 16 + decodeHex(uri[i + 2]));
+                i += 2;
+            }
+            else {
+                path += uri[i];
+            }
+        }
+        return path;
+    }
+
+    // ---- Deduplication ----
+
+    struct HashJob {
+        const Vertex* pvertices;
+        uint32_t* phashes;
+    };
+
+    uint32_t hashVertex(const Vertex& vertex) {
+        // The float bits are mixed as integers: vertices are merged only when they are bitwise equal
+        uint32_t words[sizeof(Vertex) / 4];
+        memcpy(words, &vertex, sizeof(Vertex));
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (uint32_t word : words) {
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+
+    void hashVertices(void* pcontext, uint32_t begin, uint32_t end) {
+        auto pjob = static_cast<HashJob*>(pcontext);
+        for (uint32_t i = begin; i < end; i++) {
+            pjob->phashes[i] = hashVertex(pjob->pvertices[i]);
+        }
+    }
+}
+
+MeshData MeshImporter::load(const std::string& filename, ThreadPool* pthreadPool) {
+    std::string extension = getExtension(filename);
+    std::vector<Vertex> triangleVertices;
+
+    if (extension == "obj") {
+        std::vector<char> file = readBinaryFile(filename);
+        triangleVertices = parseObj(file, pthreadPool); // Parsed in place, the chunks never read past their end
+    }
+    else if (extension == "gltf" || extension == "glb") {
+        std::vector<char> file = readBinaryFile(filename);
+        std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+        std::vector<char> glbBuffer;
+        JsonValue document = parseGltfFile(filename, file, &glbBuffer);
+
+        std::vector<std::vector<char>> buffers = loadGltfBuffers(document, directory, &glbBuffer);
+        triangleVertices = parseGltf(document, buffers, pthreadPool);
+    }
+    else {
+        throw std::runtime_error("failed to import " + filename + ", unsupported model format!");
+    }
+
+    if (triangleVertices.empty()) {
+        throw std::runtime_error("failed to import " + filename + ", it has no triangles!");
+    }
+    return deduplicate(triangleVertices, pthreadPool);
+}
+
+std::vector<std::string> MeshImporter::getExternalFiles(const std::string& filename, std::span<const char> file) {
+    std::string extension = getExtension(filename);
+    if (extension != "gltf" && extension != "glb") {
+        return {};
+    }
+
+    JsonValue document = parseGltfFile(filename, file, nullptr);
+    std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+    // The same paths as loadGltfBuffers: the BIN chunk and the data URIs are part of the file itself
+    std::vector<std::string> files;
+    const JsonValue& buffersJson = document["buffers"];
+    for (size_t i = 0; i < buffersJson.size(); i++) {
+        const std::string& uri = buffersJson[i]["uri"].getString();
+        if (!uri.empty() && uri.rfind("data:", 0) != 0) {
+            files.push_back(directory + decodeUri(uri));
+        }
+    }
+    return files;
+}
+
+// The JSON of a .gltf file, or the JSON chunk of a .glb file whose BIN chunk is copied to the given buffer (if any)
+JsonValue MeshImporter::parseGltfFile(const std::string& filename, std::span<const char> file, std::vector<char>* pglbBuffer) {
+    if (getExtension(filename) != "glb") {
+        return JsonValue::parse(std::string_view(file.data(), file.size()));
+    }
+
+    // 12-byte header (magic, version, length), then chunks of (length, type, data): JSON first, then an optional BIN
+    auto readUint = [&](size_t offset) {
+        uint32_t value = 0;
+        if (offset + 4 <= file.size()) {
+            memcpy(&value, file.data() + offset, 4);
+        }
+        return value;
+    };
+    if (readUint(0) != 0x46546C67 || readUint(4) != 2) { // "glTF"
+        throw std::runtime_error("failed to import " + filename + ", not a glTF 2.0 binary!");
+    }
+    size_t jsonLength = readUint(12);
+    if (readUint(16) != 0x4E4F534A || 20 + jsonLength > file.size()) { // "JSON"
+        throw std::runtime_error("failed to import " + filename + ", invalid JSON chunk!");
+    }
+    JsonValue document = JsonValue::parse(std::string_view(file.data() + 20, jsonLength));
+
+    size_t binOffset = 20 + jsonLength;
+    size_t binLength = readUint(binOffset);
+    if (pglbBuffer != nullptr && readUint(binOffset + 4) == 0x004E4942 && binOffset + 8 + binLength <= file.size()) { // "BIN"
+        pglbBuffer->assign(file.begin() + binOffset + 8, file.begin() + binOffset + 8 + binLength);
+    }
+    return document;
+}
+
+std::vector<Vertex> MeshImporter::parseObj(std::span<const char> text, ThreadPool* pthreadPool) {
+    // Chunks end after a line break, so that no line is split between two of them
+    std::vector<ObjChunk> chunks;
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    while (begin < end) {
+        const char* chunkEnd = begin + std::min<size_t>(OBJ_CHUNK_SIZE, end - begin);
+        const char* lineBreak = static_cast<const char*>(memchr(chunkEnd, '\n', end - chunkEnd));
+        chunkEnd = lineBreak != nullptr ? lineBreak + 1 : end;
+
+        ObjChunk chunk;
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        chunks.push_back(std::move(chunk));
+        begin = chunkEnd;
+    }
+
+    ObjParseJob parseJob{ &chunks };
+    runParallel(pthreadPool, static_cast<uint32_t>(chunks.size()), 1, &parseObjChunks, &parseJob);
+
+    // The elements of the chunks are concatenated in file order, which gives the indices of the file
+    std::vector<glm::vec3> positions, colors, normals;
+    std::vector<glm::vec2> texCoords;
+    size_t vertexCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        if (chunk.parseError) {
+            throw std::runtime_error("failed to import OBJ, malformed vertex or face!");
+        }
+        chunk.positionBase = static_cast<int32_t>(positions.size());
+        chunk.texCoordBase = static_cast<int32_t>(texCoords.size());
+        chunk.normalBase = static_cast<int32_t>(normals.size());
+        chunk.firstVertex = vertexCount;
+        vertexCount += chunk.corners.size();
+
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+        texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+    }
+
+    std::vector<Vertex> triangleVertices(vertexCount);
+    std::atomic<bool> indexError{ false };
+    ObjAssembleJob assembleJob{ &chunks, &positions, &colors, &texCoords, &normals, triangleVertices.data(), &indexError };
+    runParallel(pthreadPool, static_cast<uint32_t>(chunks.size()), 1, &assembleObjChunks, &assembleJob);
+
+    if (indexError.load()) {
+        throw std::runtime_error("failed to import OBJ, a face references a missing vertex!");
+    }
+    return triangleVertices;
+}
+
+std::vector<std::vector<char>> MeshImporter::loadGltfBuffers(const JsonValue& document, const std::string& directory, std::vector<char>* pglbBuffer) {
+    const JsonValue& buffersJson = document["buffers"];
+    std::vector<std::vector<char>> buffers(buffersJson.size());
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+        const std::string& uri = buffersJson[i]["uri"].getString();
+        if (uri.empty()) {
+            buffers[i] = std::move(*pglbBuffer); // The BIN chunk of the .glb
+        }
+        else if (uri.rfind("data:", 0) == 0) {
+            size_t comma = uri.find(',');
+            if (comma == std::string::npos || uri.find(";base64") == std::string::npos) {
+                throw std::runtime_error("failed to import glTF, unsupported data URI!");
+            }
+            buffers[i] = decodeBase64(uri, comma + 1);
+        }
+        else {
+            buffers[i] = readBinaryFile(directory + decodeUri(uri));
+        }
+
+        if (buffers[i].size() < buffersJson[i]["byteLength"].getUint()) {
+            throw std::runtime_error("failed to import glTF, a buffer is shorter than its byteLength!");
+        }
+    }
+    return buffers;
+}
+
+std::vector<Vertex> MeshImporter::parseGltf(const JsonValue& document, std::vector<std::vector<char>>& buffers, ThreadPool* pthreadPool) {
+    // The accessors are validated here, on the calling thread, the decoding jobs can then read them blindly
+    std::vector<GltfDraw> draws;
+    GltfTraversal traversal{ document, buffers, draws };
+
+    const JsonValue& scenes = document["scenes"];
+    if (scenes.size() > 0) {
+        const JsonValue& nodes = scenes[document["scene"].getUint(0)]["nodes"];
+        for (size_t i = 0; i < nodes.size(); i++) {
+            traversal.visitNode(nodes[i].getUint(), glm::mat4(1.0f), 0);
+        }
+    }
+    else {
+        // No scene: every mesh once, untransformed
+        for (uint32_t i = 0; i < document["meshes"].size(); i++) {
+            traversal.addMesh(i, glm::mat4(1.0f));
+        }
+    }
+
+    // Cut the draws in work items of at most GLTF_TRIANGLES_PER_JOB triangles, so that one large primitive is spread
+    // over every thread
+    std::vector<GltfWorkItem> items;
+    size_t vertexCount = 0;
+    for (uint32_t d = 0; d < draws.size(); d++) {
+        GltfDraw& draw = draws[d];
+        uint32_t triangleCount = (draw.indices.isValid() ? draw.indices.count : draw.positions.count) / 3;
+        draw.firstVertex = vertexCount;
+        vertexCount += size_t(triangleCount) * 3;
+
+        for (uint32_t first = 0; first < triangleCount; first += GLTF_TRIANGLES_PER_JOB) {
+            items.push_back({ d, first, std::min(GLTF_TRIANGLES_PER_JOB, triangleCount - first) });
+        }
+    }
+
+    std::vector<Vertex> triangleVertices(vertexCount);
+    std::atomic<bool> indexError{ false };
+    GltfDecodeJob decodeJob{ &draws, &items, triangleVertices.data(), &indexError };
+    runParallel(pthreadPool, static_cast<uint32_t>(items.size()), 1, &decodeGltfItems, &decodeJob);
+
+    if (indexError.load()) {
+        throw std::runtime_error("failed to import glTF, an index is out of the range of its vertices!");
+    }
+    return triangleVertices;
+}
+
+MeshData MeshImporter::deduplicate(const std::vector<Vertex>& triangleVertices, ThreadPool* pthreadPool) {
+    uint32_t count = static_cast<uint32_t>(triangleVertices.size());
+    std::vector<uint32_t> hashes(count);
+    HashJob hashJob{ triangleVertices.data(), hashes.data() };
+    runParallel(pthreadPool, count, DEDUPLICATION_BATCH_SIZE, &hashVertices, &hashJob);
+
+    // Open addressing with linear probing, at most half full: a slot holds the index of a unique vertex
+    uint32_t tableSize = 1;
+    while (tableSize < count * 2) {
+        tableSize <<= 1;
+    }
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);
+    uint32_t mask = tableSize - 1;
+
+    MeshData mesh;
+    mesh.indices.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const Vertex& vertex = triangleVertices[i];
+        uint32_t slot = hashes[i] & mask;
+        while (true) {
+            uint32_t unique = table[slot];
+            if (unique == UINT32_MAX) {
+                unique = static_cast<uint32_t>(mesh.vertices.size());
+                table[slot] = unique;
+                mesh.vertices.push_back(vertex);
+                mesh.indices[i] = unique;
+                break;
+            }
+            if (memcmp(&mesh.vertices[unique], &vertex, sizeof(Vertex)) == 0) {
+                mesh.indices[i] = unique;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    mesh.computeBounds();
+    return mesh;
+}
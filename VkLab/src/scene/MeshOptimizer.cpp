@@ -0,0 +1,286 @@
+#include "scene/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+    // Triangles around each vertex, in compressed rows: the triangles of vertex v are triangles[offsets[v]..offsets[v + 1]]
+    struct TriangleAdjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+    TriangleAdjacency buildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount) {
+        TriangleAdjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : indices) {
+            adjacency.offsets[index + 1]++;
+        }
+        std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+        std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        adjacency.triangles.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); i++) {
+            adjacency.triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+        return adjacency;
+    }
+
+    // FIFO cache simulated with timestamps: a vertex is in the cache when fewer than cacheSize misses happened since it was
+    // loaded. Advancing the time by cacheSize + 1 empties the cache without touching the timestamps
+    class CacheSimulator
+    {
+    public:
+        CacheSimulator(size_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), cacheSize(cacheSize), time(cacheSize + 1) {}
+
+        bool access(uint32_t vertex) {
+            if (time - timestamps[vertex] > cacheSize) {
+                timestamps[vertex] = time++;
+                return true;
+            }
+            return false;
+        }
+
+        uint32_t countMisses(const uint32_t* pindices, size_t indexCount) {
+            uint32_t misses = 0;
+            for (size_t i = 0; i < indexCount; i++) {
+                misses += access(pindices[i]) ? 1 : 0;
+            }
+            return misses;
+        }
+
+        void flush() {
+            time += cacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> timestamps;
+        uint32_t cacheSize;
+        uint32_t time;
+    };
+
+    // Sum of the (area weighted) normals and centroids of a range of triangles
+    struct ClusterGeometry {
+        glm::vec3 normal = glm::vec3(0.0f);
+        glm::vec3 centroid = glm::vec3(0.0f);
+        float area = 0.0f;
+    };
+
+    ClusterGeometry measureTriangles(const MeshData& mesh, uint32_t firstTriangle, uint32_t endTriangle) {
+        ClusterGeometry geometry;
+        for (uint32_t t = firstTriangle; t < endTriangle; t++) {
+            const glm::vec3& a = mesh.vertices[mesh.indices[t * 3]].pos;
+            const glm::vec3& b = mesh.vertices[mesh.indices[t * 3 + 1]].pos;
+            const glm::vec3& c = mesh.vertices[mesh.indices[t * 3 + 2]].pos;
+            glm::vec3 normal = glm::cross(b - a, c - a); // Its length is twice the area
+            float area = glm::length(normal) * 0.5f;
+            geometry.normal += normal;
+            geometry.centroid += (a + b + c) * (area / 3.0f);
+            geometry.area += area;
+        }
+        if (geometry.area > 0.0f) {
+            geometry.centroid /= geometry.area;
+        }
+        return geometry;
+    }
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(MeshData& mesh) {
+    Report report;
+    report.before = analyzeVertexCache(mesh);
+
+    std::vector<uint32_t> clusterStarts;
+    optimizeVertexCache(mesh, &clusterStarts);
+    optimizeOverdraw(mesh, clusterStarts);
+    optimizeVertexFetch(mesh);
+
+    report.after = analyzeVertexCache(mesh);
+    return report;
+}
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const MeshData& mesh, uint32_t cacheSize) {
+    VertexCacheStatistics statistics;
+    if (mesh.indices.empty() || mesh.vertices.empty()) {
+        return statistics;
+    }
+
+    CacheSimulator cache(mesh.vertices.size(), cacheSize);
+    uint32_t misses = cache.countMisses(mesh.indices.data(), mesh.indices.size());
+    statistics.acmr = static_cast<float>(misses) / (mesh.indices.size() / 3);
+    statistics.atvr = static_cast<float>(misses) / mesh.vertices.size();
+    return statistics;
+}
+
+// Tipsify: emit every remaining triangle around a fanning vertex, then continue from the vertex of these triangles that
+// entered the cache the earliest but will still be in it once its own triangles are emitted. When none qualifies, the
+// next vertex comes from the most recently used ones (dead-end stack), then from the input order: the cache is cold there
+void MeshOptimizer::optimizeVertexCache(MeshData& mesh, std::vector<uint32_t>* pclusterStarts) {
+    optimizeVertexCache(mesh.indices, mesh.vertices.size(), pclusterStarts);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* pclusterStarts) {
+    if (pclusterStarts != nullptr) {
+        pclusterStarts->clear();
+    }
+
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    TriangleAdjacency adjacency = buildAdjacency(indices, vertexCount);
+
+    std::vector<uint32_t> liveTriangles(vertexCount); // Triangles of the vertex that are not emitted yet
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time = VERTEX_CACHE_SIZE + 1;
+    uint32_t cursor = 0; // Vertices before the cursor have no live triangle left
+
+    auto nextInputVertex = [&]() {
+        while (cursor < vertexCount && liveTriangles[cursor] == 0) {
+            cursor++;
+        }
+        return cursor < vertexCount ? cursor : NO_VERTEX;
+    };
+
+    uint32_t fanningVertex = nextInputVertex();
+    if (fanningVertex != NO_VERTEX && pclusterStarts != nullptr) {
+        pclusterStarts->push_back(0);
+    }
+
+    while (fanningVertex != NO_VERTEX) {
+        candidates.clear();
+        for (uint32_t k = adjacency.offsets[fanningVertex]; k < adjacency.offsets[fanningVertex + 1]; k++) {
+            uint32_t triangle = adjacency.triangles[k];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = 1;
+
+            for (uint32_t c = 0; c < 3; c++) {
+                uint32_t vertex = indices[triangle * 3 + c];
+                output.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (time - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE) {
+                    cacheTimestamps[vertex] = time++;
+                }
+            }
+        }
+
+        // Fanning around a candidate loads at most two new vertices per live triangle
+        uint32_t next = NO_VERTEX;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            uint32_t age = time - cacheTimestamps[vertex];
+            if (age + 2 * liveTriangles[vertex] <= VERTEX_CACHE_SIZE) {
+                priority = age;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next == NO_VERTEX) {
+            while (!deadEndStack.empty() && next == NO_VERTEX) {
+                uint32_t vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveTriangles[vertex] > 0) {
+                    next = vertex;
+                }
+            }
+            if (next == NO_VERTEX) {
+                next = nextInputVertex();
+            }
+            if (next != NO_VERTEX && pclusterStarts != nullptr) {
+                pclusterStarts->push_back(static_cast<uint32_t>(output.size() / 3));
+            }
+        }
+        fanningVertex = next;
+    }
+
+    indices = std::move(output);
+}
+
+// Sander et al. 2007, view-independent overdraw: the clusters are cut further wherever the cluster up to there already
+// has an ACMR within threshold of the whole run, then sorted so that the ones whose normal points away from the center of
+// the mesh are drawn first. From most viewpoints they are in front of the others
+void MeshOptimizer::optimizeOverdraw(MeshData& mesh, const std::vector<uint32_t>& clusterStarts, float threshold) {
+    uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+    if (triangleCount == 0 || clusterStarts.empty()) {
+        return;
+    }
+
+    CacheSimulator cache(mesh.vertices.size(), VERTEX_CACHE_SIZE);
+    std::vector<uint32_t> clusters; // First triangle of each cluster
+    for (size_t i = 0; i < clusterStarts.size(); i++) {
+        uint32_t begin = clusterStarts[i];
+        uint32_t end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount;
+
+        uint32_t runMisses = cache.countMisses(mesh.indices.data() + size_t(begin) * 3, size_t(end - begin) * 3);
+        cache.flush();
+        float missesPerTriangle = threshold * runMisses / (end - begin);
+
+        clusters.push_back(begin);
+        uint32_t clusterBegin = begin;
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; t++) {
+            clusterMisses += cache.countMisses(mesh.indices.data() + size_t(t) * 3, 3);
+            if (t + 1 < end && clusterMisses <= missesPerTriangle * (t + 1 - clusterBegin)) {
+                clusters.push_back(t + 1);
+                clusterBegin = t + 1;
+                clusterMisses = 0;
+                cache.flush();
+            }
+        }
+        cache.flush();
+    }
+
+    ClusterGeometry meshGeometry = measureTriangles(mesh, 0, triangleCount);
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t i = 0; i < clusters.size(); i++) {
+        uint32_t end = i + 1 < clusters.size() ? clusters[i + 1] : triangleCount;
+        ClusterGeometry geometry = measureTriangles(mesh, clusters[i], end);
+        float normalLength = glm::length(geometry.normal);
+        sortKeys[i] = normalLength > 0.0f ? glm::dot(geometry.centroid - meshGeometry.centroid, geometry.normal / normalLength) : 0.0f;
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.indices.size());
+    for (uint32_t cluster : order) {
+        uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+        indices.insert(indices.end(), mesh.indices.begin() + size_t(clusters[cluster]) * 3, mesh.indices.begin() + size_t(end) * 3);
+    }
+    mesh.indices = std::move(indices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), NO_VERTEX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == NO_VERTEX) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
@@ -0,0 +1,370 @@
+#include "scene/MeshSimplifier.h"
+#include "scene/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace {
+    constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+    // Sum of squared distances to planes weighted by area: error(p) = p.A.p + 2 b.p + c, with A symmetric.
+    // Accumulated in double, the terms of large meshes cancel out in float
+    struct Quadric {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0; // Total area of the planes
+
+        static Quadric fromTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+            Quadric quadric;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if (length == 0.0) {
+                return quadric;
+            }
+            double nx = normal.x / length, ny = normal.y / length, nz = normal.z / length;
+            double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+            double area = length * 0.5;
+            quadric.a00 = area * nx * nx; quadric.a01 = area * nx * ny; quadric.a02 = area * nx * nz;
+            quadric.a11 = area * ny * ny; quadric.a12 = area * ny * nz; quadric.a22 = area * nz * nz;
+            quadric.b0 = area * nx * d; quadric.b1 = area * ny * d; quadric.b2 = area * nz * d;
+            quadric.c = area * d * d;
+            quadric.weight = area;
+            return quadric;
+        }
+
+        void add(const Quadric& other) {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        double evaluate(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            return a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        }
+    };
+
+    // Moves every vertex at the source position onto the vertex at the target position of the edge triangles
+    struct Collapse {
+        float error; // Mean squared distance to the planes of both positions
+        uint32_t source;
+        uint32_t target;
+        uint32_t sourceVersion;
+        uint32_t targetVersion;
+    };
+
+    // Cheapest first with std::push_heap and std::pop_heap
+    bool operator<(const Collapse& a, const Collapse& b) {
+        return a.error > b.error;
+    }
+
+    // Edge collapses on the positions of the mesh: the vertices that share a position are welded, the triangles keep
+    // their vertices. Collapses whose positions changed since they were queued are skipped when they come out of the
+    // heap, the changed positions queue their edges again
+    class EdgeCollapser
+    {
+    public:
+        EdgeCollapser(const MeshData& mesh, uint32_t indexCount);
+
+        // Collapses until at most targetTriangles are left, false when the valid collapses ran out before
+        bool simplify(uint32_t targetTriangles);
+        void appendTriangles(std::vector<uint32_t>& indices) const;
+
+        uint32_t getTriangleCount() const { return liveTriangleCount; }
+        float getError() const { return static_cast<float>(std::sqrt(maxError)); } // Distance, in the unit of the positions
+
+    private:
+        static constexpr uint8_t LOCKED = 1; // Border or non-manifold
+        static constexpr uint8_t SEAM = 2;
+        static constexpr uint8_t REMOVED = 4;
+
+        bool isAlive(uint32_t triangle) const { return triangles[triangle * 3] != NO_VERTEX; }
+        bool containsPosition(uint32_t triangle, uint32_t position) const;
+        void gatherNeighbors(uint32_t position, std::vector<uint32_t>& neighbors) const;
+        void queueCollapse(uint32_t source, uint32_t target);
+        bool tryCollapse(const Collapse& collapse);
+
+        std::vector<uint32_t> triangles; // Vertices, the first one is NO_VERTEX once the triangle is collapsed
+        std::vector<uint32_t> vertexPositions; // Welded position of each vertex
+        std::vector<glm::vec3> positions;
+        std::vector<std::vector<uint32_t>> positionTriangles;
+        std::vector<Quadric> quadrics;
+        std::vector<uint8_t> flags;
+        std::vector<uint32_t> versions;
+        std::vector<Collapse> heap;
+        uint32_t liveTriangleCount = 0;
+        double maxError = 0.0;
+
+        std::vector<uint32_t> sourceNeighbors;
+        std::vector<uint32_t> targetNeighbors;
+    };
+
+    EdgeCollapser::EdgeCollapser(const MeshData& mesh, uint32_t indexCount) {
+        uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+
+        // Welding: the vertices sorted by position, equal runs get the same position
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        auto lessPosition = [&](uint32_t a, uint32_t b) {
+            const glm::vec3& pa = mesh.vertices[a].pos;
+            const glm::vec3& pb = mesh.vertices[b].pos;
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        };
+        std::sort(order.begin(), order.end(), lessPosition);
+
+        vertexPositions.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            if (i == 0 || lessPosition(order[i - 1], order[i])) {
+                positions.push_back(mesh.vertices[order[i]].pos);
+                flags.push_back(0);
+            } else {
+                flags.back() |= SEAM;
+            }
+            vertexPositions[order[i]] = static_cast<uint32_t>(positions.size() - 1);
+        }
+
+        uint32_t positionCount = static_cast<uint32_t>(positions.size());
+        positionTriangles.resize(positionCount);
+        quadrics.resize(positionCount);
+        versions.assign(positionCount, 0);
+
+        // Triangles that are degenerate once welded are dropped from the start
+        triangles.assign(mesh.indices.begin(), mesh.indices.begin() + indexCount);
+        std::vector<uint64_t> edges;
+        for (uint32_t t = 0; t < indexCount / 3; t++) {
+            uint32_t p[3] = { vertexPositions[triangles[t * 3]], vertexPositions[triangles[t * 3 + 1]], vertexPositions[triangles[t * 3 + 2]] };
+            if (p[0] == p[1] || p[1] == p[2] || p[2] == p[0]) {
+                triangles[t * 3] = NO_VERTEX;
+                continue;
+            }
+            liveTriangleCount++;
+
+            Quadric quadric = Quadric::fromTriangle(positions[p[0]], positions[p[1]], positions[p[2]]);
+            for (uint32_t c = 0; c < 3; c++) {
+                positionTriangles[p[c]].push_back(t);
+                quadrics[p[c]].add(quadric);
+                uint32_t a = p[c], b = p[(c + 1) % 3];
+                edges.push_back(uint64_t(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+
+        // An edge used by anything but two triangles is on a border or non-manifold
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t end = i;
+            while (end < edges.size() && edges[end] == edges[i]) {
+                end++;
+            }
+            uint32_t a = static_cast<uint32_t>(edges[i] >> 32), b = static_cast<uint32_t>(edges[i]);
+            if (end - i != 2) {
+                flags[a] |= LOCKED;
+                flags[b] |= LOCKED;
+            }
+            i = end;
+        }
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        for (uint64_t edge : edges) {
+            uint32_t a = static_cast<uint32_t>(edge >> 32), b = static_cast<uint32_t>(edge);
+            queueCollapse(a, b);
+            queueCollapse(b, a);
+        }
+    }
+
+    bool EdgeCollapser::containsPosition(uint32_t triangle, uint32_t position) const {
+        return vertexPositions[triangles[triangle * 3]] == position || vertexPositions[triangles[triangle * 3 + 1]] == position
+            || vertexPositions[triangles[triangle * 3 + 2]] == position;
+    }
+
+    void EdgeCollapser::gatherNeighbors(uint32_t position, std::vector<uint32_t>& neighbors) const {
+        neighbors.clear();
+        for (uint32_t triangle : positionTriangles[position]) {
+            if (!isAlive(triangle)) {
+                continue;
+            }
+            for (uint32_t c = 0; c < 3; c++) {
+                uint32_t neighbor = vertexPositions[triangles[triangle * 3 + c]];
+                if (neighbor != position) {
+                    neighbors.push_back(neighbor);
+                }
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+
+    void EdgeCollapser::queueCollapse(uint32_t source, uint32_t target) {
+        if (flags[source] != 0 || (flags[target] & REMOVED)) {
+            return;
+        }
+        Quadric quadric = quadrics[source];
+        quadric.add(quadrics[target]);
+        double error = quadric.weight > 0.0 ? std::max(quadric.evaluate(positions[target]) / quadric.weight, 0.0) : 0.0;
+
+        heap.push_back({ static_cast<float>(error), source, target, versions[source], versions[target] });
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    bool EdgeCollapser::simplify(uint32_t targetTriangles) {
+        while (liveTriangleCount > targetTriangles && !heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            Collapse collapse = heap.back();
+            heap.pop_back();
+
+            if ((flags[collapse.source] & REMOVED) || (flags[collapse.target] & REMOVED)
+                || versions[collapse.source] != collapse.sourceVersion || versions[collapse.target] != collapse.targetVersion) {
+                continue;
+            }
+            tryCollapse(collapse);
+        }
+        return liveTriangleCount <= targetTriangles;
+    }
+
+    bool EdgeCollapser::tryCollapse(const Collapse& collapse) {
+        uint32_t source = collapse.source;
+        uint32_t target = collapse.target;
+
+        // The triangles of the edge must agree on the vertex of the target, the others move onto it
+        uint32_t targetVertex = NO_VERTEX;
+        uint32_t edgeTriangleCount = 0;
+        for (uint32_t triangle : positionTriangles[source]) {
+            if (!isAlive(triangle) || !containsPosition(triangle, target)) {
+                continue;
+            }
+            edgeTriangleCount++;
+            for (uint32_t c = 0; c < 3; c++) {
+                uint32_t vertex = triangles[triangle * 3 + c];
+                if (vertexPositions[vertex] == target) {
+                    if (targetVertex != NO_VERTEX && targetVertex != vertex) {
+                        return false;
+                    }
+                    targetVertex = vertex;
+                }
+            }
+        }
+        if (edgeTriangleCount == 0) {
+            return false;
+        }
+
+        // Link condition: the only neighbors both ends share are the opposite corners of the edge triangles, otherwise
+        // the collapse merges two sheets of the surface and leaves a non-manifold fin
+        gatherNeighbors(source, sourceNeighbors);
+        gatherNeighbors(target, targetNeighbors);
+        uint32_t sharedCount = 0;
+        for (size_t i = 0, j = 0; i < sourceNeighbors.size() && j < targetNeighbors.size();) {
+            if (sourceNeighbors[i] < targetNeighbors[j]) {
+                i++;
+            } else if (targetNeighbors[j] < sourceNeighbors[i]) {
+                j++;
+            } else {
+                sharedCount++;
+                i++;
+                j++;
+            }
+        }
+        if (sharedCount != edgeTriangleCount) {
+            return false;
+        }
+
+        // The triangles that move must keep facing about the same way: a plain sign test lets through the ones that end
+        // up almost degenerate, whose normal is then arbitrary
+        for (uint32_t triangle : positionTriangles[source]) {
+            if (!isAlive(triangle) || containsPosition(triangle, target)) {
+                continue;
+            }
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            for (uint32_t c = 0; c < 3; c++) {
+                uint32_t position = vertexPositions[triangles[triangle * 3 + c]];
+                before[c] = positions[position];
+                after[c] = position == source ? positions[target] : before[c];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= MeshSimplifier::MIN_NORMAL_COSINE * glm::length(normalBefore) * glm::length(normalAfter)) {
+                return false;
+            }
+        }
+
+        for (uint32_t triangle : positionTriangles[source]) {
+            if (!isAlive(triangle)) {
+                continue;
+            }
+            if (containsPosition(triangle, target)) {
+                triangles[triangle * 3] = NO_VERTEX;
+                liveTriangleCount--;
+                continue;
+            }
+            for (uint32_t c = 0; c < 3; c++) {
+                if (vertexPositions[triangles[triangle * 3 + c]] == source) {
+                    triangles[triangle * 3 + c] = targetVertex;
+                }
+            }
+            positionTriangles[target].push_back(triangle);
+        }
+
+        std::vector<uint32_t>& targetTriangles = positionTriangles[target];
+        targetTriangles.erase(std::remove_if(targetTriangles.begin(), targetTriangles.end(), [&](uint32_t triangle) { return !isAlive(triangle); }), targetTriangles.end());
+        positionTriangles[source] = {};
+        quadrics[target].add(quadrics[source]);
+        flags[source] |= REMOVED;
+        versions[target]++;
+        maxError = std::max(maxError, double(collapse.error));
+
+        // The quadric of the target changed, so did the cost of all its edges
+        gatherNeighbors(target, targetNeighbors);
+        for (uint32_t neighbor : targetNeighbors) {
+            queueCollapse(neighbor, target);
+            queueCollapse(target, neighbor);
+        }
+        return true;
+    }
+
+    void EdgeCollapser::appendTriangles(std::vector<uint32_t>& indices) const {
+        for (uint32_t t = 0; t < triangles.size() / 3; t++) {
+            if (isAlive(t)) {
+                indices.insert(indices.end(), triangles.begin() + size_t(t) * 3, triangles.begin() + size_t(t) * 3 + 3);
+            }
+        }
+    }
+}
+
+void MeshSimplifier::generateLods(MeshData& mesh) {
+    // Generating again starts from the full mesh
+    uint32_t indexCount = mesh.lods.empty() ? static_cast<uint32_t>(mesh.indices.size()) : mesh.lods[0].indexCount;
+    mesh.indices.resize(indexCount);
+    mesh.lods.assign(1, { 0, indexCount, 0.0f });
+    if (indexCount / 3 * LOD_REDUCTION < MIN_LOD_TRIANGLES) {
+        return;
+    }
+
+    EdgeCollapser collapser(mesh, indexCount);
+    std::vector<uint32_t> lodIndices;
+    while (mesh.lods.size() < MAX_LOD_COUNT) {
+        uint32_t previousTriangles = mesh.lods.back().indexCount / 3;
+        uint32_t targetTriangles = static_cast<uint32_t>(previousTriangles * LOD_REDUCTION);
+        if (targetTriangles < MIN_LOD_TRIANGLES) {
+            break;
+        }
+
+        bool reached = collapser.simplify(targetTriangles);
+        // Stuck on locked positions well above the target: a LOD this close to the previous one isn't worth drawing
+        if (collapser.getTriangleCount() > previousTriangles * 0.8f) {
+            break;
+        }
+
+        lodIndices.clear();
+        collapser.appendTriangles(lodIndices);
+        MeshOptimizer::optimizeVertexCache(lodIndices, mesh.vertices.size());
+        mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(lodIndices.size()), collapser.getError() });
+        mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+        if (!reached) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "scene/MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+    constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+    glm::vec3 normalizeOrZero(const glm::vec3& v) {
+        float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f);
+    }
+}
+
+void MeshletBuilder::build(MeshData& mesh) {
+    mesh.meshlets.clear();
+    mesh.meshletVertices.clear();
+    mesh.meshletTriangles.clear();
+    MeshLod lod = mesh.getLods()[0];
+    uint32_t triangleCount = lod.indexCount / 3;
+    if (triangleCount < MIN_MESH_TRIANGLES) {
+        return;
+    }
+    const uint32_t* indices = mesh.indices.data() + lod.firstIndex;
+    size_t vertexCount = mesh.vertices.size();
+
+    // Triangles around each vertex, in compressed rows
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < lod.indexCount; i++) {
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(lod.indexCount);
+    std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < lod.indexCount; i++) {
+        adjacency[adjacencyFill[indices[i]]++] = i / 3;
+    }
+
+    // Unit normal (zero for degenerate triangles) and centroid of each triangle
+    std::vector<glm::vec3> triangleNormals(triangleCount);
+    std::vector<glm::vec3> triangleCenters(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        const glm::vec3& p0 = mesh.vertices[indices[t * 3 + 0]].pos;
+        const glm::vec3& p1 = mesh.vertices[indices[t * 3 + 1]].pos;
+        const glm::vec3& p2 = mesh.vertices[indices[t * 3 + 2]].pos;
+        triangleNormals[t] = normalizeOrZero(glm::cross(p1 - p0, p2 - p0));
+        triangleCenters[t] = (p0 + p1 + p2) / 3.0f;
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> localVertices(vertexCount, NO_VERTEX); // Position of each vertex in the current meshlet
+    std::vector<uint32_t> order; // Triangles in meshlet order
+    order.reserve(triangleCount);
+    std::vector<uint32_t> vertices; // Of the current meshlet
+    vertices.reserve(MAX_VERTICES);
+
+    // The input comes out of the vertex cache optimization, the next triangle not emitted yet is a spatially coherent seed
+    uint32_t seed = 0;
+    while (order.size() < triangleCount) {
+        while (emitted[seed]) {
+            seed++;
+        }
+        uint32_t meshletStart = static_cast<uint32_t>(order.size());
+        glm::vec3 centerSum(0.0f);
+        glm::vec3 normalSum(0.0f);
+
+        uint32_t next = seed;
+        while (next != NO_VERTEX) {
+            emitted[next] = 1;
+            order.push_back(next);
+            for (uint32_t k = 0; k < 3; k++) {
+                uint32_t vertex = indices[next * 3 + k];
+                if (localVertices[vertex] == NO_VERTEX) {
+                    localVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                }
+            }
+            centerSum += triangleCenters[next];
+            normalSum += triangleNormals[next];
+            uint32_t meshletTriangles = static_cast<uint32_t>(order.size()) - meshletStart;
+            if (meshletTriangles == MAX_TRIANGLES) {
+                break;
+            }
+
+            // Fewest new vertices first, then the closest to the meshlet, the distance growing as the normal turns away
+            glm::vec3 center = centerSum / static_cast<float>(meshletTriangles);
+            glm::vec3 axis = normalizeOrZero(normalSum);
+            next = NO_VERTEX;
+            uint32_t bestNewVertices = 4;
+            float bestCost = std::numeric_limits<float>::max();
+            for (uint32_t vertex : vertices) {
+                for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+                    uint32_t candidate = adjacency[a];
+                    if (emitted[candidate]) {
+                        continue;
+                    }
+                    uint32_t newVertices = 0;
+                    for (uint32_t k = 0; k < 3; k++) {
+                        newVertices += localVertices[indices[candidate * 3 + k]] == NO_VERTEX ? 1 : 0;
+                    }
+                    if (vertices.size() + newVertices > MAX_VERTICES || newVertices > bestNewVertices) {
+                        continue;
+                    }
+                    float cost = glm::length(triangleCenters[candidate] - center) * (2.0f - glm::dot(triangleNormals[candidate], axis));
+                    if (newVertices < bestNewVertices || cost < bestCost) {
+                        next = candidate;
+                        bestNewVertices = newVertices;
+                        bestCost = cost;
+                    }
+                }
+            }
+        }
+
+        Meshlet meshlet{};
+        meshlet.firstIndex = lod.firstIndex + meshletStart * 3;
+        meshlet.triangleCount = static_cast<uint32_t>(order.size()) - meshletStart;
+        meshlet.firstVertex = static_cast<uint32_t>(mesh.meshletVertices.size());
+        meshlet.vertexCount = static_cast<uint32_t>(vertices.size());
+
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+        for (uint32_t vertex : vertices) {
+            boundsMin = glm::min(boundsMin, mesh.vertices[vertex].pos);
+            boundsMax = glm::max(boundsMax, mesh.vertices[vertex].pos);
+        }
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radius = 0.0f;
+        for (uint32_t vertex : vertices) {
+            radius = std::max(radius, glm::length(mesh.vertices[vertex].pos - center));
+        }
+        meshlet.sphere = glm::vec4(center, radius);
+
+        // The cone contains every normal: the triangles all face away from the viewpoints within the complementary cone,
+        // a cutoff of 1 is never reached
+        glm::vec3 axis = normalizeOrZero(normalSum);
+        float minCosine = glm::length(axis) > 0.0f ? 1.0f : -1.0f;
+        for (uint32_t i = meshletStart; i < order.size(); i++) {
+            if (triangleNormals[order[i]] != glm::vec3(0.0f)) {
+                minCosine = std::min(minCosine, glm::dot(triangleNormals[order[i]], axis));
+            }
+        }
+        float cutoff = minCosine <= MIN_CONE_COSINE ? 1.0f : std::sqrt(1.0f - minCosine * minCosine);
+        meshlet.cone = glm::vec4(axis, cutoff);
+
+        for (uint32_t i = meshletStart; i < order.size(); i++) {
+            const uint32_t* triangle = indices + order[i] * 3;
+            mesh.meshletTriangles.push_back(localVertices[triangle[0]] | localVertices[triangle[1]] << 8 | localVertices[triangle[2]] << 16);
+        }
+        mesh.meshletVertices.insert(mesh.meshletVertices.end(), vertices.begin(), vertices.end());
+        mesh.meshlets.push_back(meshlet);
+
+        for (uint32_t vertex : vertices) {
+            localVertices[vertex] = NO_VERTEX;
+        }
+        vertices.clear();
+    }
+
+    std::vector<uint32_t> reordered(lod.indexCount);
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        std::copy_n(indices + order[i] * 3, 3, reordered.begin() + i * 3);
+    }
+    std::copy(reordered.begin(), reordered.end(), mesh.indices.begin() + lod.firstIndex);
+}
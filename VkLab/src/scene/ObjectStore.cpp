@@ -0,0 +1,215 @@
+#include "scene/ObjectStore.h"
+#include "utils/CpuFeatures.h"
+
+#include <algorithm>
+#include <bit>
+#include <immintrin.h>
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection) {
+    // GLM matrices are column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    Frustum frustum{};
+    frustum.planes[0] = row(3) + row(0); // Left: -w <= x
+    frustum.planes[1] = row(3) - row(0); // Right: x <= w
+    frustum.planes[2] = row(3) + row(1); // Top or bottom, the projection flips Y
+    frustum.planes[3] = row(3) - row(1);
+    frustum.planes[4] = row(2);          // Near: 0 <= z
+    frustum.planes[5] = row(3) - row(2); // Far: z <= w
+
+    // Normalized so that the plane equation gives a distance, which is compared to the sphere radius
+    for (auto& plane : frustum.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+void ObjectStore::initialize(uint32_t capacity) {
+    for (auto* parray : { &centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ }) {
+        parray->reserve(capacity);
+    }
+}
+
+void ObjectStore::setMeshBounds(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    meshCenter = (boundsMin + boundsMax) * 0.5f;
+    meshExtents = (boundsMax - boundsMin) * 0.5f;
+    meshRadius = glm::length(meshExtents); // Sphere around the box, the mesh fits inside
+}
+
+void ObjectStore::update(std::span<const glm::mat4> worldTransforms) {
+    count = static_cast<uint32_t>(worldTransforms.size());
+    for (auto* parray : { &centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ }) {
+        parray->resize(count);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        updateBounds(i, worldTransforms[i]);
+    }
+}
+
+void ObjectStore::update(std::span<const glm::mat4> worldTransforms, std::span<const uint32_t> changedObjects) {
+    for (uint32_t i : changedObjects) {
+        updateBounds(i, worldTransforms[i]);
+    }
+}
+
+void ObjectStore::updateBounds(uint32_t i, const glm::mat4& model) {
+    glm::vec3 center = glm::vec3(model * glm::vec4(meshCenter, 1.0f));
+
+    // The largest axis scale keeps the sphere conservative under non-uniform scaling
+    float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+
+    // Arvo: the extents of the transformed box are the object extents through the absolute value of the rotation and scale
+    glm::vec3 extents = glm::abs(glm::vec3(model[0])) * meshExtents.x + glm::abs(glm::vec3(model[1])) * meshExtents.y + glm::abs(glm::vec3(model[2])) * meshExtents.z;
+
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    radius[i] = meshRadius * scale;
+    extentX[i] = extents.x;
+    extentY[i] = extents.y;
+    extentZ[i] = extents.z;
+}
+
+uint32_t ObjectStore::size() const {
+    return count;
+}
+
+glm::vec3 ObjectStore::getBoundsMin(uint32_t index) const {
+    return glm::vec3(centerX[index] - extentX[index], centerY[index] - extentY[index], centerZ[index] - extentZ[index]);
+}
+
+glm::vec3 ObjectStore::getBoundsMax(uint32_t index) const {
+    return glm::vec3(centerX[index] + extentX[index], centerY[index] + extentY[index], centerZ[index] + extentZ[index]);
+}
+
+uint32_t ObjectStore::cull(const Frustum& frustum, uint32_t* pvisibleIndices) const {
+    return hasAvx2() ? cullAvx2(frustum, pvisibleIndices) : cullSse(frustum, pvisibleIndices);
+}
+
+uint32_t ObjectStore::cullScalar(const Frustum& frustum, uint32_t* pvisibleIndices) const {
+    uint32_t visibleCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (isVisible(frustum, i)) {
+            pvisibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+bool ObjectStore::isVisible(const Frustum& frustum, uint32_t i) const {
+    for (const auto& plane : frustum.planes) {
+        // Both volumes share the center: the object is outside when the center is farther than the smaller of their radii
+        float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+        float boxRadius = std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+        if (distance <= -std::min(radius[i], boxRadius)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AVX2_FUNCTION uint32_t ObjectStore::cullAvx2(const Frustum& frustum, uint32_t* pvisibleIndices) const {
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+    // 8 objects per iteration: the planes are broadcast once, each bound component is one load
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absX[p] = _mm256_set1_ps(std::abs(plane.x));
+        absY[p] = _mm256_set1_ps(std::abs(plane.y));
+        absZ[p] = _mm256_set1_ps(std::abs(plane.z));
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(&centerX[i]);
+        __m256 cy = _mm256_loadu_ps(&centerY[i]);
+        __m256 cz = _mm256_loadu_ps(&centerZ[i]);
+        __m256 r = _mm256_loadu_ps(&radius[i]);
+        __m256 ex = _mm256_loadu_ps(&extentX[i]);
+        __m256 ey = _mm256_loadu_ps(&extentY[i]);
+        __m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+            __m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)), _mm256_mul_ps(absZ[p], ez));
+            __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_min_ps(r, boxRadius));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+        }
+
+        // One bit per object, the set bits are appended in order
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(visible));
+        while (mask != 0) {
+            pvisibleIndices[visibleCount++] = i + std::countr_zero(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    // Remaining objects, fewer than a vector
+    for (; i < count; i++) {
+        if (isVisible(frustum, i)) {
+            pvisibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+uint32_t ObjectStore::cullSse(const Frustum& frustum, uint32_t* pvisibleIndices) const {
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+    // Same test 4 objects at a time with SSE
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::abs(plane.x));
+        absY[p] = _mm_set1_ps(std::abs(plane.y));
+        absZ[p] = _mm_set1_ps(std::abs(plane.z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(&centerX[i]);
+        __m128 cy = _mm_loadu_ps(&centerY[i]);
+        __m128 cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 r = _mm_loadu_ps(&radius[i]);
+        __m128 ex = _mm_loadu_ps(&extentX[i]);
+        __m128 ey = _mm_loadu_ps(&extentY[i]);
+        __m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)), _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+            __m128 negativeRadius = _mm_sub_ps(zero, _mm_min_ps(r, boxRadius));
+            visible = _mm_and_ps(visible, _mm_cmpgt_ps(distance, negativeRadius));
+        }
+
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(visible));
+        while (mask != 0) {
+            pvisibleIndices[visibleCount++] = i + std::countr_zero(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    // Remaining objects, fewer than a vector
+    for (; i < count; i++) {
+        if (isVisible(frustum, i)) {
+            pvisibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
@@ -0,0 +1,112 @@
+#include "scene/Scene.h"
+
+// Build a small demo scene: a grid of quads sharing a few materials
+void Scene::initialize(uint32_t textureIndex) {
+    const glm::vec4 tints[] = {
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        { 1.0f, 0.6f, 0.6f, 1.0f },
+        { 0.6f, 1.0f, 0.6f, 1.0f },
+        { 0.6f, 0.6f, 1.0f, 1.0f }
+    };
+    for (const auto& tint : tints) {
+        addMaterial(tint, textureIndex);
+    }
+    entities.initialize(MAX_OBJECTS);
+
+    const int gridSize = 5;
+    const float spacing = 0.5f;
+    for (int y = 0; y < gridSize; y++) {
+        for (int x = 0; x < gridSize; x++) {
+            glm::vec3 position((x - gridSize / 2) * spacing, (y - gridSize / 2) * spacing, 0.0f);
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.4f));
+            addObject(model, (x + y) % 4, 10.0f + 5.0f * ((x * gridSize + y) % 7));
+        }
+    }
+}
+
+// Generate a new transformation every frame to make the geometry spin around
+void Scene::update() {
+    //  Calculate the time in seconds since the last update with floating point accuracy
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastUpdateTime).count();
+    lastUpdateTime = currentTime;
+
+    // While paused the local transforms don't change, only the entities added or edited since the last update are processed
+    if (animating) {
+        animationTime += deltaTime;
+        for (size_t i = 0; i < rotatingEntities.size(); i++) {
+            glm::mat4 localTransform = glm::rotate(baseTransforms[i], animationTime * glm::radians(rotationSpeeds[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+            entities.setLocalTransform(rotatingEntities[i], localTransform);
+        }
+    }
+
+    entities.update();
+}
+
+// Rotate the camera around the vertical axis going through its target
+void Scene::orbitCamera(float degrees) {
+    glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(degrees), glm::vec3(0.0f, 0.0f, 1.0f));
+    cameraPosition = cameraTarget + glm::vec3(rotation * glm::vec4(cameraPosition - cameraTarget, 0.0f));
+    viewVersion++;
+}
+
+void Scene::setAnimating(bool enabled) {
+    if (enabled && !animating) {
+        lastUpdateTime = std::chrono::high_resolution_clock::now(); // Don't count the paused time
+    }
+    animating = enabled;
+}
+
+bool Scene::isAnimating() {
+    return animating;
+}
+
+uint32_t Scene::addMaterial(glm::vec4 baseColor, uint32_t textureIndex) {
+    if (materials.size() >= MAX_MATERIALS) {
+        throw std::runtime_error("failed to add material, the material table is full!");
+    }
+
+    Material material{};
+    material.baseColor = baseColor;
+    material.textureIndex = textureIndex;
+    materials.push_back(material);
+    version++;
+
+    return static_cast<uint32_t>(materials.size() - 1);
+}
+
+Entity Scene::addObject(glm::mat4 localTransform, uint32_t materialIndex, float rotationSpeed, Entity parent) {
+    if (entities.size() >= MAX_OBJECTS) {
+        throw std::runtime_error("failed to add object, the per-object buffer is full!");
+    }
+
+    Entity entity = entities.create(localTransform, materialIndex, parent);
+    if (rotationSpeed != 0.0f) {
+        rotatingEntities.push_back(entity);
+        baseTransforms.push_back(localTransform);
+        rotationSpeeds.push_back(rotationSpeed);
+    }
+    version++;
+
+    return entity;
+}
+
+glm::mat4 Scene::getViewMatrix() {
+    return glm::lookAt(cameraPosition, cameraTarget, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+uint64_t Scene::getVersion() {
+    return version;
+}
+
+uint64_t Scene::getViewVersion() {
+    return viewVersion;
+}
+
+std::vector<Material>& Scene::getMaterials() {
+    return materials;
+}
+
+EntityStore& Scene::getEntities() {
+    return entities;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "utils/AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+
+static std::atomic<uint64_t> heapAllocationCount{ 0 };
+
+uint64_t getHeapAllocationCount() {
+    return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+#ifndef NDEBUG
+
+// Replacing the plain and the aligned versions is enough: the array and nothrow versions call them by default
+
+void* operator new(std::size_t size) {
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    void* pointer = _aligned_malloc(size ? size : 1, align);
+#else
+    void* pointer = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+    if (pointer) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include "utils/CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include <cstdint>
+
+namespace {
+    void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#if defined(_MSC_VER)
+        __cpuidex(reinterpret_cast<int*>(registers), static_cast<int>(leaf), static_cast<int>(subleaf));
+#else
+        __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    uint64_t readXcr0() {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t low, high;
+        __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return (uint64_t(high) << 32) | low;
+#endif
+    }
+
+    bool detectAvx2() {
+        uint32_t registers[4]; // eax, ebx, ecx, edx
+        cpuid(0, 0, registers);
+        if (registers[0] < 7) {
+            return false;
+        }
+
+        // The OS must save the YMM registers on context switches (OSXSAVE, then the SSE and AVX state bits of XCR0)
+        cpuid(1, 0, registers);
+        bool osxsave = (registers[2] & (1u << 27)) != 0;
+        bool avx = (registers[2] & (1u << 28)) != 0;
+        if (!osxsave || !avx || (readXcr0() & 0x6) != 0x6) {
+            return false;
+        }
+
+        cpuid(7, 0, registers);
+        return (registers[1] & (1u << 5)) != 0;
+    }
+}
+
+bool hasAvx2() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
@@ -0,0 +1,168 @@
+#include "utils/CullingBenchmark.h"
+
+#ifdef VKLAB_BENCHMARKS
+
+#include "scene/ObjectStore.h"
+#include "scene/BVH.h"
+#include "utils/Benchmark.h"
+#include "utils/CpuFeatures.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace {
+    constexpr uint32_t OBJECT_COUNT = 256 * 1024;
+    constexpr uint32_t ROUNDS = 10;
+
+    // Objects culled per microsecond by the given cull function, which returns the number of visible objects
+    template <typename Function>
+    double measureCull(Function cull, uint32_t& visibleCount) {
+        return OBJECT_COUNT / (measureBestMilliseconds(ROUNDS, [&] { visibleCount = cull(); }) * 1000.0);
+    }
+
+    // Brute force references of the BVH queries, over every object of the store
+    uint32_t queryAll(const ObjectStore& store, glm::vec3 boundsMin, glm::vec3 boundsMax, uint32_t* pindices) {
+        uint32_t foundCount = 0;
+        for (uint32_t i = 0; i < store.size(); i++) {
+            glm::vec3 objectMin = store.getBoundsMin(i);
+            glm::vec3 objectMax = store.getBoundsMax(i);
+            if (objectMin.x <= boundsMax.x && objectMax.x >= boundsMin.x
+                && objectMin.y <= boundsMax.y && objectMax.y >= boundsMin.y
+                && objectMin.z <= boundsMax.z && objectMax.z >= boundsMin.z) {
+                pindices[foundCount++] = i;
+            }
+        }
+        return foundCount;
+    }
+
+    // Same slab test as the BVH, so that the hit distances are equal to the bit
+    float raycastAll(const ObjectStore& store, glm::vec3 origin, glm::vec3 direction, float maxDistance) {
+        glm::vec3 inverseDirection = 1.0f / direction;
+        float hitDistance = maxDistance;
+        for (uint32_t i = 0; i < store.size(); i++) {
+            glm::vec3 t1 = (store.getBoundsMin(i) - origin) * inverseDirection;
+            glm::vec3 t2 = (store.getBoundsMax(i) - origin) * inverseDirection;
+            glm::vec3 tNear = glm::min(t1, t2);
+            glm::vec3 tFar = glm::max(t1, t2);
+            float enter = std::max({ tNear.x, tNear.y, tNear.z, 0.0f });
+            float exit = std::min({ tFar.x, tFar.y, tFar.z, hitDistance });
+            if (enter <= exit && enter < hitDistance) {
+                hitDistance = enter;
+            }
+        }
+        return hitDistance;
+    }
+}
+
+void runCullingBenchmark() {
+    // Unit quads scattered in a 200 m cube around a camera looking down -Z: roughly a tenth of them is in the frustum
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    std::vector<glm::mat4> transforms(OBJECT_COUNT);
+    for (auto& transform : transforms) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+        model = glm::rotate(model, angle(random), glm::vec3(0.0f, 1.0f, 0.0f));
+        transform = glm::scale(model, glm::vec3(scale(random)));
+    }
+
+    ObjectStore store;
+    store.initialize(OBJECT_COUNT);
+    store.setMeshBounds(glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.5f, 0.5f, 0.0f));
+    store.update(transforms);
+
+    glm::mat4 proj = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    proj[1][1] *= -1;
+    Frustum frustum = Frustum::fromViewProjection(proj * glm::mat4(1.0f));
+    std::vector<uint32_t> visibleIndices(OBJECT_COUNT);
+
+    uint32_t scalarVisible = 0, simdVisible = 0;
+    double scalarRate = measureCull([&] { return store.cullScalar(frustum, visibleIndices.data()); }, scalarVisible);
+    double simdRate = measureCull([&] { return store.cull(frustum, visibleIndices.data()); }, simdVisible);
+
+    std::cout << "Culling benchmark (" << OBJECT_COUNT << " objects, " << scalarVisible << " visible, best of " << ROUNDS << "): scalar "
+        << scalarRate << " objects/us, SIMD " << simdRate << " objects/us (" << (hasAvx2() ? "AVX2" : "SSE") << ")" << std::endl;
+    if (simdVisible != scalarVisible) {
+        std::cout << "Culling benchmark: the SIMD results differ from the scalar reference (" << simdVisible << ")" << std::endl;
+    }
+
+    // Hierarchical culling: the cost of the tree upkeep is paid every frame the objects move
+    BVH bvh;
+    bvh.initialize(&store, OBJECT_COUNT);
+    double buildTime = measureBestMilliseconds(ROUNDS, [&] { bvh.build(); });
+    double refitTime = measureBestMilliseconds(ROUNDS, [&] { bvh.refit(); });
+
+    uint32_t bvhVisible = 0;
+    double bvhRate = measureCull([&] { return bvh.cull(frustum, visibleIndices.data()); }, bvhVisible);
+
+    // A tenth of the objects jump somewhere else: incremental refit of their paths, then the loss of culling speed
+    std::vector<uint32_t> movedObjects;
+    for (uint32_t i = 0; i < OBJECT_COUNT; i += 10) {
+        transforms[i][3] = glm::vec4(position(random), position(random), position(random), 1.0f);
+        movedObjects.push_back(i);
+    }
+    store.update(transforms, movedObjects);
+    double incrementalRefitTime = measureBestMilliseconds(1, [&] { bvh.refit(movedObjects); });
+
+    uint32_t movedVisible = 0;
+    double refittedRate = measureCull([&] { return bvh.cull(frustum, visibleIndices.data()); }, movedVisible);
+    bool degraded = bvh.isDegraded();
+    bvh.build();
+    double rebuiltRate = measureCull([&] { return bvh.cull(frustum, visibleIndices.data()); }, movedVisible);
+
+    std::cout << "Culling benchmark, BVH (" << bvh.getNodeCount() << " nodes): build " << buildTime << " ms, refit " << refitTime
+        << " ms, cull " << bvhRate << " objects/us (" << bvhRate / simdRate << "x SIMD brute force)" << std::endl;
+    std::cout << "Culling benchmark, BVH after moving " << movedObjects.size() << " objects: incremental refit " << incrementalRefitTime
+        << " ms, cull " << refittedRate << " objects/us refitted" << (degraded ? " (degraded)" : "") << ", " << rebuiltRate << " objects/us rebuilt" << std::endl;
+    if (bvhVisible != scalarVisible) {
+        std::cout << "Culling benchmark: the BVH results differ from the scalar reference (" << bvhVisible << ")" << std::endl;
+    }
+
+    // Range queries and picking rays against the brute force references: same objects, same closest hit
+    constexpr uint32_t QUERY_COUNT = 64;
+    constexpr float RAY_LENGTH = 400.0f;
+    std::uniform_real_distribution<float> boxSize(1.0f, 20.0f);
+    std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+    std::vector<uint32_t> referenceIndices(OBJECT_COUNT);
+    uint32_t queryMismatches = 0, rayMismatches = 0, rayHits = 0;
+    double queryTime = 0.0, queryAllTime = 0.0, rayTime = 0.0, rayAllTime = 0.0;
+
+    for (uint32_t query = 0; query < QUERY_COUNT; query++) {
+        glm::vec3 boundsMin(position(random), position(random), position(random));
+        glm::vec3 boundsMax = boundsMin + glm::vec3(boxSize(random));
+        uint32_t foundCount = 0, referenceCount = 0;
+        queryTime += measureBestMilliseconds(1, [&] { foundCount = bvh.query(boundsMin, boundsMax, visibleIndices.data(), OBJECT_COUNT); });
+        queryAllTime += measureBestMilliseconds(1, [&] { referenceCount = queryAll(store, boundsMin, boundsMax, referenceIndices.data()); });
+        std::sort(visibleIndices.begin(), visibleIndices.begin() + foundCount);
+        if (foundCount != referenceCount || !std::equal(visibleIndices.begin(), visibleIndices.begin() + foundCount, referenceIndices.begin())) {
+            queryMismatches++;
+        }
+
+        // From outside the scene toward a random point of it
+        glm::vec3 origin = glm::normalize(glm::vec3(axis(random), axis(random), axis(random))) * 180.0f;
+        glm::vec3 direction = glm::normalize(glm::vec3(position(random), position(random), position(random)) - origin);
+        float hitDistance = 0.0f, referenceDistance = 0.0f;
+        uint32_t hitObject = BVH::NO_HIT;
+        rayTime += measureBestMilliseconds(1, [&] { hitObject = bvh.raycast(origin, direction, RAY_LENGTH, hitDistance); });
+        rayAllTime += measureBestMilliseconds(1, [&] { referenceDistance = raycastAll(store, origin, direction, RAY_LENGTH); });
+        rayHits += hitObject != BVH::NO_HIT;
+        if (hitDistance != referenceDistance || (hitObject != BVH::NO_HIT) != (referenceDistance < RAY_LENGTH)) {
+            rayMismatches++;
+        }
+    }
+
+    std::cout << "Culling benchmark, BVH queries (" << QUERY_COUNT << " of each): range query " << queryTime / QUERY_COUNT * 1000.0
+        << " us (" << queryAllTime / queryTime << "x faster than brute force), raycast " << rayTime / QUERY_COUNT * 1000.0 << " us ("
+        << rayAllTime / rayTime << "x faster, " << rayHits << " hits)" << std::endl;
+    if (queryMismatches != 0 || rayMismatches != 0) {
+        std::cout << "Culling benchmark: the BVH queries differ from the brute force references (" << queryMismatches << " range queries, "
+            << rayMismatches << " rays)" << std::endl;
+    }
+}
+
+#endif
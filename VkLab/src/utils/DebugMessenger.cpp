@@ -1,19 +1,24 @@
 #include "utils/DebugMessenger.h"
+#include "core/HostAllocator.h"
+#include "core/RendererContext.h"
+#include "utils/ValidationMessageSink.h"
 
 DebugMessenger::DebugMessenger() : debugMessenger(VK_NULL_HANDLE) {}
 
 // Setup and create the debug messenger
-void DebugMessenger::initialize(VkInstance instance) {
+void DebugMessenger::initialize(VkInstance instance, const InstanceDispatch* pdispatch) {
+    this->pdispatch = pdispatch;
+
     VkDebugUtilsMessengerCreateInfoEXT createInfo;
     populateDebugMessengerCreateInfo(createInfo);
 
-    if (createDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+    if (createDebugUtilsMessengerEXT(instance, &createInfo, getAllocationCallbacks(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT), &debugMessenger) != VK_SUCCESS) {
         throw std::runtime_error("failed to set up debug messenger!");
     }
 }
 
 void DebugMessenger::cleanup(VkInstance instance) {
-    destroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+    destroyDebugUtilsMessengerEXT(instance, debugMessenger, getAllocationCallbacks(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
 }
 
 // Creates a Vulkan debug messenger if the extension is available.
@@ -22,9 +27,9 @@ VkResult DebugMessenger::createDebugUtilsMessengerEXT(
     const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
     const VkAllocationCallbacks* pAllocator,
     VkDebugUtilsMessengerEXT* pDebugMessenger) {
-    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-    if (func != nullptr) {
-        return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+    // Null if VK_EXT_debug_utils is not enabled
+    if (pdispatch->vkCreateDebugUtilsMessengerEXT != nullptr) {
+        return pdispatch->vkCreateDebugUtilsMessengerEXT(instance, pCreateInfo, pAllocator, pDebugMessenger);
     }
     else {
         return VK_ERROR_EXTENSION_NOT_PRESENT;
@@ -36,9 +41,8 @@ void DebugMessenger::destroyDebugUtilsMessengerEXT(
     VkInstance instance,
     VkDebugUtilsMessengerEXT debugMessenger,
     const VkAllocationCallbacks* pAllocator) {
-    auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-    if (func != nullptr) {
-        func(instance, debugMessenger, pAllocator);
+    if (pdispatch != nullptr && pdispatch->vkDestroyDebugUtilsMessengerEXT != nullptr) {
+        pdispatch->vkDestroyDebugUtilsMessengerEXT(instance, debugMessenger, pAllocator);
     }
 }
 
@@ -53,6 +57,7 @@ void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& create
         VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
         VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
     createInfo.pfnUserCallback = debugCallback;
+    createInfo.pUserData = RendererContext::getInstance().pvalidationsink; // Also used by the messenger of the instance creation
 }
 
 // This function is a callback for handling validation layer messages from Vulkan
@@ -62,6 +67,13 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData) {
 
+    // Called from inside the Vulkan call that triggered the message: queue it and return quickly when the sink is running
+    auto psink = static_cast<ValidationMessageSink*>(pUserData);
+    if (psink != nullptr) {
+        psink->push(messageSeverity, messageType, pCallbackData);
+        return VK_FALSE;
+    }
+
     std::cerr << "[Validation Layer]:[" << messageType << "]: " << pCallbackData->pMessage << std::endl;
 
     return VK_FALSE;
@@ -0,0 +1,60 @@
+#include "utils/DispatchBenchmark.h"
+
+#ifdef VKLAB_BENCHMARKS
+
+#include "utils/Benchmark.h"
+
+#include <iostream>
+
+namespace {
+    constexpr uint32_t CALLS_PER_ROUND = 100000;
+    constexpr uint32_t ROUNDS = 5;
+
+    // Nanoseconds per call of vkCmdSetScissor through the given entry point, the command buffer must be recording
+    template <typename Function>
+    double measureCalls(VkCommandBuffer commandBuffer, Function setScissor) {
+        VkRect2D scissor{ { 0, 0 }, { 1, 1 } };
+        double best = measureBestMilliseconds(ROUNDS, [&] {
+            for (uint32_t i = 0; i < CALLS_PER_ROUND; i++) {
+                scissor.extent.width = 1 + (i & 1); // Don't let the driver ignore identical calls
+                setScissor(commandBuffer, 0, 1, &scissor);
+            }
+        });
+        return best * 1e6 / CALLS_PER_ROUND;
+    }
+}
+
+void runDispatchBenchmark(CommandPools* pcommandPools) {
+    auto pdevice = RendererContext::getInstance().pdevice;
+    VkDevice logicalDevice = pdevice->getLogicalDevice();
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = pcommandPools->getDrawCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate benchmark command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    // Through a function pointer in both cases, so the only difference is the target: trampoline or driver
+    PFN_vkCmdSetScissor trampoline = vkCmdSetScissor;
+    PFN_vkCmdSetScissor direct = pdevice->getDispatch().vkCmdSetScissor;
+    double trampolineTime = measureCalls(commandBuffer, trampoline);
+    double directTime = measureCalls(commandBuffer, direct);
+
+    vkEndCommandBuffer(commandBuffer);
+    vkFreeCommandBuffers(logicalDevice, pcommandPools->getDrawCommandPool(), 1, &commandBuffer);
+
+    std::cout << "Dispatch benchmark (vkCmdSetScissor, best of " << ROUNDS << " x " << CALLS_PER_ROUND << " calls): loader "
+        << trampolineTime << " ns/call, dispatch table " << directTime << " ns/call, saving " << trampolineTime - directTime << " ns/call" << std::endl;
+}
+
+#endif
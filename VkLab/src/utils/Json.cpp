@@ -0,0 +1,281 @@
+#include "utils/Json.h"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    const JsonValue nullValue;
+    const std::string emptyString;
+}
+
+// Recursive descent over the text, the position only moves forward
+class JsonValue::Parser
+{
+public:
+    explicit Parser(std::string_view text) : text(text) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue(0);
+        skipWhitespace();
+        if (position != text.size()) {
+            fail();
+        }
+        return value;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 256; // Nested arrays and objects, guards the stack against hostile files
+
+    [[noreturn]] void fail() {
+        throw std::runtime_error("failed to parse JSON at offset " + std::to_string(position) + "!");
+    }
+
+    void skipWhitespace() {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+            position++;
+        }
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (position >= text.size() || text[position] != c) {
+            fail();
+        }
+        position++;
+    }
+
+    // Comma between the elements of an array or the members of an object
+    bool consumeSeparator() {
+        skipWhitespace();
+        if (position < text.size() && text[position] == ',') {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(std::string_view literal) {
+        if (text.substr(position, literal.size()) == literal) {
+            position += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue(int depth) {
+        if (depth > MAX_DEPTH) {
+            fail();
+        }
+        skipWhitespace();
+        if (position >= text.size()) {
+            fail();
+        }
+
+        JsonValue value;
+        char c = text[position];
+        if (c == '{') {
+            value.type = Type::Object;
+            position++;
+            skipWhitespace();
+            if (position < text.size() && text[position] == '}') {
+                position++;
+                return value;
+            }
+            while (true) {
+                skipWhitespace();
+                std::string key = parseString();
+                expect(':');
+                value.members.emplace_back(std::move(key), parseValue(depth + 1));
+                if (!consumeSeparator()) {
+                    break;
+                }
+            }
+            expect('}');
+        }
+        else if (c == '[') {
+            value.type = Type::Array;
+            position++;
+            skipWhitespace();
+            if (position < text.size() && text[position] == ']') {
+                position++;
+                return value;
+            }
+            while (true) {
+                value.elements.push_back(parseValue(depth + 1));
+                if (!consumeSeparator()) {
+                    break;
+                }
+            }
+            expect(']');
+        }
+        else if (c == '"') {
+            value.type = Type::String;
+            value.string = parseString();
+        }
+        else if (consumeLiteral("true")) {
+            value.type = Type::Bool;
+            value.boolean = true;
+        }
+        else if (consumeLiteral("false")) {
+            value.type = Type::Bool;
+        }
+        else if (consumeLiteral("null")) {
+            value.type = Type::Null;
+        }
+        else {
+            // from_chars also reads "inf" and "nan", which are not JSON numbers
+            if (c != '-' && (c < '0' || c > '9')) {
+                fail();
+            }
+            value.type = Type::Number;
+            auto result = std::from_chars(text.data() + position, text.data() + text.size(), value.number);
+            if (result.ec != std::errc() || !std::isfinite(value.number)) {
+                fail();
+            }
+            position = result.ptr - text.data();
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        if (position >= text.size() || text[position] != '"') {
+            fail();
+        }
+        position++;
+
+        std::string result;
+        while (position < text.size() && text[position] != '"') {
+            char c = text[position++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (position >= text.size()) {
+                fail();
+            }
+            char escape = text[position++];
+            switch (escape) {
+            case '"': result += '"'; break;
+            case '\\': result += '\\'; break;
+            case '/': result += '/'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u': appendCodePoint(result, parseHex4()); break;
+            default: fail();
+            }
+        }
+        if (position >= text.size()) {
+            fail();
+        }
+        position++; // Closing quote
+        return result;
+    }
+
+    uint32_t parseHex4() {
+        if (position + 4 > text.size()) {
+            fail();
+        }
+        uint32_t codePoint = 0;
+        auto result = std::from_chars(text.data() + position, text.data() + position + 4, codePoint, 16);
+        if (result.ptr != text.data() + position + 4) {
+            fail();
+        }
+        position += 4;
+        return codePoint;
+    }
+
+    // UTF-8 encoding of \uXXXX, surrogate pairs are combined and a lone surrogate is an error
+    void appendCodePoint(std::string& result, uint32_t codePoint) {
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+            if (!consumeLiteral("\\u")) {
+                fail();
+            }
+            uint32_t low = parseHex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+                fail();
+            }
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+            fail();
+        }
+        if (codePoint < 0x80) {
+            result += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            result += static_cast<char>(0xC0 | (codePoint >> 6));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            result += static_cast<char>(0xE0 | (codePoint >> 12));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            result += static_cast<char>(0xF0 | (codePoint >> 18));
+            result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    std::string_view text;
+    size_t position = 0;
+};
+
+JsonValue JsonValue::parse(std::string_view text) {
+    return Parser(text).parseDocument();
+}
+
+JsonValue::Type JsonValue::getType() const {
+    return type;
+}
+
+bool JsonValue::isNull() const {
+    return type == Type::Null;
+}
+
+bool JsonValue::getBool(bool defaultValue) const {
+    return type == Type::Bool ? boolean : defaultValue;
+}
+
+double JsonValue::getNumber(double defaultValue) const {
+    return type == Type::Number ? number : defaultValue;
+}
+
+// The cast is only defined for the whole numbers that fit, a malformed index or count falls back to the default
+uint32_t JsonValue::getUint(uint32_t defaultValue) const {
+    bool representable = type == Type::Number && std::isfinite(number) && number >= 0.0 && number < 4294967296.0 && number == std::floor(number);
+    return representable ? static_cast<uint32_t>(number) : defaultValue;
+}
+
+const std::string& JsonValue::getString() const {
+    return type == Type::String ? string : emptyString;
+}
+
+size_t JsonValue::size() const {
+    return type == Type::Array ? elements.size() : 0;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    return type == Type::Array && index < elements.size() ? elements[index] : nullValue;
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const {
+    if (type == Type::Object) {
+        for (const auto& member : members) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+    }
+    return nullValue;
+}
+
+bool JsonValue::contains(std::string_view key) const {
+    return !(*this)[key].isNull();
+}
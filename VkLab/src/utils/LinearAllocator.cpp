@@ -0,0 +1,48 @@
+#include "utils/LinearAllocator.h"
+
+#include <algorithm>
+
+void LinearAllocator::initialize(size_t size) {
+    memory = std::make_unique<std::byte[]>(size);
+    capacity = size;
+    offset = 0;
+    highWaterMark = 0;
+}
+
+void LinearAllocator::cleanup() {
+    memory.reset();
+    capacity = 0;
+    offset = 0;
+}
+
+// Alignment must be a power of two
+void* LinearAllocator::allocate(size_t size, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(memory.get());
+    uintptr_t aligned = (base + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    size_t newOffset = static_cast<size_t>(aligned - base) + size;
+
+    // Growing would invalidate the previous allocations of the frame: the capacity must be raised instead (see FRAME_ARENA_SIZE)
+    if (newOffset > capacity) {
+        throw std::runtime_error("failed to allocate transient memory, the frame arena is full!");
+    }
+
+    offset = newOffset;
+    highWaterMark = std::max(highWaterMark, offset);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void LinearAllocator::reset() {
+    offset = 0;
+}
+
+size_t LinearAllocator::getUsed() const {
+    return offset;
+}
+
+size_t LinearAllocator::getCapacity() const {
+    return capacity;
+}
+
+size_t LinearAllocator::getHighWaterMark() const {
+    return highWaterMark;
+}
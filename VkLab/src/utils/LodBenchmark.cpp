@@ -0,0 +1,82 @@
+#include "utils/LodBenchmark.h"
+
+#ifdef VKLAB_BENCHMARKS
+
+#include <iostream>
+
+namespace {
+    constexpr uint32_t WARMUP_FRAMES = 2 * MAX_FRAMES_IN_FLIGHT + 8; // Read after a switch before the measure starts
+    constexpr uint32_t MEASURED_FRAMES = 300;
+
+    struct LodBenchmarkState {
+        uint32_t setting = 0; // 0 LODs off, 1 LODs on, 2 done
+        bool started = false;
+        bool warm = false;
+        Profiler::Throughput mark; // Totals of the Profiler at the start of the warm-up or of the measure
+        Profiler::Throughput results[2];
+    };
+    LodBenchmarkState state;
+
+    void printResult(const char* name, const Profiler::Throughput& result) {
+        std::cout << "  LODs " << name << ": " << result.primitives / result.frameCount << " primitives per frame, "
+            << result.gpuTime / result.frameCount * 1000.0 << " ms of GPU time per frame, "
+            << result.primitives / result.gpuTime * 1e-6 << " M primitives/s" << std::endl;
+    }
+}
+
+bool updateLodBenchmark(LodSelector& lodSelector, const Profiler& profiler) {
+    if (state.setting == 2) {
+        return false;
+    }
+    if (!profiler.isThroughputSupported()) {
+        std::cout << "LOD benchmark: skipped, the device lacks timestamps or pipeline statistics" << std::endl;
+        state.setting = 2;
+        return false;
+    }
+
+    const Profiler::Throughput& total = profiler.getThroughput();
+    if (!state.started) {
+        state.started = true;
+        lodSelector.setEnabled(false);
+        state.mark = total;
+        return true;
+    }
+
+    uint32_t frameCount = total.frameCount - state.mark.frameCount;
+    if (!state.warm) {
+        if (frameCount >= WARMUP_FRAMES) {
+            state.warm = true;
+            state.mark = total;
+        }
+        return true;
+    }
+    if (frameCount < MEASURED_FRAMES) {
+        return true;
+    }
+
+    Profiler::Throughput& result = state.results[state.setting];
+    result.frameCount = frameCount;
+    result.gpuTime = total.gpuTime - state.mark.gpuTime;
+    result.primitives = total.primitives - state.mark.primitives;
+
+    if (state.setting == 0) {
+        state.setting = 1;
+        state.warm = false;
+        state.mark = total;
+        lodSelector.setEnabled(true);
+        return true;
+    }
+
+    state.setting = 2;
+    lodSelector.setEnabled(START_WITH_LODS);
+    const Profiler::Throughput& off = state.results[0];
+    const Profiler::Throughput& on = state.results[1];
+    std::cout << "LOD benchmark (" << MEASURED_FRAMES << " frames each):" << std::endl;
+    printResult("off", off);
+    printResult("on", on);
+    std::cout << "  " << static_cast<double>(off.primitives) / on.primitives << "x fewer primitives, GPU time per frame x"
+        << (on.gpuTime / on.frameCount) / (off.gpuTime / off.frameCount) << std::endl;
+    return false;
+}
+
+#endif // VKLAB_BENCHMARKS
@@ -0,0 +1,125 @@
+#include "utils/MeshImportBenchmark.h"
+
+#ifdef VKLAB_BENCHMARKS
+
+#include "scene/MeshImporter.h"
+#include "utils/Benchmark.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+    constexpr uint32_t GRID_SIZE = 708; // Quads per side: 2 * 708 * 708 = 1 002 528 triangles
+    constexpr uint32_t ROUNDS = 3;
+
+    uint32_t gridVertexIndex(uint32_t x, uint32_t y) {
+        return y * (GRID_SIZE + 1) + x;
+    }
+
+    // Slightly bumped grid, so that the normals differ between vertices and the deduplication has work to do
+    void writeObj(const std::string& filename) {
+        std::ofstream file(filename);
+        for (uint32_t y = 0; y <= GRID_SIZE; y++) {
+            for (uint32_t x = 0; x <= GRID_SIZE; x++) {
+                float height = ((x * 7 + y * 13) % 17) * 0.01f;
+                file << "v " << x * 0.01f << ' ' << y * 0.01f << ' ' << height << '\n';
+                file << "vt " << x / float(GRID_SIZE) << ' ' << y / float(GRID_SIZE) << '\n';
+            }
+        }
+        file << "vn 0 0 1\n";
+        for (uint32_t y = 0; y < GRID_SIZE; y++) {
+            for (uint32_t x = 0; x < GRID_SIZE; x++) {
+                uint32_t a = gridVertexIndex(x, y) + 1, b = gridVertexIndex(x + 1, y) + 1;
+                uint32_t c = gridVertexIndex(x + 1, y + 1) + 1, d = gridVertexIndex(x, y + 1) + 1;
+                file << "f " << a << '/' << a << "/1 " << b << '/' << b << "/1 " << c << '/' << c << "/1 " << d << '/' << d << "/1\n";
+            }
+        }
+    }
+
+    void writeGlb(const std::string& filename) {
+        uint32_t vertexCount = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+        uint32_t indexCount = GRID_SIZE * GRID_SIZE * 6;
+
+        // BIN chunk: positions, texture coordinates, then 32-bit indices
+        std::vector<char> bin(size_t(vertexCount) * 20 + size_t(indexCount) * 4);
+        float* ppositions = reinterpret_cast<float*>(bin.data());
+        float* ptexCoords = ppositions + size_t(vertexCount) * 3;
+        uint32_t* pindices = reinterpret_cast<uint32_t*>(ptexCoords + size_t(vertexCount) * 2);
+        for (uint32_t y = 0; y <= GRID_SIZE; y++) {
+            for (uint32_t x = 0; x <= GRID_SIZE; x++) {
+                uint32_t v = gridVertexIndex(x, y);
+                ppositions[v * 3] = x * 0.01f;
+                ppositions[v * 3 + 1] = y * 0.01f;
+                ppositions[v * 3 + 2] = ((x * 7 + y * 13) % 17) * 0.01f;
+                ptexCoords[v * 2] = x / float(GRID_SIZE);
+                ptexCoords[v * 2 + 1] = y / float(GRID_SIZE);
+            }
+        }
+        for (uint32_t y = 0; y < GRID_SIZE; y++) {
+            for (uint32_t x = 0; x < GRID_SIZE; x++) {
+                uint32_t quad[6] = { gridVertexIndex(x, y), gridVertexIndex(x + 1, y), gridVertexIndex(x + 1, y + 1),
+                    gridVertexIndex(x + 1, y + 1), gridVertexIndex(x, y + 1), gridVertexIndex(x, y) };
+                memcpy(pindices + size_t(y * GRID_SIZE + x) * 6, quad, sizeof(quad));
+            }
+        }
+
+        std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1},\"indices\":2}]}],"
+            "\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}],"
+            "\"bufferViews\":["
+            "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(vertexCount * 12) + "},"
+            "{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexCount * 12) + ",\"byteLength\":" + std::to_string(vertexCount * 8) + "},"
+            "{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexCount * 20) + ",\"byteLength\":" + std::to_string(indexCount * 4) + "}],"
+            "\"accessors\":["
+            "{\"bufferView\":0,\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC3\"},"
+            "{\"bufferView\":1,\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC2\"},"
+            "{\"bufferView\":2,\"componentType\":5125,\"count\":" + std::to_string(indexCount) + ",\"type\":\"SCALAR\"}]}";
+        json.resize((json.size() + 3) & ~size_t(3), ' '); // Chunks are 4-byte aligned
+
+        auto writeUint = [](std::ofstream& file, uint32_t value) { file.write(reinterpret_cast<const char*>(&value), 4); };
+        std::ofstream file(filename, std::ios::binary);
+        writeUint(file, 0x46546C67); // "glTF"
+        writeUint(file, 2);
+        writeUint(file, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()));
+        writeUint(file, static_cast<uint32_t>(json.size()));
+        writeUint(file, 0x4E4F534A); // "JSON"
+        file.write(json.data(), json.size());
+        writeUint(file, static_cast<uint32_t>(bin.size()));
+        writeUint(file, 0x004E4942); // "BIN"
+        file.write(bin.data(), bin.size());
+    }
+
+    // Best import time in milliseconds, the triangle count of the mesh is returned in triangleCount
+    double measureImport(const std::string& filename, ThreadPool* pthreadPool, size_t& triangleCount) {
+        return measureBestMilliseconds(ROUNDS, [&] {
+            MeshData mesh = MeshImporter::load(filename, pthreadPool);
+            triangleCount = mesh.indices.size() / 3;
+        });
+    }
+}
+
+void runMeshImportBenchmark(ThreadPool* pthreadPool) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string objFile = (directory / "vklab_import_benchmark.obj").string();
+    std::string glbFile = (directory / "vklab_import_benchmark.glb").string();
+    writeObj(objFile);
+    writeGlb(glbFile);
+
+    std::cout << "Mesh import benchmark (" << pthreadPool->getWorkerCount() << " workers):" << std::endl;
+    for (const std::string& filename : { objFile, glbFile }) {
+        size_t triangleCount = 0;
+        double singleThread = measureImport(filename, nullptr, triangleCount);
+        double pool = measureImport(filename, pthreadPool, triangleCount);
+        std::cout << "  " << std::filesystem::path(filename).extension().string() << ", " << triangleCount << " triangles: "
+            << singleThread << " ms on one thread (" << triangleCount / singleThread / 1000.0 << " Mtri/s), "
+            << pool << " ms with the pool (" << triangleCount / pool / 1000.0 << " Mtri/s)" << std::endl;
+    }
+
+    std::filesystem::remove(objFile);
+    std::filesystem::remove(glbFile);
+}
+
+#endif // VKLAB_BENCHMARKS
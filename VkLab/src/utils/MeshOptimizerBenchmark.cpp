@@ -0,0 +1,116 @@
+#include "utils/MeshOptimizerBenchmark.h"
+
+#ifdef VKLAB_BENCHMARKS
+
+#include "scene/MeshOptimizer.h"
+#include "utils/Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <tuple>
+
+namespace {
+    constexpr uint32_t GRID_SIZE = 256; // Quads per side: 131 072 triangles
+
+    using Triangle = std::array<float, 9>; // Positions of the 3 corners
+
+    // The triangles of the mesh by the positions of their corners, each one rotated to start at its smallest corner so
+    // that the winding is kept, then sorted: two meshes draw the same triangles when their lists are equal
+    std::vector<Triangle> getTriangles(const MeshData& mesh) {
+        std::vector<Triangle> triangles(mesh.indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); t++) {
+            std::array<glm::vec3, 3> corners;
+            for (int c = 0; c < 3; c++) {
+                corners[c] = mesh.vertices[mesh.indices[t * 3 + c]].pos;
+            }
+            auto less = [](const glm::vec3& a, const glm::vec3& b) {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            };
+            std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end(), less), corners.end());
+            for (int c = 0; c < 3; c++) {
+                triangles[t][c * 3] = corners[c].x;
+                triangles[t][c * 3 + 1] = corners[c].y;
+                triangles[t][c * 3 + 2] = corners[c].z;
+            }
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Grid in the XY plane with its vertices and triangles in random order, the worst case for the vertex cache
+    MeshData createShuffledGrid() {
+        std::mt19937 random(7);
+        uint32_t vertexCount = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+        std::vector<uint32_t> vertexOrder(vertexCount);
+        std::iota(vertexOrder.begin(), vertexOrder.end(), 0u);
+        std::shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+
+        MeshData mesh;
+        mesh.vertices.resize(vertexCount);
+        for (uint32_t y = 0; y <= GRID_SIZE; y++) {
+            for (uint32_t x = 0; x <= GRID_SIZE; x++) {
+                Vertex& vertex = mesh.vertices[vertexOrder[y * (GRID_SIZE + 1) + x]];
+                vertex.pos = glm::vec3(x * 0.01f, y * 0.01f, 0.0f);
+                vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                vertex.texCoord = glm::vec2(x / float(GRID_SIZE), y / float(GRID_SIZE));
+                vertex.color = glm::vec3(1.0f);
+            }
+        }
+
+        std::vector<std::array<uint32_t, 3>> triangles;
+        triangles.reserve(size_t(GRID_SIZE) * GRID_SIZE * 2);
+        auto index = [&](uint32_t x, uint32_t y) { return vertexOrder[y * (GRID_SIZE + 1) + x]; };
+        for (uint32_t y = 0; y < GRID_SIZE; y++) {
+            for (uint32_t x = 0; x < GRID_SIZE; x++) {
+                triangles.push_back({ index(x, y), index(x + 1, y), index(x + 1, y + 1) });
+                triangles.push_back({ index(x + 1, y + 1), index(x, y + 1), index(x, y) });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), random);
+        for (const auto& triangle : triangles) {
+            mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+        }
+        mesh.computeBounds();
+        return mesh;
+    }
+}
+
+void runMeshOptimizerBenchmark() {
+    MeshData mesh = createShuffledGrid();
+    std::vector<Triangle> triangles = getTriangles(mesh);
+    VertexCacheStatistics before = MeshOptimizer::analyzeVertexCache(mesh);
+
+    // The passes one at a time on copies, then the whole optimization on the mesh itself
+    std::vector<uint32_t> clusterStarts;
+    MeshData cacheOptimized;
+    double cacheTime = measureBestMilliseconds(1, [&] {
+        cacheOptimized = mesh;
+        MeshOptimizer::optimizeVertexCache(cacheOptimized, &clusterStarts);
+    });
+    VertexCacheStatistics afterCache = MeshOptimizer::analyzeVertexCache(cacheOptimized);
+    double overdrawTime = measureBestMilliseconds(1, [&] { MeshOptimizer::optimizeOverdraw(cacheOptimized, clusterStarts); });
+    double fetchTime = measureBestMilliseconds(1, [&] { MeshOptimizer::optimizeVertexFetch(cacheOptimized); });
+
+    MeshOptimizer::optimize(mesh);
+    VertexCacheStatistics after = MeshOptimizer::analyzeVertexCache(mesh);
+
+    std::cout << "Mesh optimizer benchmark (" << triangles.size() << " shuffled triangles, " << MeshOptimizer::VERTEX_CACHE_SIZE
+        << " cache entries): ACMR " << before.acmr << " -> " << afterCache.acmr << " after the vertex cache pass (" << cacheTime
+        << " ms), " << after.acmr << " after the overdraw (" << overdrawTime << " ms) and vertex fetch (" << fetchTime
+        << " ms) passes, ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+
+    if (getTriangles(mesh) != triangles || getTriangles(cacheOptimized) != triangles) {
+        std::cout << "Mesh optimizer benchmark: the optimized mesh doesn't draw the same triangles" << std::endl;
+    }
+    if (mesh.vertices.size() != size_t(GRID_SIZE + 1) * (GRID_SIZE + 1)) {
+        std::cout << "Mesh optimizer benchmark: the optimized mesh has " << mesh.vertices.size() << " vertices" << std::endl;
+    }
+    if (!(afterCache.acmr < before.acmr) || !(after.acmr < before.acmr)) {
+        std::cout << "Mesh optimizer benchmark: the ACMR didn't improve" << std::endl;
+    }
+}
+
+#endif // VKLAB_BENCHMARKS
@@ -0,0 +1,215 @@
+#include "utils/Profiler.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <vector>
+
+// CPU time used by the process so far (user + kernel), in seconds
+static double getProcessCpuTime() {
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+    auto toSeconds = [](const FILETIME& time) {
+        ULARGE_INTEGER value;
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) * 1e-7; // 100 ns units
+    };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+void Profiler::initialize() {
+    auto& context = RendererContext::getInstance();
+
+    intervalStart = std::chrono::steady_clock::now();
+    intervalCpuStart = getProcessCpuTime();
+
+    // Pipeline statistics are an optional device feature (see Device::createLogicalDevice)
+    statisticsSupported = context.pdevice->getEnabledFeatures().pipelineStatisticsQuery;
+    if (statisticsSupported) {
+        VkQueryPoolCreateInfo statisticsPoolInfo{};
+        statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT;
+        statisticsPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        if (vkCreateQueryPool(context.pdevice->getLogicalDevice(), &statisticsPoolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL), &statisticsQueryPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline statistics query pool!");
+        }
+    }
+
+    // Timestamps must be supported by the graphics queue family
+    const VkPhysicalDeviceProperties& deviceProperties = context.pdevice->getProperties();
+    const auto& queueFamilies = context.pdevice->getQueueFamilyProperties();
+
+    uint32_t validBits = queueFamilies[context.pdevice->getQueueFamilyIndices().graphicsFamily.value()].timestampValidBits;
+    timestampsSupported = deviceProperties.limits.timestampComputeAndGraphics && validBits > 0;
+    if (!timestampsSupported) {
+        std::cout << "Profiler: timestamps not supported, GPU usage won't be reported.\n";
+        return;
+    }
+    timestampPeriod = deviceProperties.limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = QUERIES_PER_FRAME * MAX_FRAMES_IN_FLIGHT; // Each frame in flight has its own pair
+
+    if (vkCreateQueryPool(context.pdevice->getLogicalDevice(), &queryPoolInfo, getAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL), &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+void Profiler::cleanup() {
+    if (statisticsQueryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(RendererContext::getInstance().pdevice->getLogicalDevice(), statisticsQueryPool, getAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL));
+        statisticsQueryPool = VK_NULL_HANDLE;
+    }
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(RendererContext::getInstance().pdevice->getLogicalDevice(), queryPool, getAllocationCallbacks(VK_OBJECT_TYPE_QUERY_POOL));
+        queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void Profiler::cmdBeginFrame(VkCommandBuffer commandBuffer, uint32_t currentFrame) {
+    // Queries must be reset before being written again, the reset is part of the command buffer so a reused one stays valid
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+    if (timestampsSupported) {
+        vkd.vkCmdResetQueryPool(commandBuffer, queryPool, currentFrame * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+        vkd.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentFrame * QUERIES_PER_FRAME);
+    }
+    if (statisticsSupported) {
+        // Begun outside of the render pass, so the query covers every subpass and draw of the frame
+        vkd.vkCmdResetQueryPool(commandBuffer, statisticsQueryPool, currentFrame, 1);
+        vkd.vkCmdBeginQuery(commandBuffer, statisticsQueryPool, currentFrame, 0);
+    }
+}
+
+void Profiler::cmdEndFrame(VkCommandBuffer commandBuffer, uint32_t currentFrame) {
+    const DeviceDispatch& vkd = RendererContext::getInstance().pdevice->getDispatch();
+    if (statisticsSupported) {
+        vkd.vkCmdEndQuery(commandBuffer, statisticsQueryPool, currentFrame);
+    }
+    if (timestampsSupported) {
+        // Written once every previous command has completed
+        vkd.vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currentFrame * QUERIES_PER_FRAME + 1);
+    }
+}
+
+void Profiler::frameSubmitted(uint32_t currentFrame) {
+    pendingFrames[currentFrame] = true;
+    frameCount++;
+}
+
+void Profiler::collectFrame(uint32_t currentFrame) {
+    if (!pendingFrames[currentFrame]) {
+        return;
+    }
+    pendingFrames[currentFrame] = false;
+
+    // The fence of the frame was waited on, so the results are available: no need for VK_QUERY_RESULT_WAIT_BIT
+    auto pdevice = RendererContext::getInstance().pdevice;
+    double frameGpuTime = -1.0;
+    if (timestampsSupported) {
+        std::array<uint64_t, QUERIES_PER_FRAME> timestamps{};
+        VkResult result = pdevice->getDispatch().vkGetQueryPoolResults(pdevice->getLogicalDevice(), queryPool, currentFrame * QUERIES_PER_FRAME, QUERIES_PER_FRAME,
+            sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS) {
+            uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask;
+            frameGpuTime = ticks * timestampPeriod * 1e-9;
+            gpuTime += frameGpuTime;
+        }
+    }
+
+    if (statisticsSupported) {
+        std::array<uint64_t, STATISTICS_COUNT> statistics{};
+        VkResult result = pdevice->getDispatch().vkGetQueryPoolResults(pdevice->getLogicalDevice(), statisticsQueryPool, currentFrame, 1,
+            sizeof(statistics), statistics.data(), sizeof(statistics), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS) {
+            primitives += statistics[0];
+            fragmentInvocations += statistics[1];
+            statisticsFrameCount++;
+
+            // The throughput only counts the frames with both results, a frame missing one would skew the ratio
+            if (frameGpuTime >= 0.0) {
+                throughput.frameCount++;
+                throughput.gpuTime += frameGpuTime;
+                throughput.primitives += statistics[0];
+            }
+        }
+    }
+}
+
+void Profiler::update() {
+    if (PROFILER_REPORT_INTERVAL <= 0.0) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - intervalStart).count();
+    if (elapsed >= PROFILER_REPORT_INTERVAL) {
+        report();
+    }
+}
+
+void Profiler::report() {
+    auto now = std::chrono::steady_clock::now();
+    double cpuNow = getProcessCpuTime();
+    double elapsed = std::chrono::duration<double>(now - intervalStart).count();
+    if (elapsed <= 0.0) {
+        return;
+    }
+
+    std::cout << "Profiler: " << frameCount / elapsed << " frames/s, CPU " << 100.0 * (cpuNow - intervalCpuStart) / elapsed << "%";
+    if (timestampsSupported) {
+        std::cout << ", GPU " << 100.0 * gpuTime / elapsed << "%";
+    }
+    if (statisticsFrameCount > 0) {
+        std::cout << ", " << primitives / statisticsFrameCount << " primitives and " << fragmentInvocations / statisticsFrameCount << " fragment invocations per frame";
+        // Primitives per second of GPU time: compares how fast the same frames go through the GPU (see LodBenchmark)
+        double intervalGpuTime = throughput.gpuTime - intervalThroughputStart.gpuTime;
+        if (intervalGpuTime > 0.0) {
+            double intervalPrimitives = static_cast<double>(throughput.primitives - intervalThroughputStart.primitives);
+            std::cout << " (" << intervalPrimitives / intervalGpuTime * 1e-6 << " M primitives/s of GPU time)";
+        }
+    }
+    HostAllocator* phostAllocator = RendererContext::getInstance().phostallocator;
+    uint64_t hostAllocations = 0;
+    if (phostAllocator != nullptr) {
+        uint64_t liveBytes = 0;
+        for (const auto& scope : phostAllocator->getTotals()) {
+            hostAllocations += scope.allocations;
+            liveBytes += scope.liveBytes;
+        }
+        std::cout << ", driver " << hostAllocations - hostAllocationsStart << " host allocations (" << liveBytes / 1024 << " KiB live)";
+    }
+    std::cout << " over " << elapsed << " s" << std::endl;
+
+    intervalStart = now;
+    intervalCpuStart = cpuNow;
+    gpuTime = 0.0;
+    frameCount = 0;
+    statisticsFrameCount = 0;
+    primitives = 0;
+    fragmentInvocations = 0;
+    hostAllocationsStart = hostAllocations;
+    intervalThroughputStart = throughput;
+}
+
+bool Profiler::isThroughputSupported() const {
+    return timestampsSupported && statisticsSupported;
+}
+
+const Profiler::Throughput& Profiler::getThroughput() const {
+    return throughput;
+}
@@ -0,0 +1,51 @@
+#include "utils/StartupTimeline.h"
+
+#include <iomanip>
+
+void StartupTimeline::initialize() {
+    startTime = std::chrono::steady_clock::now();
+    mainThreadId = std::this_thread::get_id();
+    stages.clear();
+    complete = false;
+}
+
+size_t StartupTimeline::beginStage(const char* name) {
+    Stage stage;
+    stage.name = name;
+    stage.start = elapsedMilliseconds();
+    stage.mainThread = std::this_thread::get_id() == mainThreadId;
+
+    std::lock_guard<std::mutex> lock(stageMutex);
+    stages.push_back(stage);
+    return stages.size() - 1;
+}
+
+void StartupTimeline::endStage(size_t stage) {
+    double end = elapsedMilliseconds();
+
+    std::lock_guard<std::mutex> lock(stageMutex);
+    stages[stage].end = end;
+}
+
+// The stages are listed in start order, the ones that ran on a worker thread overlap the main thread stages next to them
+void StartupTimeline::firstFramePresented() {
+    if (complete) {
+        return;
+    }
+    complete = true;
+
+    double timeToFirstFrame = elapsedMilliseconds();
+
+    std::lock_guard<std::mutex> lock(stageMutex);
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Startup: first frame presented after " << timeToFirstFrame << " ms\n";
+    for (const auto& stage : stages) {
+        std::cout << "  " << std::setw(8) << stage.start << " ms  +" << std::setw(7) << stage.end - stage.start << " ms  "
+            << (stage.mainThread ? "main  " : "worker") << "  " << stage.name << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+double StartupTimeline::elapsedMilliseconds() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
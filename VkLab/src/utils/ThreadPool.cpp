@@ -0,0 +1,99 @@
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
+void ThreadPool::initialize(uint32_t workerCount) {
+    if (workerCount == 0) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency(); // 0 when unknown
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    stopping = false;
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    cleanup();
+}
+
+// Also called by the destructor, does nothing once the workers are joined
+void ThreadPool::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t minBatchSize, Job job, void* pcontext) {
+    minBatchSize = std::max(minBatchSize, 1u);
+    if (workers.empty() || count <= minBatchSize) {
+        job(pcontext, 0, count);
+        return;
+    }
+
+    uint32_t threadCount = static_cast<uint32_t>(workers.size()) + 1; // The calling thread works too
+    uint32_t batchSize = std::max(minBatchSize, (count + threadCount - 1) / threadCount);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // A worker woken late by the previous job may still be running out of batches
+        idleCondition.wait(lock, [this] { return busyWorkers == 0; });
+
+        this->job = job;
+        this->pcontext = pcontext;
+        this->count = count;
+        this->batchSize = batchSize;
+        batchCount = (count + batchSize - 1) / batchSize;
+        nextBatch.store(0, std::memory_order_relaxed);
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    runBatches();
+
+    // Every batch was taken, wait for the ones still running on the workers
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+uint32_t ThreadPool::getWorkerCount() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        busyWorkers++;
+        lock.unlock();
+
+        runBatches();
+
+        lock.lock();
+        if (--busyWorkers == 0) {
+            idleCondition.notify_all();
+        }
+    }
+}
+
+void ThreadPool::runBatches() {
+    for (uint32_t batch = nextBatch.fetch_add(1); batch < batchCount; batch = nextBatch.fetch_add(1)) {
+        uint32_t begin = batch * batchSize;
+        job(pcontext, begin, std::min(begin + batchSize, count));
+    }
+}
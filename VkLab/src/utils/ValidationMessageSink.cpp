@@ -0,0 +1,241 @@
+#include "utils/ValidationMessageSink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Copies a C string, truncating it to the destination size
+    void copyString(char* destination, size_t size, const char* source) {
+        if (source == nullptr) {
+            destination[0] = '\0';
+            return;
+        }
+        size_t length = std::min(std::strlen(source), size - 1);
+        std::memcpy(destination, source, length);
+        destination[length] = '\0';
+    }
+
+    uint64_t nowMilliseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+        if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+            return "error";
+        }
+        if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+            return "warning";
+        }
+        return "info";
+    }
+}
+
+// A joinable std::thread must not be destroyed, it would call std::terminate
+ValidationMessageSink::~ValidationMessageSink() {
+    stop();
+}
+
+// Everything the consumer needs is allocated here, before the first message
+void ValidationMessageSink::start() {
+    slots = std::make_unique<Slot[]>(VALIDATION_SINK_CAPACITY);
+    for (uint32_t i = 0; i < VALIDATION_SINK_CAPACITY; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePosition.store(0, std::memory_order_relaxed);
+    dequeuePosition = 0;
+
+    idStats = std::make_unique<IdStats[]>(MAX_VALIDATION_MESSAGE_IDS);
+    idCount = 0;
+
+    running.store(true, std::memory_order_release);
+    consumer = std::thread(&ValidationMessageSink::run, this);
+}
+
+void ValidationMessageSink::stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    consumer.join(); // The consumer drains what is left before returning
+
+    printSummary();
+    slots.reset();
+    idStats.reset();
+}
+
+// Bounded MPMC queue of D. Vyukov, used with a single consumer: a producer claims a position with a CAS,
+// fills the slot, then publishes it by advancing the slot sequence
+bool ValidationMessageSink::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData) {
+    uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots[position & (VALIDATION_SINK_CAPACITY - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (difference < 0) {
+            // The consumer is a whole ring behind: drop rather than block the Vulkan call
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            position = enqueuePosition.load(std::memory_order_relaxed); // Another producer took this position
+        }
+    }
+
+    Message& message = slot->message;
+    message.idNumber = pCallbackData->messageIdNumber;
+    message.severity = severity;
+    message.type = type;
+    copyString(message.idName, ID_NAME_SIZE, pCallbackData->pMessageIdName);
+    copyString(message.text, TEXT_SIZE, pCallbackData->pMessage);
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool ValidationMessageSink::pop(Message& message) {
+    Slot& slot = slots[dequeuePosition & (VALIDATION_SINK_CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+        return false; // Empty, or the producer of this position is still writing
+    }
+
+    message = slot.message;
+    slot.sequence.store(dequeuePosition + VALIDATION_SINK_CAPACITY, std::memory_order_release); // Free for the next round
+    dequeuePosition++;
+    return true;
+}
+
+// The producers never wake the consumer up (that would cost a system call in the driver call), it polls instead
+void ValidationMessageSink::run() {
+    Message message;
+    while (running.load(std::memory_order_acquire)) {
+        bool drained = true;
+        while (pop(message)) {
+            handle(message);
+            drained = false;
+        }
+        if (drained) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        }
+    }
+
+    while (pop(message)) {
+        handle(message);
+    }
+}
+
+void ValidationMessageSink::handle(const Message& message) {
+    messageCount++;
+
+    IdStats* pstats = findStats(message);
+    if (pstats != nullptr) {
+        pstats->count++;
+        if (pstats->printed >= VALIDATION_MESSAGES_PER_ID) {
+            return; // Duplicate, only counted
+        }
+    }
+
+    if (!takeRateLimitToken()) {
+        rateLimitedCount++;
+        return;
+    }
+
+    std::cerr << "[Validation Layer]:[" << message.type << "]: " << message.text << '\n';
+    printedCount++;
+    if (pstats != nullptr && ++pstats->printed == VALIDATION_MESSAGES_PER_ID) {
+        std::cerr << "[Validation Layer]: further " << (message.idName[0] ? message.idName : message.idNumber != 0 ? "messages with the same id" : "identical") << " messages are only counted\n";
+    }
+}
+
+// The id number when there is one. Layers and the loader send many unrelated messages with the id number 0, those are
+// keyed by a hash of their id name, or of their text without one, with the top bit set so that no id number matches it
+uint64_t ValidationMessageSink::getMessageKey(const Message& message) {
+    if (message.idNumber != 0) {
+        return static_cast<uint32_t>(message.idNumber);
+    }
+
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char* pc = message.idName[0] ? message.idName : message.text; *pc != '\0'; pc++) {
+        hash = (hash ^ static_cast<uint8_t>(*pc)) * 0x100000001b3ull;
+    }
+    return hash | (1ull << 63);
+}
+
+// Linear probing in a fixed table, the messages of a full table are printed but not deduped
+ValidationMessageSink::IdStats* ValidationMessageSink::findStats(const Message& message) {
+    uint64_t key = getMessageKey(message);
+    uint32_t index = static_cast<uint32_t>((key ^ (key >> 32)) * 2654435761u % MAX_VALIDATION_MESSAGE_IDS);
+    for (uint32_t probe = 0; probe < MAX_VALIDATION_MESSAGE_IDS; probe++) {
+        IdStats& stats = idStats[index];
+        if (!stats.used) {
+            if (idCount == MAX_VALIDATION_MESSAGE_IDS - 1) {
+                break; // Keep a free slot so the probing always ends
+            }
+            stats.used = true;
+            stats.key = key;
+            stats.idNumber = message.idNumber;
+            stats.severity = message.severity;
+            // The summary names a message without id name by the start of its text
+            copyString(stats.idName, ID_NAME_SIZE, message.idName[0] || message.idNumber != 0 ? message.idName : message.text);
+            idCount++;
+            return &stats;
+        }
+        if (stats.key == key) {
+            return &stats;
+        }
+        index = (index + 1) % MAX_VALIDATION_MESSAGE_IDS;
+    }
+
+    untrackedCount++;
+    return nullptr;
+}
+
+// At most VALIDATION_LINES_PER_SECOND lines in every one second window
+bool ValidationMessageSink::takeRateLimitToken() {
+    uint64_t now = nowMilliseconds();
+    if (now - rateWindowStart >= 1000) {
+        rateWindowStart = now;
+        rateWindowLines = 0;
+    }
+    if (rateWindowLines >= VALIDATION_LINES_PER_SECOND) {
+        return false;
+    }
+    rateWindowLines++;
+    return true;
+}
+
+void ValidationMessageSink::printSummary() {
+    uint64_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (messageCount == 0 && dropped == 0) {
+        return;
+    }
+
+    std::cerr << "Validation messages: " << messageCount << " received, " << printedCount << " printed, "
+        << rateLimitedCount << " rate limited, " << dropped << " dropped (ring full)";
+    if (untrackedCount > 0) {
+        std::cerr << ", " << untrackedCount << " with untracked ids";
+    }
+    std::cerr << '\n';
+
+    // Most frequent ids first
+    std::vector<const IdStats*> sorted;
+    for (uint32_t i = 0; i < MAX_VALIDATION_MESSAGE_IDS; i++) {
+        if (idStats[i].used) {
+            sorted.push_back(&idStats[i]);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const IdStats* a, const IdStats* b) { return a->count > b->count; });
+
+    for (const IdStats* pstats : sorted) {
+        std::cerr << "  " << pstats->count << " x " << severityName(pstats->severity) << " "
+            << (pstats->idName[0] ? pstats->idName : "(no id name)") << " [" << pstats->idNumber << "]\n";
+    }
+}